@@ -0,0 +1,624 @@
+#include <iostream>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#elif defined(_M_X64) || defined(_M_IX86)
+#include <intrin.h>
+#endif
+
+#include "tonegen/additive.h"
+#include "tonegen/convert.h"
+#include "tonegen/cpu.h"
+#include "tonegen/tone_generator.h"
+
+// Times every oscillator, noise color, output format and conversion kernel, next to the scalar
+// generate_wave the frontends used before the engine and a per-sample switch conversion, so a
+// change can be checked for speed. The additive suite sums 1 to 1024 partials with each
+// strategy and prints the cost per partial and where the IFFT overtakes the recursive kernel.
+//   tone_bench [--filter TEXT] [--isa NAME|all] [--min-time S] [--json FILE]
+// Each case renders one block size over and over for --min-time seconds (default 0.05) split
+// into five runs, and reports the fastest run as ns/sample, samples/s and CPU cycles/sample,
+// counting every channel's sample. --filter keeps the cases whose name contains TEXT, --isa all
+// repeats the engine cases on every ISA the host supports, and --json writes the results and the
+// machine they ran on (- for stdout) so runs can be diffed across commits and CPUs.
+// Cycles come from the kernel's core cycle counter where perf events are allowed, or else the
+// time stamp counter, which ticks at a fixed rate whatever the core clock.
+
+namespace {
+
+const int SAMPLE_RATE = 48000;
+const size_t BLOCK_SIZES[] = {64, 256, 1024, 4096};
+const size_t CHANNEL_COUNTS[] = {1, 2, 8};
+const int RUNS = 5;
+const size_t ADDITIVE_PARTIALS[] = {1, 4, 16, 64, 128, 256, 384, 512, 768, 1024};
+const size_t ADDITIVE_BLOCK = 1024;
+const char* const FORMAT_NAMES[tonegen::SAMPLE_FORMAT_COUNT] = {"u8", "s16", "s32", "f32"};
+
+// What the engine replaced, kept as it was so there is a fixed baseline to beat: the
+// generate_wave bineural/main.cpp played before the engine (a static random engine, pink
+// reading the sample before it round the buffer, binaural as the mean of its two tones)
+namespace legacy {
+
+enum WaveType { SINE, SQUARE, WHITE_NOISE, PINK_NOISE, BINAURAL_BEATS };
+
+const int SAMPLE_RATE = 44100;
+const int AMPLITUDE = 32760;
+
+void generate_wave(int16_t* buffer, WaveType waveType, int length, int frequency, int& phase, int frequency2) {
+    static std::random_device rd;
+    static std::mt19937 gen(rd());
+    static std::uniform_int_distribution<> dis(-AMPLITUDE, AMPLITUDE);
+
+    for (int i = 0; i < length; ++i) {
+        float time = static_cast<float>(phase + i) / SAMPLE_RATE;
+        switch (waveType) {
+            case SINE:
+                buffer[i] = static_cast<int16_t>(AMPLITUDE * std::sin(2.0f * M_PI * frequency * time));
+                break;
+            case SQUARE:
+                buffer[i] = ((phase + i) % (SAMPLE_RATE / frequency) < (SAMPLE_RATE / frequency / 2)) ? AMPLITUDE : -AMPLITUDE;
+                break;
+            case WHITE_NOISE:
+                buffer[i] = dis(gen);
+                break;
+            case PINK_NOISE:
+                buffer[i] = dis(gen) / 2 + buffer[(i - 1 + length) % length] / 2;
+                break;
+            case BINAURAL_BEATS:
+                buffer[i] = static_cast<int16_t>(AMPLITUDE * std::sin(2.0f * M_PI * frequency * time));
+                buffer[i] += static_cast<int16_t>(AMPLITUDE * std::sin(2.0f * M_PI * frequency2 * time));
+                buffer[i] /= 2;
+                break;
+        }
+    }
+    phase += length;
+}
+
+// Float to device format with the switch inside the sample loop, the shape convert_samples
+// replaced with one kernel per format picked once per call
+void convert_samples(const float* in, void* out, tonegen::SampleFormat format, size_t samples) {
+    for (size_t i = 0; i < samples; ++i) {
+        const float x = std::min(std::max(in[i], -1.0f), 1.0f);
+        switch (format) {
+            case tonegen::SAMPLE_UINT8:
+                static_cast<uint8_t*>(out)[i] = static_cast<uint8_t>(std::lrint(x * 127.5f + 127.5f));
+                break;
+            case tonegen::SAMPLE_INT16:
+                static_cast<int16_t*>(out)[i] = static_cast<int16_t>(std::lrint(x * 32767.0f));
+                break;
+            case tonegen::SAMPLE_INT32:
+                static_cast<int32_t*>(out)[i] =
+                    static_cast<int32_t>(std::min(std::lrint(x * 2147483648.0), 2147483647L));
+                break;
+            case tonegen::SAMPLE_FLOAT:
+                static_cast<float*>(out)[i] = x;
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+} // namespace legacy
+
+// Core cycles from perf events, or time stamp counter ticks, or nothing
+class CycleCounter {
+public:
+    CycleCounter() : m_fd(-1) {
+#ifdef __linux__
+        perf_event_attr attributes;
+        std::memset(&attributes, 0, sizeof(attributes));
+        attributes.size = sizeof(attributes);
+        attributes.type = PERF_TYPE_HARDWARE;
+        attributes.config = PERF_COUNT_HW_CPU_CYCLES;
+        attributes.exclude_kernel = 1;
+        attributes.exclude_hv = 1;
+        m_fd = static_cast<int>(syscall(SYS_perf_event_open, &attributes, 0, -1, -1, 0));
+        if (m_fd >= 0) {
+            ioctl(m_fd, PERF_EVENT_IOC_ENABLE, 0);
+        }
+#endif
+    }
+    ~CycleCounter() {
+#ifdef __linux__
+        if (m_fd >= 0) {
+            close(m_fd);
+        }
+#endif
+    }
+
+    CycleCounter(const CycleCounter&) = delete;
+    CycleCounter& operator=(const CycleCounter&) = delete;
+
+    const char* source() const {
+        if (m_fd >= 0) {
+            return "perf";
+        }
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+        return "tsc";
+#else
+        return "none";
+#endif
+    }
+    bool available() const { return std::strcmp(source(), "none") != 0; }
+
+    uint64_t read() const {
+#ifdef __linux__
+        uint64_t count = 0;
+        if (m_fd >= 0 && ::read(m_fd, &count, sizeof(count)) == sizeof(count)) {
+            return count;
+        }
+#endif
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+        return __rdtsc();
+#else
+        return 0;
+#endif
+    }
+
+private:
+    int m_fd;
+};
+
+struct Case {
+    std::string suite;
+    std::string name;
+    std::string isa;
+    size_t channels;
+    size_t block; // Frames per call
+    const char* format;
+    std::function<void()> run; // Renders one block
+    size_t partials = 0;       // Sinusoids summed per sample, for the additive suite
+};
+
+struct Result {
+    double nsPerSample;
+    double samplesPerSecond;
+    double cyclesPerSample; // Negative without a cycle counter
+};
+
+// Calibrates the calls per run so RUNS runs fill minTime, then keeps the fastest run
+Result measure(const Case& c, const CycleCounter& counter, double minTime) {
+    typedef std::chrono::steady_clock Clock;
+    c.run(); // Warm up caches and any lazy setup
+    uint64_t calls = 1;
+    for (;;) {
+        const auto start = Clock::now();
+        for (uint64_t i = 0; i < calls; ++i) {
+            c.run();
+        }
+        const double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+        if (elapsed >= minTime / RUNS / 4 || calls >= (uint64_t(1) << 40)) {
+            calls = std::max<uint64_t>(1, static_cast<uint64_t>(calls * (minTime / RUNS) / std::max(elapsed, 1e-9)));
+            break;
+        }
+        calls *= 4;
+    }
+
+    const double samples = static_cast<double>(calls * c.block * c.channels);
+    Result best = {1e300, 0, -1};
+    for (int run = 0; run < RUNS; ++run) {
+        const uint64_t cycles = counter.read();
+        const auto start = Clock::now();
+        for (uint64_t i = 0; i < calls; ++i) {
+            c.run();
+        }
+        const double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+        const uint64_t spent = counter.read() - cycles;
+        const double ns = 1e9 * elapsed / samples;
+        if (ns < best.nsPerSample) {
+            best.nsPerSample = ns;
+            best.cyclesPerSample = counter.available() ? spent / samples : -1;
+        }
+    }
+    best.samplesPerSecond = 1e9 / best.nsPerSample;
+    return best;
+}
+
+// Keeps the compiler from dropping renders nobody reads
+volatile float g_sink;
+
+struct Buffers {
+    std::vector<float> floats;
+    std::vector<float> samples; // A steady input for the conversion cases, which nothing renders over
+    std::vector<uint8_t> bytes;
+    std::vector<int16_t> legacy;
+
+    Buffers()
+        : floats(4096 * tonegen::MAX_CHANNELS), samples(4096 * tonegen::MAX_CHANNELS),
+          bytes(4096 * tonegen::MAX_CHANNELS * sizeof(float)), legacy(4096) {
+        for (size_t i = 0; i < samples.size(); ++i) {
+            samples[i] = 0.9f * std::sin(0.01f * static_cast<float>(i));
+        }
+    }
+};
+
+void add_legacy_cases(std::vector<Case>& cases, Buffers& buffers) {
+    static const struct {
+        const char* name;
+        legacy::WaveType wave;
+    } WAVES[] = {{"sine", legacy::SINE},
+                 {"square", legacy::SQUARE},
+                 {"white", legacy::WHITE_NOISE},
+                 {"pink", legacy::PINK_NOISE},
+                 {"binaural", legacy::BINAURAL_BEATS}};
+    static int phase = 0;
+    for (const auto& wave : WAVES) {
+        for (size_t block : BLOCK_SIZES) {
+            const legacy::WaveType type = wave.wave;
+            int16_t* out = buffers.legacy.data();
+            const int length = static_cast<int>(block);
+            cases.push_back({"legacy", wave.name, "scalar", 1, block, "s16", [=]() {
+                                 legacy::generate_wave(out, type, length, 440, phase, 444);
+                                 if (phase > legacy::SAMPLE_RATE * 3600) {
+                                     phase = 0;
+                                 }
+                                 g_sink = out[0];
+                             }});
+        }
+    }
+
+    // The per-sample switch over the format, against the convert suite's kernels
+    const float* samples = buffers.samples.data();
+    uint8_t* bytes = buffers.bytes.data();
+    for (int format = 0; format < tonegen::SAMPLE_FORMAT_COUNT; ++format) {
+        const tonegen::SampleFormat type = static_cast<tonegen::SampleFormat>(format);
+        for (size_t channels : CHANNEL_COUNTS) {
+            for (size_t block : BLOCK_SIZES) {
+                cases.push_back({"legacy", "convert-switch", "scalar", channels, block, FORMAT_NAMES[format], [=]() {
+                                     legacy::convert_samples(samples, bytes, type, block * channels);
+                                     g_sink = bytes[0];
+                                 }});
+            }
+        }
+    }
+}
+
+void add_engine_cases(std::vector<Case>& cases, Buffers& buffers, const std::string& isa) {
+    static const struct {
+        const char* name;
+        tonegen::WaveType wave;
+        tonegen::SineAccuracy accuracy;
+    } WAVES[] = {{"sine", tonegen::SINE, tonegen::SINE_BALANCED},
+                 {"sine-fast", tonegen::SINE, tonegen::SINE_FAST},
+                 {"sine-precise", tonegen::SINE, tonegen::SINE_PRECISE},
+                 {"square", tonegen::SQUARE, tonegen::SINE_BALANCED},
+                 {"saw", tonegen::SAW, tonegen::SINE_BALANCED},
+                 {"triangle", tonegen::TRIANGLE, tonegen::SINE_BALANCED},
+                 {"pulse", tonegen::PULSE, tonegen::SINE_BALANCED},
+                 {"binaural", tonegen::BINAURAL_BEATS, tonegen::SINE_BALANCED},
+                 {"wavetable", tonegen::WAVETABLE, tonegen::SINE_BALANCED},
+                 {"additive", tonegen::ADDITIVE, tonegen::SINE_BALANCED},
+                 {"white", tonegen::WHITE_NOISE, tonegen::SINE_BALANCED},
+                 {"pink", tonegen::PINK_NOISE, tonegen::SINE_BALANCED},
+                 {"brown", tonegen::BROWN_NOISE, tonegen::SINE_BALANCED},
+                 {"blue", tonegen::BLUE_NOISE, tonegen::SINE_BALANCED},
+                 {"violet", tonegen::VIOLET_NOISE, tonegen::SINE_BALANCED}};
+
+    tonegen::Partial partials[16];
+    for (size_t i = 0; i < 16; ++i) {
+        partials[i].ratio = static_cast<double>(i + 1);
+        partials[i].amplitude = 1.0f / static_cast<float>(i + 1);
+    }
+
+    float* floats = buffers.floats.data();
+    uint8_t* bytes = buffers.bytes.data();
+    for (const auto& wave : WAVES) {
+        for (size_t channels : CHANNEL_COUNTS) {
+            // One generator per wave and channel count, shared by the block sizes
+            auto generator = std::make_shared<tonegen::ToneGenerator>(SAMPLE_RATE, channels);
+            tonegen::ToneParams params;
+            params.waveType = wave.wave;
+            params.sineAccuracy = wave.accuracy;
+            params.frequency = 440;
+            params.beatFrequency = 4;
+            params.channelPhase = 0.25;
+            params.pulseWidth = 0.25f;
+            params.amplitude = 0.5f;
+            generator->setParams(params);
+            generator->setWavetable(tonegen::Wavetable::builtin(tonegen::WAVETABLE_SAW));
+            generator->setPartials(partials, 16);
+            generator->reset();
+            for (size_t block : BLOCK_SIZES) {
+                cases.push_back({"wave", wave.name, isa, channels, block, "f32", [=]() {
+                                     generator->process(floats, block);
+                                     g_sink = floats[0];
+                                 }});
+            }
+        }
+    }
+
+    // One additive oscillator per strategy and partial count, so the cost per partial and the
+    // count where the IFFT overtakes the recursive kernel can be read off (see main)
+    for (size_t count : ADDITIVE_PARTIALS) {
+        for (tonegen::AdditiveStrategy strategy : {tonegen::ADDITIVE_RECURSIVE, tonegen::ADDITIVE_IFFT}) {
+            std::vector<tonegen::Partial> spectrum(count);
+            for (size_t i = 0; i < count; ++i) {
+                // Inharmonic and low enough that every partial stays under Nyquist
+                spectrum[i].ratio = 1 + 0.37 * static_cast<double>(i);
+                spectrum[i].amplitude = 1.0f / static_cast<float>(count);
+            }
+            auto oscillator = std::make_shared<tonegen::AdditiveOscillator>(SAMPLE_RATE);
+            oscillator->setPartials(spectrum.data(), count);
+            oscillator->setFrequency(50);
+            oscillator->setStrategy(strategy);
+            oscillator->reset();
+            const std::string name = std::string(strategy == tonegen::ADDITIVE_IFFT ? "ifft" : "recursive") +
+                                     "-" + std::to_string(count);
+            cases.push_back({"additive", name, isa, 1, ADDITIVE_BLOCK, "f32",
+                             [=]() {
+                                 oscillator->process(floats, ADDITIVE_BLOCK);
+                                 g_sink = floats[0];
+                             },
+                             count});
+        }
+    }
+
+    // The whole device path: render, then convert into each format, dithered where it applies
+    for (int format = 0; format < tonegen::SAMPLE_FORMAT_COUNT; ++format) {
+        for (int dither = 0; dither < 2; ++dither) {
+            const bool dithers = format == tonegen::SAMPLE_UINT8 || format == tonegen::SAMPLE_INT16;
+            if (dither && !dithers) {
+                continue;
+            }
+            for (size_t channels : CHANNEL_COUNTS) {
+                auto generator = std::make_shared<tonegen::ToneGenerator>(SAMPLE_RATE, channels);
+                tonegen::ToneParams params;
+                params.amplitude = 0.5f;
+                generator->setParams(params);
+                generator->setDither(dither != 0);
+                generator->reset();
+                const tonegen::SampleFormat type = static_cast<tonegen::SampleFormat>(format);
+                for (size_t block : BLOCK_SIZES) {
+                    cases.push_back({"format", dither ? "sine-dither" : "sine", isa, channels, block,
+                                     FORMAT_NAMES[format], [=]() {
+                                         generator->process(bytes, type, block);
+                                         g_sink = bytes[0];
+                                     }});
+                }
+            }
+        }
+    }
+
+    // The conversion kernels alone, from a block already rendered
+    const float* samples = buffers.samples.data();
+    auto dither = std::make_shared<tonegen::Dither>();
+    dither->enabled = true;
+    for (int format = 0; format < tonegen::SAMPLE_FORMAT_COUNT; ++format) {
+        const tonegen::SampleFormat type = static_cast<tonegen::SampleFormat>(format);
+        for (size_t channels : CHANNEL_COUNTS) {
+            for (size_t block : BLOCK_SIZES) {
+                cases.push_back({"convert", "samples", isa, channels, block, FORMAT_NAMES[format], [=]() {
+                                     tonegen::convert_samples(samples, bytes, type, block * channels);
+                                     g_sink = bytes[0];
+                                 }});
+                if (type == tonegen::SAMPLE_UINT8 || type == tonegen::SAMPLE_INT16) {
+                    cases.push_back({"convert", "samples-dither", isa, channels, block, FORMAT_NAMES[format], [=]() {
+                                         tonegen::convert_samples(samples, bytes, type, block * channels, dither.get());
+                                         g_sink = bytes[0];
+                                     }});
+                }
+                if (channels > 1) {
+                    cases.push_back({"convert", "mono-to-interleaved", isa, channels, block, FORMAT_NAMES[format], [=]() {
+                                         tonegen::convert_mono_to_interleaved(samples, bytes, type, block,
+                                                                              static_cast<int>(channels));
+                                         g_sink = bytes[0];
+                                     }});
+                }
+            }
+        }
+    }
+}
+
+std::string json_string(const std::string& text) {
+    std::string quoted = "\"";
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            quoted += '\\';
+            quoted += c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            char escaped[8];
+            std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+            quoted += escaped;
+        } else {
+            quoted += c;
+        }
+    }
+    return quoted + "\"";
+}
+
+std::string cpu_model() {
+    std::ifstream cpuinfo("/proc/cpuinfo");
+    std::string line;
+    while (std::getline(cpuinfo, line)) {
+        if (line.compare(0, 10, "model name") == 0 || line.compare(0, 9, "Processor") == 0) {
+            const size_t colon = line.find(':');
+            if (colon != std::string::npos) {
+                return line.substr(line.find_first_not_of(" \t", colon + 1));
+            }
+        }
+    }
+    return "unknown";
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    std::string filter;
+    std::string isaName;
+    std::string jsonPath;
+    double minTime = 0.05;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--filter" && i + 1 < argc) {
+            filter = argv[++i];
+        } else if (arg == "--isa" && i + 1 < argc) {
+            isaName = argv[++i];
+        } else if (arg == "--min-time" && i + 1 < argc) {
+            minTime = std::max(std::atof(argv[++i]), 0.001);
+        } else if (arg == "--json" && i + 1 < argc) {
+            jsonPath = argv[++i];
+        } else {
+            std::cerr << "Usage: tone_bench [--filter TEXT] [--isa NAME|all] [--min-time S] [--json FILE]" << std::endl;
+            return 1;
+        }
+    }
+
+    std::vector<tonegen::CpuIsa> isas;
+    for (int isa = 0; isa < tonegen::ISA_COUNT; ++isa) {
+        const tonegen::CpuIsa candidate = static_cast<tonegen::CpuIsa>(isa);
+        if (isaName == "all" ? tonegen::isa_supported(candidate) : isaName == tonegen::isa_name(candidate)) {
+            isas.push_back(candidate);
+        }
+    }
+    if (isaName.empty()) {
+        isas.push_back(tonegen::active_isa());
+    } else if (isas.empty() || !tonegen::isa_supported(isas.front())) {
+        std::cerr << "This host can't run ISA " << isaName << std::endl;
+        return 1;
+    }
+
+    Buffers buffers;
+    CycleCounter counter;
+    std::vector<Case> cases;
+    add_legacy_cases(cases, buffers);
+    const size_t legacyCases = cases.size();
+    for (tonegen::CpuIsa isa : isas) {
+        add_engine_cases(cases, buffers, tonegen::isa_name(isa));
+    }
+
+    // Text goes to stderr when the JSON takes stdout
+    FILE* text = jsonPath == "-" ? stderr : stdout;
+    std::fprintf(text, "%-36s %-7s %3s %5s %4s %12s %12s %14s\n", "case", "isa", "ch", "block", "fmt", "ns/sample",
+                 "Msamples/s", "cycles/sample");
+    std::vector<std::pair<const Case*, Result>> results;
+    for (size_t i = 0; i < cases.size(); ++i) {
+        const Case& c = cases[i];
+        const std::string label = c.suite + "/" + c.name;
+        if (!filter.empty() && label.find(filter) == std::string::npos) {
+            continue;
+        }
+        if (i >= legacyCases) {
+            for (tonegen::CpuIsa isa : isas) {
+                if (c.isa == tonegen::isa_name(isa)) {
+                    tonegen::set_active_isa(isa);
+                }
+            }
+        }
+        const Result result = measure(c, counter, minTime);
+        results.push_back({&c, result});
+        char cycles[32] = "-";
+        if (result.cyclesPerSample >= 0) {
+            std::snprintf(cycles, sizeof(cycles), "%.2f", result.cyclesPerSample);
+        }
+        std::fprintf(text, "%-36s %-7s %3zu %5zu %4s %12.3f %12.1f %14s\n", label.c_str(), c.isa.c_str(), c.channels,
+                     c.block, c.format, result.nsPerSample, result.samplesPerSecond / 1e6, cycles);
+        std::fflush(text);
+    }
+
+    // Additive cost per partial, and the partial count from which the IFFT is faster here,
+    // against the one ADDITIVE_AUTO switches at
+    for (tonegen::CpuIsa isa : isas) {
+        tonegen::set_active_isa(isa);
+        size_t crossover = 0;
+        bool measured = false;
+        for (size_t count : ADDITIVE_PARTIALS) {
+            double ns[2] = {-1, -1};
+            for (const auto& r : results) {
+                const Case& c = *r.first;
+                if (c.suite == "additive" && c.isa == tonegen::isa_name(isa) && c.partials == count) {
+                    ns[c.name.compare(0, 4, "ifft") == 0] = r.second.nsPerSample / static_cast<double>(count);
+                }
+            }
+            if (ns[0] < 0 || ns[1] < 0) {
+                continue;
+            }
+            if (!measured) {
+                std::fprintf(text, "\nadditive/%s ns per partial per sample:\n", tonegen::isa_name(isa));
+                measured = true;
+            }
+            std::fprintf(text, "  %5zu partials   recursive %9.4f   ifft %9.4f\n", count, ns[0], ns[1]);
+            if (crossover == 0 && ns[1] < ns[0]) {
+                crossover = count;
+            }
+        }
+        if (measured) {
+            char from[48] = "never in range";
+            if (crossover > 0) {
+                std::snprintf(from, sizeof(from), "from %zu partials", crossover);
+            }
+            std::fprintf(text, "  IFFT faster %s; ADDITIVE_AUTO switches at %zu\n", from,
+                         tonegen::additive_ifft_threshold());
+        }
+    }
+
+    if (jsonPath.empty()) {
+        return 0;
+    }
+    std::ofstream file;
+    if (jsonPath != "-") {
+        file.open(jsonPath);
+        if (!file) {
+            std::cerr << "Can't write " << jsonPath << std::endl;
+            return 1;
+        }
+    }
+    std::ostream& json = jsonPath == "-" ? std::cout : file;
+    char date[32] = "";
+    const std::time_t now = std::time(nullptr);
+    std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&now));
+#ifdef __VERSION__
+    const std::string compiler = __VERSION__;
+#else
+    const std::string compiler = "unknown";
+#endif
+    json << "{\n  \"tool\": \"tone_bench\",\n  \"date\": " << json_string(date)
+         << ",\n  \"cpu\": " << json_string(cpu_model())
+         << ",\n  \"detectedIsa\": " << json_string(tonegen::isa_name(tonegen::detect_isa()))
+         << ",\n  \"compiler\": " << json_string(compiler)
+         << ",\n  \"cycleCounter\": " << json_string(counter.source())
+         << ",\n  \"sampleRate\": " << SAMPLE_RATE << ",\n  \"minTime\": " << minTime
+         << ",\n  \"results\": [";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const Case& c = *results[i].first;
+        const Result& r = results[i].second;
+        char numbers[160];
+        std::snprintf(numbers, sizeof(numbers), "\"nsPerSample\": %.4f, \"samplesPerSecond\": %.0f, \"cyclesPerSample\": ",
+                      r.nsPerSample, r.samplesPerSecond);
+        json << (i ? ",\n" : "\n") << "    {\"suite\": " << json_string(c.suite) << ", \"name\": " << json_string(c.name)
+             << ", \"isa\": " << json_string(c.isa) << ", \"channels\": " << c.channels << ", \"block\": " << c.block
+             << ", \"format\": " << json_string(c.format) << ", ";
+        if (c.partials > 0) {
+            json << "\"partials\": " << c.partials << ", ";
+        }
+        json << numbers;
+        if (r.cyclesPerSample >= 0) {
+            char cycles[32];
+            std::snprintf(cycles, sizeof(cycles), "%.3f", r.cyclesPerSample);
+            json << cycles << "}";
+        } else {
+            json << "null}";
+        }
+    }
+    json << "\n  ]\n}\n";
+    return json ? 0 : 1;
+}
@@ -2,6 +2,8 @@
 #include <QWidget>
 #include <QPushButton>
 #include <QComboBox>
+#include <QCheckBox>
+#include <QSpinBox>
 #include <QLineEdit>
 #include <QVBoxLayout>
 #include <QTimer>
@@ -9,11 +11,15 @@
 #include <QtCharts/QLineSeries>
 #include <AL/al.h>
 #include <AL/alc.h>
-#include <random>
 #include <QLabel>
+#include <cmath>
+#include <memory>
+#include <vector>
+
+#include "tonegen/openal_stream.h"
 //QT_CHARTS_USE_NAMESPACE
 
-enum WaveType { SINE, SQUARE, WHITE_NOISE, PINK_NOISE, BINAURAL_BEATS };
+using tonegen::WaveType;
 
 class ToneGeneratorWidget : public QWidget {
     Q_OBJECT
@@ -25,19 +31,21 @@ public:
 private slots:
     void onPlayButtonClicked();
     void onStopButtonClicked();
-    void onAudioTimerTimeout();
     void onChartTimerTimeout();
     void onFrequencyChanged();
     void onBeatFrequencyChanged();
     void onWaveTypeChanged(int index);
     void onPresetFrequencyChanged(int index);
+    void onFilterChanged(int index);
+    void onModulationChanged(int index);
+    void onLowLatencyToggled(bool checked);
+    void onPeriodChanged();
 
 private:
-    void generate_wave(int16_t* buffer, WaveType waveType, int length, int frequency, int& phase, int frequency2);
-    void play_wave(ALuint* buffers, ALuint source, WaveType waveType, int frequency, int& phase, int frequency2);
-    void update_buffers(ALuint* buffers, ALuint source, WaveType waveType, int frequency, int& phase, int frequency2);
-    void stop_wave(ALuint* buffers, ALuint source);
+    void apply_params();
     void update_chart();
+    void open_stream();
+    void show_latency();
 
     QPushButton* playButton;
     QPushButton* stopButton;
@@ -45,52 +53,88 @@ private:
     QLineEdit* frequencyInput;
     QLineEdit* beatFrequencyInput;
     QComboBox* presetFrequenciesComboBox;
-    QTimer* audioTimer;
+    QComboBox* filterComboBox;
+    QComboBox* modulationComboBox;
+    QCheckBox* lowLatencyCheckBox;
+    QSpinBox* periodSpinBox;
+    QSpinBox* periodCountSpinBox;
+    QLabel* latencyLabel;
     QTimer* chartTimer;
     QChartView* chartView;
     QLineSeries* series;
+    QVector<QPointF> chartPoints; // Reused; only redrawn when chartFrequency goes stale
+    double chartFrequency;
 
     WaveType currentWave;
     bool playing;
-    int frequency;
-    int beatFrequency;
-    int frequency2;
-    int phase;
+    double frequency;
+    double beatFrequency;
+    double frequency2;
+    tonegen::ToneGenerator generator;
 
-    ALuint buffers[4];
-    ALuint source;
+    // Refills OpenAL from its own thread, or from the OpenAL mixer, so GUI stalls can't starve it
+    std::unique_ptr<tonegen::OpenAlStream> stream;
     ALCdevice* device;
     ALCcontext* context;
 
     static const int SAMPLE_RATE = 44100;
-    static const int AMPLITUDE = 32760;
     static const int BUFFER_SIZE = SAMPLE_RATE / 2; // Larger buffer size for smoother playback
+    static const int NUM_BUFFERS = 4;
+    static const int LOW_LATENCY_BUFFER_SIZE = 128; // Periods for the low-latency mode, about 9 ms queued
+    static const int LOW_LATENCY_NUM_BUFFERS = 3;
+    static const int CHART_POINTS = SAMPLE_RATE / 2;
+    static const int CHANNELS = 2;                  // Left and right ears for the binaural beat
 };
 
 ToneGeneratorWidget::ToneGeneratorWidget(QWidget* parent)
-    : QWidget(parent), playing(false), frequency(440), beatFrequency(10), frequency2(450), phase(0) {
+    : QWidget(parent), chartFrequency(0), playing(false), frequency(440), beatFrequency(10), frequency2(450), generator(SAMPLE_RATE, CHANNELS) {
     playButton = new QPushButton("Play", this);
     stopButton = new QPushButton("Stop", this);
     waveTypeComboBox = new QComboBox(this);
     frequencyInput = new QLineEdit(this);
     beatFrequencyInput = new QLineEdit(this);
     presetFrequenciesComboBox = new QComboBox(this);
-    audioTimer = new QTimer(this);
+    filterComboBox = new QComboBox(this);
+    modulationComboBox = new QComboBox(this);
+    lowLatencyCheckBox = new QCheckBox("Low latency", this);
+    periodSpinBox = new QSpinBox(this);
+    periodCountSpinBox = new QSpinBox(this);
+    latencyLabel = new QLabel(this);
     chartTimer = new QTimer(this);
     chartView = new QChartView(this);
     series = new QLineSeries();
 
-    waveTypeComboBox->addItem("Sine", SINE);
-    waveTypeComboBox->addItem("Square", SQUARE);
-    waveTypeComboBox->addItem("White Noise", WHITE_NOISE);
-    waveTypeComboBox->addItem("Pink Noise", PINK_NOISE);
-    waveTypeComboBox->addItem("Binaural Beats", BINAURAL_BEATS);
+    waveTypeComboBox->addItem("Sine", tonegen::SINE);
+    waveTypeComboBox->addItem("Square", tonegen::SQUARE);
+    waveTypeComboBox->addItem("White Noise", tonegen::WHITE_NOISE);
+    waveTypeComboBox->addItem("Pink Noise", tonegen::PINK_NOISE);
+    waveTypeComboBox->addItem("Brown Noise", tonegen::BROWN_NOISE);
+    waveTypeComboBox->addItem("Blue Noise", tonegen::BLUE_NOISE);
+    waveTypeComboBox->addItem("Violet Noise", tonegen::VIOLET_NOISE);
+    waveTypeComboBox->addItem("Binaural Beats", tonegen::BINAURAL_BEATS);
+    waveTypeComboBox->addItem("Saw", tonegen::SAW);
+    waveTypeComboBox->addItem("Triangle", tonegen::TRIANGLE);
 
     QStringList presetFrequencies = {"440 Hz", "1000 Hz", "5000 Hz", "10000 Hz"};
     for (const auto& freq : presetFrequencies) {
         presetFrequenciesComboBox->addItem(freq);
     }
 
+    filterComboBox->addItem("None");
+    filterComboBox->addItem("Notch around tone");
+    filterComboBox->addItem("Band-pass around tone");
+
+    modulationComboBox->addItem("None");
+    modulationComboBox->addItem("Isochronic pulses");
+    modulationComboBox->addItem("Amplitude modulation");
+    modulationComboBox->addItem("Vibrato");
+
+    periodSpinBox->setRange(64, SAMPLE_RATE);
+    periodSpinBox->setSuffix(" frames");
+    periodSpinBox->setValue(BUFFER_SIZE);
+    periodCountSpinBox->setRange(2, 16);
+    periodCountSpinBox->setValue(NUM_BUFFERS);
+
     auto layout = new QVBoxLayout;
     layout->addWidget(playButton);
     layout->addWidget(stopButton);
@@ -102,6 +146,15 @@ ToneGeneratorWidget::ToneGeneratorWidget(QWidget* parent)
     layout->addWidget(beatFrequencyInput);
     layout->addWidget(new QLabel("Preset Frequencies:"));
     layout->addWidget(presetFrequenciesComboBox);
+    layout->addWidget(new QLabel("Filter (half an octave around the frequency):"));
+    layout->addWidget(filterComboBox);
+    layout->addWidget(new QLabel("Modulation (at the beat frequency):"));
+    layout->addWidget(modulationComboBox);
+    layout->addWidget(lowLatencyCheckBox);
+    layout->addWidget(new QLabel("Buffer size and count:"));
+    layout->addWidget(periodSpinBox);
+    layout->addWidget(periodCountSpinBox);
+    layout->addWidget(latencyLabel);
     layout->addWidget(chartView);
 
     setLayout(layout);
@@ -112,186 +165,231 @@ ToneGeneratorWidget::ToneGeneratorWidget(QWidget* parent)
 
     connect(playButton, &QPushButton::clicked, this, &ToneGeneratorWidget::onPlayButtonClicked);
     connect(stopButton, &QPushButton::clicked, this, &ToneGeneratorWidget::onStopButtonClicked);
-    connect(audioTimer, &QTimer::timeout, this, &ToneGeneratorWidget::onAudioTimerTimeout);
     connect(chartTimer, &QTimer::timeout, this, &ToneGeneratorWidget::onChartTimerTimeout);
     connect(frequencyInput, &QLineEdit::editingFinished, this, &ToneGeneratorWidget::onFrequencyChanged);
     connect(beatFrequencyInput, &QLineEdit::editingFinished, this, &ToneGeneratorWidget::onBeatFrequencyChanged);
     connect(waveTypeComboBox, QOverload<int>::of(&QComboBox::currentIndexChanged), this, &ToneGeneratorWidget::onWaveTypeChanged);
     connect(presetFrequenciesComboBox, QOverload<int>::of(&QComboBox::currentIndexChanged), this, &ToneGeneratorWidget::onPresetFrequencyChanged);
+    connect(filterComboBox, QOverload<int>::of(&QComboBox::currentIndexChanged), this, &ToneGeneratorWidget::onFilterChanged);
+    connect(modulationComboBox, QOverload<int>::of(&QComboBox::currentIndexChanged), this, &ToneGeneratorWidget::onModulationChanged);
+    connect(lowLatencyCheckBox, &QCheckBox::toggled, this, &ToneGeneratorWidget::onLowLatencyToggled);
+    connect(periodSpinBox, &QSpinBox::editingFinished, this, &ToneGeneratorWidget::onPeriodChanged);
+    connect(periodCountSpinBox, &QSpinBox::editingFinished, this, &ToneGeneratorWidget::onPeriodChanged);
 
+    context = nullptr;
     device = alcOpenDevice(nullptr);
-    context = alcCreateContext(device, nullptr);
-    alcMakeContextCurrent(context);
-
-    alGenBuffers(4, buffers);
-    alGenSources(1, &source);
+    if (!device) {
+        // Say so and leave playback off rather than carry on with no device
+        latencyLabel->setText("No audio device: OpenAL could not open one");
+        playButton->setEnabled(false);
+        lowLatencyCheckBox->setEnabled(false);
+        periodSpinBox->setEnabled(false);
+        periodCountSpinBox->setEnabled(false);
+        return;
+    }
+    open_stream();
 }
 
 ToneGeneratorWidget::~ToneGeneratorWidget() {
-    stop_wave(buffers, source);
-
-    alDeleteSources(1, &source);
-    alDeleteBuffers(4, buffers);
+    stream.reset();
 
     alcMakeContextCurrent(nullptr);
-    alcDestroyContext(context);
-    alcCloseDevice(device);
+    if (context) {
+        alcDestroyContext(context);
+    }
+    if (device) {
+        alcCloseDevice(device);
+    }
 }
 
 void ToneGeneratorWidget::onPlayButtonClicked() {
-    frequency = frequencyInput->text().toInt();
-    beatFrequency = beatFrequencyInput->text().toInt();
+    frequency = frequencyInput->text().toDouble();
+    beatFrequency = beatFrequencyInput->text().toDouble();
     frequency2 = frequency + beatFrequency;
     currentWave = static_cast<WaveType>(waveTypeComboBox->currentData().toInt());
 
-    if (!playing) {
-        phase = 0;
-        play_wave(buffers, source, currentWave, frequency, phase, frequency2);
+    apply_params();
+
+    if (!playing && stream) {
+        generator.reset();
+        stream->start();
         playing = true;
-        audioTimer->start(10);
         chartTimer->start(100); // Update chart every 100 ms
     }
 }
 
-void ToneGeneratorWidget::onStopButtonClicked() {
+void ToneGeneratorWidget::onLowLatencyToggled(bool checked) {
+    periodSpinBox->setValue(checked ? LOW_LATENCY_BUFFER_SIZE : BUFFER_SIZE);
+    periodCountSpinBox->setValue(checked ? LOW_LATENCY_NUM_BUFFERS : NUM_BUFFERS);
+    onPeriodChanged();
+}
+
+void ToneGeneratorWidget::onPeriodChanged() {
+    if (!device) {
+        return;
+    }
+    if (stream && stream->bufferFrames() == static_cast<size_t>(periodSpinBox->value()) &&
+        stream->bufferCount() == static_cast<size_t>(periodCountSpinBox->value())) {
+        return;
+    }
+    // Carries on from the same phase with the new buffers
+    const bool wasPlaying = playing;
     if (playing) {
-        stop_wave(buffers, source);
-        playing = false;
-        audioTimer->stop();
+        stream->stop();
+    }
+    open_stream();
+    if (wasPlaying && stream) {
+        stream->start();
+    } else if (wasPlaying) {
+        playing = false; // No context for the new buffers
         chartTimer->stop();
-        phase = 0;
     }
 }
 
-void ToneGeneratorWidget::onAudioTimerTimeout() {
+void ToneGeneratorWidget::onStopButtonClicked() {
     if (playing) {
-        update_buffers(buffers, source, currentWave, frequency, phase, frequency2);
+        stream->stop();
+        playing = false;
+        chartTimer->stop();
+        generator.reset();
     }
 }
 
 void ToneGeneratorWidget::onChartTimerTimeout() {
     if (playing) {
         update_chart();
+        show_latency();
     }
 }
 
 void ToneGeneratorWidget::onFrequencyChanged() {
+    // Play re-reads the inputs; the generator glides or crossfades to them without restarting
     if (playing) {
-        onStopButtonClicked();
         onPlayButtonClicked();
     }
 }
 
 void ToneGeneratorWidget::onBeatFrequencyChanged() {
     if (playing) {
-        onStopButtonClicked();
         onPlayButtonClicked();
     }
 }
 
 void ToneGeneratorWidget::onWaveTypeChanged(int index) {
     if (playing) {
-        onStopButtonClicked();
         onPlayButtonClicked();
     }
 }
 
 void ToneGeneratorWidget::onPresetFrequencyChanged(int index) {
     QString freqText = presetFrequenciesComboBox->currentText();
-    frequency = freqText.split(' ')[0].toInt();
+    frequency = freqText.split(' ')[0].toDouble();
     frequencyInput->setText(QString::number(frequency));
     onFrequencyChanged();
 }
 
-void ToneGeneratorWidget::generate_wave(int16_t* buffer, WaveType waveType, int length, int frequency, int& phase, int frequency2) {
-    static std::random_device rd;
-    static std::mt19937 gen(rd());
-    static std::uniform_int_distribution<> dis(-AMPLITUDE, AMPLITUDE);
-
-    for (int i = 0; i < length; ++i) {
-        float time = static_cast<float>(phase + i) / SAMPLE_RATE;
-        switch (waveType) {
-            case SINE:
-                buffer[i] = static_cast<int16_t>(AMPLITUDE * std::sin(2.0f * M_PI * frequency * time));
-                break;
-            case SQUARE:
-                buffer[i] = ((phase + i) % (SAMPLE_RATE / frequency) < (SAMPLE_RATE / frequency / 2)) ? AMPLITUDE : -AMPLITUDE;
-                break;
-            case WHITE_NOISE:
-                buffer[i] = dis(gen);
-                break;
-            case PINK_NOISE:
-                buffer[i] = dis(gen) / 2 + buffer[(i - 1 + length) % length] / 2;
-                break;
-            case BINAURAL_BEATS:
-                buffer[i] = static_cast<int16_t>(AMPLITUDE * std::sin(2.0f * M_PI * frequency * time));
-                buffer[i] += static_cast<int16_t>(AMPLITUDE * std::sin(2.0f * M_PI * frequency2 * time));
-                buffer[i] /= 2;
-                break;
-        }
+void ToneGeneratorWidget::onFilterChanged(int index) {
+    if (playing) {
+        apply_params();
     }
-    phase += length;
 }
 
-void ToneGeneratorWidget::play_wave(ALuint* buffers, ALuint source, WaveType waveType, int frequency, int& phase, int frequency2) {
-    int16_t samples[BUFFER_SIZE];
-    generate_wave(samples, waveType, BUFFER_SIZE, frequency, phase, frequency2);
-
-    for (int i = 0; i < 4; ++i) {
-        alBufferData(buffers[i], AL_FORMAT_MONO16, samples, sizeof(samples), SAMPLE_RATE);
-        alSourceQueueBuffers(source, 1, &buffers[i]);
+void ToneGeneratorWidget::onModulationChanged(int index) {
+    if (playing) {
+        apply_params();
     }
-
-    alSourcePlay(source);
 }
 
-void ToneGeneratorWidget::update_buffers(ALuint* buffers, ALuint source, WaveType waveType, int frequency, int& phase, int frequency2) {
-    int processed;
-    alGetSourcei(source, AL_BUFFERS_PROCESSED, &processed);
-
-    while (processed > 0) {
-        ALuint buffer;
-        alSourceUnqueueBuffers(source, 1, &buffer);
-
-        int16_t samples[BUFFER_SIZE];
-        generate_wave(samples, waveType, BUFFER_SIZE, frequency, phase, frequency2);
-        alBufferData(buffer, AL_FORMAT_MONO16, samples, sizeof(samples), SAMPLE_RATE);
-        alSourceQueueBuffers(source, 1, &buffer);
-
-        --processed;
+void ToneGeneratorWidget::apply_params() {
+    tonegen::ToneParams params;
+    params.waveType = currentWave;
+    params.frequency = frequency;
+    params.beatFrequency = frequency2 - frequency;
+    switch (modulationComboBox->currentIndex()) {
+        case 1:
+            params.modulation.amplitude.shape = tonegen::LFO_ISOCHRONIC;
+            params.modulation.amplitude.rate = beatFrequency;
+            params.modulation.amplitude.depth = 1;
+            break;
+        case 2:
+            params.modulation.amplitude.rate = beatFrequency;
+            params.modulation.amplitude.depth = 1;
+            break;
+        case 3:
+            params.modulation.pitch.rate = beatFrequency;
+            params.modulation.pitch.depth = 0.5f;
+            break;
+        default:
+            break;
     }
-
-    ALint state;
-    alGetSourcei(source, AL_SOURCE_STATE, &state);
-    if (state != AL_PLAYING) {
-        alSourcePlay(source);
+    generator.publishParams(params);
+
+    const double low = frequency / std::pow(2.0, 0.25);
+    const double high = frequency * std::pow(2.0, 0.25);
+    switch (filterComboBox->currentIndex()) {
+        case 1: {
+            tonegen::BiquadCoefficients sections[4];
+            generator.publishFilter(sections, tonegen::band_stop_sections(low, high, SAMPLE_RATE, sections, 4));
+            break;
+        }
+        case 2: {
+            tonegen::FilterStage stages[4];
+            generator.publishFilter(stages, tonegen::band_pass_stages(low, high, stages, 4));
+            break;
+        }
+        default:
+            generator.publishFilter(static_cast<const tonegen::FilterStage*>(nullptr), 0);
+            break;
     }
 }
 
-void ToneGeneratorWidget::stop_wave(ALuint* buffers, ALuint source) {
-    alSourceStop(source);
-    alSourcei(source, AL_BUFFER, 0);
+void ToneGeneratorWidget::open_stream() {
+    // The device mixes in periods of the buffer size too, so the context is made over with the stream
+    stream.reset();
+    if (context) {
+        alcMakeContextCurrent(nullptr);
+        alcDestroyContext(context);
+    }
+    const int bufferFrames = periodSpinBox->value();
+    const std::vector<ALCint> attributes = tonegen::openal_context_attributes(SAMPLE_RATE, bufferFrames);
+    context = alcCreateContext(device, attributes.data());
+    if (!context) {
+        latencyLabel->setText("No audio: OpenAL could not create a context on the device");
+        playButton->setEnabled(false);
+        return;
+    }
+    playButton->setEnabled(true);
+    alcMakeContextCurrent(context);
 
-    ALint queued;
-    alGetSourcei(source, AL_BUFFERS_QUEUED, &queued);
+    stream.reset(new tonegen::OpenAlStream(generator, bufferFrames, periodCountSpinBox->value()));
+}
 
-    while (queued--) {
-        ALuint buffer;
-        alSourceUnqueueBuffers(source, 1, &buffer);
-    }
+void ToneGeneratorWidget::show_latency() {
+    const tonegen::StreamLatency latency = stream->latency();
+    latencyLabel->setText(QString("Latency %1 ms (queued %2 ms, device %3 ms), %4 underruns")
+                              .arg(latency.totalSeconds() * 1000, 0, 'f', 1)
+                              .arg(latency.queuedSeconds * 1000, 0, 'f', 1)
+                              .arg(latency.deviceSeconds * 1000, 0, 'f', 1)
+                              .arg(stream->underruns()));
 }
 
 void ToneGeneratorWidget::update_chart() {
-    QVector<QPointF> points;
+    // The plot only depends on the frequency, so the timer mostly finds nothing to do
+    if (frequency == chartFrequency) {
+        return;
+    }
+    chartFrequency = frequency;
+
+    chartPoints.resize(CHART_POINTS);
     float time = 0.0f;
     float increment = 1.0f / SAMPLE_RATE;
 
-    for (int i = 0; i < BUFFER_SIZE; ++i) {
-        points.append(QPointF(time, std::sin(2.0f * M_PI * frequency * time)));
+    for (int i = 0; i < CHART_POINTS; ++i) {
+        chartPoints[i] = QPointF(time, std::sin(2.0f * M_PI * frequency * time));
         time += increment;
     }
 
-    series->replace(points);
+    series->replace(chartPoints);
 }
 
 int main(int argc, char* argv[]) {
@@ -9,6 +9,9 @@ SOURCES += main.cpp
 
 HEADERS +=
 
+include(../engine/tonegen.pri)
+include(../engine/tonegen_openal.pri)
+
 INCLUDEPATH += /usr/include/AL
 
 LIBS += -lopenal
@@ -0,0 +1,845 @@
+#include <iostream>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <complex>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "tonegen/convert.h"
+#include "tonegen/cpu.h"
+#include "tonegen/loop_cache.h"
+#include "tonegen/render_thread.h"
+#include "tonegen/tone_generator.h"
+
+// Renders every generator offline and measures what comes out, failing on any regression in
+// sound or speed:
+//   frequency   the fundamental, from an interpolated Blackman-Harris FFT peak
+//   thd+n       everything but the fundamental, for the sines (coherently sampled, so no window)
+//   aliasing    everything off the harmonic series, for the band-limited waves
+//   slope       the noise spectrum in dB per octave between 125 Hz and 8 kHz (Welch average)
+//   peak        full-scale output stays within [-1, 1] and isn't silent
+//   loop        a LoopCache loop played round its seam matches the tone rendered straight on,
+//               and a modulated tone never gets the loop of its steady carrier
+//   blocks      rendering in odd-sized blocks, as an audio callback does, matches one long block
+//   dither      dithered fan-out to interleaved channels matches dithering each interleaved
+//               sample, so the channels get independent noise
+//   render      a RenderThread with a stalled reader idles and keeps whole frames in its ring
+//   drift       the phase 24 hours in, stepped block by block and by seek(), against the exact one
+//   alloc       heap allocations while rendering, which must be none (skipped unless the engine
+//               is built with -DTONEGEN_COUNT_ALLOCATIONS=ON)
+//   speed       samples/s of each kernel at 1024-frame blocks against a floor, and the speedup
+//               of the active ISA's kernel over the scalar one measured in the same run
+//   tone_check [--filter TEXT] [--speed-scale X] [--verbose]
+// --filter keeps the checks whose name contains TEXT. The speed floors are about an eighth of
+// what the scalar kernels manage on a current x86 core, so they catch a slower build rather
+// than normal variation, and the speedups catch a SIMD kernel running scalar code whatever the
+// host; --speed-scale multiplies the floors, and 0 skips the speed checks (for sanitizer or
+// debug builds). Prints one line per failure, or per check with
+// --verbose, and exits non-zero if any failed.
+
+namespace {
+
+const int SAMPLE_RATE = 48000;
+const double PI = 3.14159265358979323846;
+
+struct NamedWave {
+    const char* name;
+    tonegen::WaveType wave;
+};
+
+const NamedWave ALL_WAVES[] = {{"sine", tonegen::SINE},           {"square", tonegen::SQUARE},
+                               {"saw", tonegen::SAW},             {"triangle", tonegen::TRIANGLE},
+                               {"pulse", tonegen::PULSE},         {"binaural", tonegen::BINAURAL_BEATS},
+                               {"wavetable", tonegen::WAVETABLE}, {"additive", tonegen::ADDITIVE},
+                               {"white", tonegen::WHITE_NOISE},   {"pink", tonegen::PINK_NOISE},
+                               {"brown", tonegen::BROWN_NOISE},   {"blue", tonegen::BLUE_NOISE},
+                               {"violet", tonegen::VIOLET_NOISE}};
+
+struct Settings {
+    std::string filter;
+    double speedScale = 1;
+    bool verbose = false;
+};
+
+class Report {
+public:
+    explicit Report(const Settings& settings) : m_settings(settings), m_passed(0), m_failed(0) {}
+
+    bool wants(const std::string& name) const {
+        return m_settings.filter.empty() || name.find(m_settings.filter) != std::string::npos;
+    }
+
+    // format takes the measured value, then the limit
+    void check(const std::string& name, bool ok, const char* format, double value, double limit) {
+        char detail[160];
+        std::snprintf(detail, sizeof(detail), format, value, limit);
+        record(name, ok, detail);
+    }
+    void fail(const std::string& name, const char* detail) { record(name, false, detail); }
+    // Always said, so a build that can't run some checks doesn't look like it passed them
+    void skip(const std::string& name, const char* why) {
+        if (wants(name)) {
+            std::printf("skip %-40s %s\n", name.c_str(), why);
+        }
+    }
+
+    int passed() const { return m_passed; }
+    int failed() const { return m_failed; }
+
+private:
+    void record(const std::string& name, bool ok, const char* detail) {
+        if (ok) {
+            ++m_passed;
+        } else {
+            ++m_failed;
+        }
+        if (!ok || m_settings.verbose) {
+            std::printf("%s %-40s %s\n", ok ? "pass" : "FAIL", name.c_str(), detail);
+        }
+    }
+
+    const Settings& m_settings;
+    int m_passed;
+    int m_failed;
+};
+
+double db(double ratio) { return 10 * std::log10(std::max(ratio, 1e-30)); }
+
+// In-place radix-2 FFT; n must be a power of two
+void fft(std::vector<std::complex<double>>& data) {
+    const size_t n = data.size();
+    for (size_t i = 1, j = 0; i < n; ++i) {
+        size_t bit = n >> 1;
+        for (; j & bit; bit >>= 1) {
+            j ^= bit;
+        }
+        j ^= bit;
+        if (i < j) {
+            std::swap(data[i], data[j]);
+        }
+    }
+    for (size_t length = 2; length <= n; length <<= 1) {
+        const std::complex<double> step = std::polar(1.0, -2 * PI / length);
+        for (size_t start = 0; start < n; start += length) {
+            std::complex<double> twiddle = 1;
+            for (size_t k = 0; k < length / 2; ++k) {
+                const std::complex<double> odd = data[start + k + length / 2] * twiddle;
+                data[start + k + length / 2] = data[start + k] - odd;
+                data[start + k] += odd;
+                twiddle *= step;
+            }
+        }
+    }
+}
+
+// Power in bins 0 to n / 2 of x (a power of two long), windowed or not
+std::vector<double> power_spectrum(const std::vector<float>& x, bool blackmanHarris) {
+    const size_t n = x.size();
+    std::vector<std::complex<double>> data(n);
+    for (size_t i = 0; i < n; ++i) {
+        double w = 1;
+        if (blackmanHarris) {
+            const double t = 2 * PI * i / n;
+            w = 0.35875 - 0.48829 * std::cos(t) + 0.14128 * std::cos(2 * t) - 0.01168 * std::cos(3 * t);
+        }
+        data[i] = x[i] * w;
+    }
+    fft(data);
+    std::vector<double> power(n / 2 + 1);
+    for (size_t k = 0; k <= n / 2; ++k) {
+        power[k] = std::norm(data[k]);
+    }
+    return power;
+}
+
+// One channel of interleaved audio
+std::vector<float> channel(const std::vector<float>& frames, size_t channels, size_t index) {
+    std::vector<float> out(frames.size() / channels);
+    for (size_t i = 0; i < out.size(); ++i) {
+        out[i] = frames[i * channels + index];
+    }
+    return out;
+}
+
+// A generator as the frontends set it up, for every wave type
+std::unique_ptr<tonegen::ToneGenerator> make_generator(const tonegen::ToneParams& params, size_t channels) {
+    std::unique_ptr<tonegen::ToneGenerator> generator(new tonegen::ToneGenerator(SAMPLE_RATE, channels));
+    tonegen::Partial partials[8];
+    for (size_t i = 0; i < 8; ++i) {
+        partials[i].ratio = static_cast<double>(i + 1);
+        partials[i].amplitude = 0.5f / static_cast<float>(i + 1);
+    }
+    generator->setParams(params);
+    generator->setWavetable(tonegen::Wavetable::builtin(tonegen::WAVETABLE_SAW));
+    generator->setPartials(partials, 8);
+    generator->reset();
+    return generator;
+}
+
+// frames of interleaved audio after skipping settle frames (noise filters and BLEP warm-up)
+std::vector<float> render(const tonegen::ToneParams& params, size_t channels, size_t frames, size_t settle = 0) {
+    std::unique_ptr<tonegen::ToneGenerator> generator = make_generator(params, channels);
+    std::vector<float> out(std::max(frames, settle) * channels);
+    generator->process(out.data(), settle);
+    generator->process(out.data(), frames);
+    out.resize(frames * channels);
+    return out;
+}
+
+tonegen::ToneParams tone(tonegen::WaveType wave, double frequency, float amplitude = 0.5f) {
+    tonegen::ToneParams params;
+    params.waveType = wave;
+    params.frequency = frequency;
+    params.amplitude = amplitude;
+    return params;
+}
+
+// Frequency of the strongest component, interpolating the peak bin's neighbours on a log scale
+double peak_frequency(const std::vector<float>& x) {
+    const std::vector<double> power = power_spectrum(x, true);
+    size_t peak = 2;
+    for (size_t k = 2; k + 1 < power.size(); ++k) {
+        if (power[k] > power[peak]) {
+            peak = k;
+        }
+    }
+    const double left = std::log(power[peak - 1]);
+    const double centre = std::log(power[peak]);
+    const double right = std::log(power[peak + 1]);
+    const double offset = 0.5 * (left - right) / (left - 2 * centre + right);
+    return (peak + offset) * SAMPLE_RATE / x.size();
+}
+
+struct FrequencyCase {
+    const char* name;
+    tonegen::ToneParams params;
+};
+
+void check_frequency(Report& report) {
+    const size_t frames = size_t(1) << 18;
+    tonegen::ToneParams pulse = tone(tonegen::PULSE, 1234.5);
+    pulse.pulseWidth = 0.3f;
+    const FrequencyCase CASES[] = {{"sine 440", tone(tonegen::SINE, 440)},
+                                   {"sine 7001.25", tone(tonegen::SINE, 7001.25)},
+                                   {"square 440", tone(tonegen::SQUARE, 440)},
+                                   {"square 1000.5", tone(tonegen::SQUARE, 1000.5)},
+                                   {"square 3333", tone(tonegen::SQUARE, 3333)},
+                                   {"saw 440", tone(tonegen::SAW, 440)},
+                                   {"triangle 523.25", tone(tonegen::TRIANGLE, 523.25)},
+                                   {"pulse 1234.5", pulse},
+                                   {"wavetable 261.63", tone(tonegen::WAVETABLE, 261.63)},
+                                   {"additive 110", tone(tonegen::ADDITIVE, 110)}};
+    for (const FrequencyCase& c : CASES) {
+        const std::string name = std::string("frequency/") + c.name;
+        if (report.wants(name)) {
+            const double error = std::fabs(peak_frequency(render(c.params, 1, frames)) - c.params.frequency);
+            report.check(name, error <= 0.01, "off by %.5f Hz (limit %.2f)", error, 0.01);
+        }
+    }
+
+    // Binaural beats: the carrier on even channels, carrier + beat on odd ones
+    tonegen::ToneParams binaural = tone(tonegen::BINAURAL_BEATS, 200);
+    binaural.beatFrequency = 7.5;
+    if (report.wants("frequency/binaural")) {
+        const std::vector<float> stereo = render(binaural, 2, frames);
+        const double left = std::fabs(peak_frequency(channel(stereo, 2, 0)) - 200);
+        const double right = std::fabs(peak_frequency(channel(stereo, 2, 1)) - 207.5);
+        report.check("frequency/binaural left", left <= 0.01, "off by %.5f Hz (limit %.2f)", left, 0.01);
+        report.check("frequency/binaural right", right <= 0.01, "off by %.5f Hz (limit %.2f)", right, 0.01);
+    }
+}
+
+// Ratio of the power off the harmonic series to all of it, in dB. The tone is coherently
+// sampled (a whole number of cycles in the block), so every harmonic and every alias lands
+// on a bin of its own and needs no window.
+double inharmonic_db(const std::vector<float>& x, size_t fundamentalBin, size_t harmonics) {
+    const std::vector<double> power = power_spectrum(x, false);
+    double total = 0;
+    double off = 0;
+    for (size_t k = 1; k < power.size(); ++k) {
+        total += power[k];
+        const bool harmonic = k % fundamentalBin == 0 && k / fundamentalBin <= harmonics;
+        if (!harmonic) {
+            off += power[k];
+        }
+    }
+    return db(off / total);
+}
+
+void check_distortion(Report& report) {
+    const size_t frames = size_t(1) << 16;
+    const double binHz = static_cast<double>(SAMPLE_RATE) / frames;
+
+    // THD+N of the sines at about 440 Hz, one per accuracy
+    const struct {
+        const char* name;
+        tonegen::SineAccuracy accuracy;
+        double limit;
+    } SINES[] = {{"fast", tonegen::SINE_FAST, -60},
+                 {"balanced", tonegen::SINE_BALANCED, -100},
+                 {"precise", tonegen::SINE_PRECISE, -120}};
+    for (const auto& sine : SINES) {
+        const std::string name = std::string("thd+n/sine ") + sine.name;
+        if (report.wants(name)) {
+            tonegen::ToneParams params = tone(tonegen::SINE, 601 * binHz);
+            params.sineAccuracy = sine.accuracy;
+            const double level = inharmonic_db(render(params, 1, frames), 601, 1);
+            report.check(name, level <= sine.limit, "%.1f dB (limit %.0f)", level, sine.limit);
+        }
+    }
+
+    // Aliasing of the band-limited waves at about 2.2 kHz, where a naive oscillator folds its
+    // harmonics back at about -13 dB (-38 dB for the triangle); PolyBLEP gains some 15 dB
+    const size_t bin = 3001;
+    const size_t harmonics = frames / 2 / bin;
+    tonegen::ToneParams pulse = tone(tonegen::PULSE, bin * binHz);
+    pulse.pulseWidth = 0.25f;
+    const struct {
+        const char* name;
+        tonegen::ToneParams params;
+        double limit;
+    } WAVES[] = {{"square", tone(tonegen::SQUARE, bin * binHz), -24},
+                 {"saw", tone(tonegen::SAW, bin * binHz), -24},
+                 {"triangle", tone(tonegen::TRIANGLE, bin * binHz), -45},
+                 {"pulse", pulse, -24},
+                 {"wavetable", tone(tonegen::WAVETABLE, bin * binHz), -90}};
+    for (const auto& wave : WAVES) {
+        const std::string name = std::string("aliasing/") + wave.name;
+        if (report.wants(name)) {
+            const double level = inharmonic_db(render(wave.params, 1, frames, SAMPLE_RATE / 10), bin, harmonics);
+            report.check(name, level <= wave.limit, "%.1f dB (limit %.0f)", level, wave.limit);
+        }
+    }
+}
+
+// Slope of a least-squares line through the mean power of each octave band from 125 Hz to
+// 8 kHz, in dB per octave, from 4096-point Hann-windowed segments averaged over 20 s
+double noise_slope(const std::vector<float>& x) {
+    const size_t n = 4096;
+    std::vector<double> power(n / 2 + 1, 0.0);
+    std::vector<float> segment(n);
+    for (size_t start = 0; start + n <= x.size(); start += n / 2) {
+        for (size_t i = 0; i < n; ++i) {
+            segment[i] = static_cast<float>(x[start + i] * (0.5 - 0.5 * std::cos(2 * PI * i / n)));
+        }
+        const std::vector<double> part = power_spectrum(segment, false);
+        for (size_t k = 0; k < part.size(); ++k) {
+            power[k] += part[k];
+        }
+    }
+
+    double sumX = 0;
+    double sumY = 0;
+    double sumXX = 0;
+    double sumXY = 0;
+    int bands = 0;
+    for (double centre = 125; centre <= 8000; centre *= 2) {
+        const size_t low = static_cast<size_t>(std::ceil(centre / std::sqrt(2.0) * n / SAMPLE_RATE));
+        const size_t high = static_cast<size_t>(std::floor(centre * std::sqrt(2.0) * n / SAMPLE_RATE));
+        double sum = 0;
+        for (size_t k = low; k <= high; ++k) {
+            sum += power[k];
+        }
+        const double x = std::log2(centre);
+        const double y = db(sum / (high - low + 1));
+        sumX += x;
+        sumY += y;
+        sumXX += x * x;
+        sumXY += x * y;
+        ++bands;
+    }
+    return (bands * sumXY - sumX * sumY) / (bands * sumXX - sumX * sumX);
+}
+
+void check_noise(Report& report) {
+    const struct {
+        const char* name;
+        tonegen::WaveType wave;
+        double slope;
+    } NOISES[] = {{"white", tonegen::WHITE_NOISE, 0},
+                  {"pink", tonegen::PINK_NOISE, -3.01},
+                  {"brown", tonegen::BROWN_NOISE, -6.02},
+                  {"blue", tonegen::BLUE_NOISE, 3.01},
+                  {"violet", tonegen::VIOLET_NOISE, 6.02}};
+    for (const auto& noise : NOISES) {
+        const std::string name = std::string("slope/") + noise.name;
+        if (report.wants(name)) {
+            const double slope = noise_slope(render(tone(noise.wave, 440), 1, 20 * SAMPLE_RATE, SAMPLE_RATE));
+            const double error = std::fabs(slope - noise.slope);
+            report.check(name, error <= 0.5, "%+.2f dB/octave (limit 0.5 dB/octave off, %+.2f)", slope, noise.slope);
+        }
+    }
+}
+
+// Every wave at full scale, mono and spread over channels, with the binaural pair at the
+// same frequency so the two tones sum to their largest in the mono mix
+void check_peak(Report& report) {
+    for (const NamedWave& wave : ALL_WAVES) {
+        for (size_t channels : {size_t(1), size_t(2)}) {
+            const std::string name = std::string("peak/") + wave.name + (channels == 1 ? " mono" : " stereo");
+            if (!report.wants(name)) {
+                continue;
+            }
+            tonegen::ToneParams params = tone(wave.wave, 1000, 1.0f);
+            params.beatFrequency = 0;
+            const std::vector<float> out = render(params, channels, 10 * SAMPLE_RATE);
+            float peak = 0;
+            for (float sample : out) {
+                peak = std::max(peak, std::fabs(sample));
+            }
+            // PolyBLEP edges may round a hair past full scale, which conversion clips
+            report.check(name, peak <= 1.0001f && peak >= 0.1f, "%.5f (limit %.4f, and not silent)", peak, 1.0001);
+        }
+    }
+
+    // Uneven pulses, whose DC-free levels differ: the taller side should reach full scale and
+    // no further, on the mono and the interleaved kernels alike
+    for (float width : {0.1f, 0.25f, 0.75f}) {
+        for (size_t channels : {size_t(1), size_t(2)}) {
+            char name[48];
+            std::snprintf(name, sizeof(name), "peak/pulse %.2f %s", width, channels == 1 ? "mono" : "stereo");
+            if (!report.wants(name)) {
+                continue;
+            }
+            tonegen::ToneParams params = tone(tonegen::PULSE, 200, 1.0f);
+            params.pulseWidth = width;
+            const std::vector<float> out = render(params, channels, SAMPLE_RATE);
+            float peak = 0;
+            for (float sample : out) {
+                peak = std::max(peak, std::fabs(sample));
+            }
+            report.check(name, peak <= 1.0001f && peak >= 0.95f, "%.5f (limit %.4f, and at least 0.95)", peak, 1.0001);
+        }
+    }
+}
+
+void check_loops(Report& report) {
+    const struct {
+        const char* name;
+        tonegen::ToneParams params;
+    } TONES[] = {{"sine 440", tone(tonegen::SINE, 440)},
+                 {"square 441", tone(tonegen::SQUARE, 441)},
+                 {"saw 110.25", tone(tonegen::SAW, 110.25)},
+                 {"triangle 1000", tone(tonegen::TRIANGLE, 1000)}};
+    tonegen::LoopCache cache(SAMPLE_RATE, 2, tonegen::SAMPLE_FLOAT);
+    for (const auto& t : TONES) {
+        const std::string name = std::string("loop/") + t.name;
+        if (!report.wants(name)) {
+            continue;
+        }
+        std::shared_ptr<const tonegen::ToneLoop> loop = cache.find(t.params);
+        if (!loop) {
+            report.fail(name, "no exact loop");
+            continue;
+        }
+        // Where in a straight render the loop starts, by matching its first frames
+        const size_t match = 256;
+        const std::vector<float> straight = render(t.params, 2, loop->periodFrames + 3 * loop->frames);
+        const float* looped = reinterpret_cast<const float*>(loop->data.data());
+        size_t start = 0;
+        double best = 1e30;
+        for (size_t offset = 0; offset < loop->periodFrames + loop->frames; ++offset) {
+            double distance = 0;
+            for (size_t i = 0; i < match * 2 && distance < best; ++i) {
+                distance += std::fabs(straight[offset * 2 + i] - looped[i]);
+            }
+            if (distance < best) {
+                best = distance;
+                start = offset;
+            }
+        }
+        // Played twice round, across the seam, against the straight render from there
+        std::vector<float> played(2 * loop->frames * 2);
+        loop->copy(played.data(), 2 * loop->frames, 0);
+        double error = 0;
+        for (size_t i = 0; i < played.size(); ++i) {
+            error = std::max(error, std::fabs(static_cast<double>(played[i]) - straight[start * 2 + i]));
+        }
+        report.check(name, error <= 1e-4, "differs by %.2e across the seam (limit %.0e)", error, 1e-4);
+    }
+
+    // The steady carrier is cached first; the same carrier with an isochronic LFO, vibrato or
+    // an envelope has no exact loop and must not be handed the steady one
+    const char* modulatedName = "loop/modulated carrier";
+    if (report.wants(modulatedName)) {
+        const tonegen::ToneParams steady = tone(tonegen::SINE, 10000);
+        tonegen::ToneParams isochronic = steady;
+        isochronic.modulation.amplitude.shape = tonegen::LFO_ISOCHRONIC;
+        isochronic.modulation.amplitude.rate = 10;
+        isochronic.modulation.amplitude.depth = 1;
+        tonegen::ToneParams vibrato = steady;
+        vibrato.modulation.pitch.rate = 5;
+        vibrato.modulation.pitch.depth = 0.5f;
+        tonegen::ToneParams fading = steady;
+        fading.modulation.envelope.attack = 1;
+        const bool cached = cache.find(steady) != nullptr;
+        int wrong = 0;
+        for (const tonegen::ToneParams& params : {isochronic, vibrato, fading}) {
+            wrong += cache.find(params) != nullptr;
+        }
+        report.check(modulatedName, cached && wrong == 0, "%.0f modulated tones got a loop (limit %.0f)", wrong, 0);
+    }
+
+    // A sink reading odd amounts, as QIODevice::readData is asked for, against one long render
+    const size_t frames = 20000;
+    const size_t SIZES[] = {1, 7, 64, 255, 256, 257, 333, 1000, 4096};
+    const struct {
+        const char* name;
+        tonegen::WaveType wave;
+    } WAVES[] = {{"sine", tonegen::SINE},
+                 {"square", tonegen::SQUARE},
+                 {"binaural", tonegen::BINAURAL_BEATS},
+                 {"pink", tonegen::PINK_NOISE}};
+    for (const auto& wave : WAVES) {
+        const std::string name = std::string("blocks/") + wave.name;
+        if (!report.wants(name)) {
+            continue;
+        }
+        tonegen::ToneParams params = tone(wave.wave, 523.25);
+        params.beatFrequency = 5;
+        const std::vector<float> whole = render(params, 2, frames);
+        std::unique_ptr<tonegen::ToneGenerator> generator = make_generator(params, 2);
+        std::vector<float> pieces(frames * 2);
+        for (size_t done = 0, i = 0; done < frames; ++i) {
+            const size_t count = std::min(SIZES[i % 9], frames - done);
+            generator->process(pieces.data() + done * 2, count);
+            done += count;
+        }
+        double error = 0;
+        for (size_t i = 0; i < pieces.size(); ++i) {
+            error = std::max(error, std::fabs(static_cast<double>(pieces[i]) - whole[i]));
+        }
+        report.check(name, error <= 1e-5, "differs by %.2e (limit %.0e)", error, 1e-5);
+    }
+}
+
+// convert_mono_to_interleaved must dither each channel at its own interleaved position, the
+// same noise as fanning out first and converting every sample, and not one shared value
+void check_dither(Report& report) {
+    const size_t frames = 3000;
+    std::vector<float> mono = render(tone(tonegen::SINE, 1000, 1e-4f), 1, frames);
+    for (int channels : {2, 8, 11}) {
+        char name[48];
+        std::snprintf(name, sizeof(name), "dither/%d channels", channels);
+        if (!report.wants(name)) {
+            continue;
+        }
+        const size_t samples = frames * static_cast<size_t>(channels);
+        std::vector<float> wide(samples);
+        for (size_t i = 0; i < samples; ++i) {
+            wide[i] = mono[i / static_cast<size_t>(channels)];
+        }
+        tonegen::Dither expectedDither;
+        expectedDither.enabled = true;
+        expectedDither.position = 12345;
+        tonegen::Dither dither = expectedDither;
+        std::vector<int16_t> expected(samples);
+        std::vector<int16_t> out(samples);
+        tonegen::convert_samples(wide.data(), expected.data(), tonegen::SAMPLE_INT16, samples, &expectedDither);
+        tonegen::convert_mono_to_interleaved(mono.data(), out.data(), tonegen::SAMPLE_INT16, frames, channels, &dither);
+        size_t mismatched = 0;
+        size_t shared = 0;
+        for (size_t i = 0; i < samples; ++i) {
+            mismatched += out[i] != expected[i];
+            shared += i % static_cast<size_t>(channels) != 0 && out[i] == out[i - i % static_cast<size_t>(channels)];
+        }
+        report.check(std::string(name) + " position", mismatched == 0 && dither.position == expectedDither.position,
+                     "%.0f samples differ from dithering the fanned-out floats (limit %.0f)",
+                     static_cast<double>(mismatched), 0);
+        // Independent TPDF noise agrees with channel 0 a little over half the time; shared noise always
+        const double agreement = static_cast<double>(shared) / static_cast<double>(samples - frames);
+        report.check(std::string(name) + " independent", agreement <= 0.75, "%.2f of samples equal channel 0 (limit %.2f)",
+                     agreement, 0.75);
+    }
+}
+
+// A day into a render, the phase must still be exactly frame * increment (mod 2^64), whether it
+// got there in audio-sized steps or by seek(), and the tone must still match one computed in
+// double. Frequencies are whole millihertz, so the ideal phase is exact in integers.
+void check_drift(Report& report) {
+    const uint64_t frames = uint64_t(24) * 3600 * SAMPLE_RATE;
+    const uint64_t rateMilli = uint64_t(SAMPLE_RATE) * 1000;
+    for (uint64_t milliHz : {uint64_t(440000), uint64_t(440123), uint64_t(7777777)}) {
+        const double frequency = milliHz / 1000.0;
+        char name[48];
+        std::snprintf(name, sizeof(name), "drift/%.3f Hz", frequency);
+        if (!report.wants(name)) {
+            continue;
+        }
+        tonegen::PhaseAccumulator stepped;
+        stepped.setFrequency(frequency, SAMPLE_RATE);
+        for (uint64_t done = 0; done < frames; done += tonegen::MAX_BLOCK_FRAMES) {
+            stepped.advance(tonegen::MAX_BLOCK_FRAMES);
+        }
+        const uint64_t exact = frames * stepped.increment;
+        report.check(std::string(name) + " stepped", stepped.phase == exact, "%.0f LSB from frame * increment (limit %.0f)",
+                     std::fabs(static_cast<double>(static_cast<int64_t>(stepped.phase - exact))), 0);
+        const double ideal = static_cast<double>(frames % rateMilli * milliHz % rateMilli) / rateMilli;
+        double drift = std::fabs(stepped.turns() - ideal);
+        drift = std::min(drift, 1 - drift);
+        report.check(std::string(name) + " phase", drift <= 1e-6, "%.2e cycles from the ideal (limit %.0e)", drift, 1e-6);
+
+        // seek() to the same frame, then a block against the ideal sine
+        tonegen::ToneParams params = tone(tonegen::SINE, frequency, 1.0f);
+        params.sineAccuracy = tonegen::SINE_PRECISE;
+        std::unique_ptr<tonegen::ToneGenerator> generator = make_generator(params, 1);
+        generator->seek(frames);
+        std::vector<float> out(4096);
+        generator->process(out.data(), out.size());
+        double error = 0;
+        for (size_t i = 0; i < out.size(); ++i) {
+            const uint64_t cycle = (frames + i) % rateMilli * milliHz % rateMilli;
+            const double expected = std::sin(2 * PI * static_cast<double>(cycle) / rateMilli);
+            error = std::max(error, std::fabs(out[i] - expected));
+        }
+        report.check(std::string(name) + " render", error <= 1e-5, "differs by %.2e after seek (limit %.0e)", error, 1e-5);
+    }
+}
+
+// A RenderThread whose reader stalls through two restarts has a ring full of audio nobody has
+// read. The producer must wait rather than spin, and the ring must hold only whole frames: 3
+// channels of int16 don't divide its power-of-two size.
+void check_render_thread(Report& report) {
+    const char* name = "render/stalled reader";
+    if (!report.wants(name)) {
+        return;
+    }
+    const size_t channels = 3;
+    std::unique_ptr<tonegen::ToneGenerator> generator = make_generator(tone(tonegen::SINE, 440), channels);
+    tonegen::RenderThread thread(*generator, tonegen::SAMPLE_INT16, 1000);
+    thread.start();
+    for (int i = 0; i < 2; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        thread.restart();
+    }
+    const std::clock_t start = std::clock();
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    const double busy = static_cast<double>(std::clock() - start) / CLOCKS_PER_SEC / 0.2;
+    report.check(std::string(name) + " idle", busy <= 0.1, "producer busy %.2f of the wait (limit %.2f)", busy, 0.1);
+
+    // After the restarts the channels are in step, the padding included, and the first fresh
+    // frame is phase zero
+    std::vector<int16_t> out(1000 * channels);
+    size_t frames = 0;
+    size_t misaligned = 0;
+    for (int i = 0; i < 4; ++i) {
+        const size_t got = thread.read(out.data(), 1000);
+        if (frames == 0 && got > 0) {
+            misaligned += out[0] != 0;
+        }
+        for (size_t f = 0; f < 1000; ++f) {
+            misaligned += out[f * channels] != out[f * channels + 1] || out[f * channels] != out[f * channels + 2];
+        }
+        frames += got;
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+    thread.stop();
+    report.check(std::string(name) + " frames", frames > 0 && misaligned == 0,
+                 "%.0f misaligned frames after the restarts (limit %.0f)", static_cast<double>(misaligned), 0);
+}
+
+// Rendering must never reach the heap: every wave with each filter and modulation setting,
+// through every process() overload and with live changes published in between, then the
+// RenderThread producer. Needs the engine built with TONEGEN_COUNT_ALLOCATIONS.
+void check_allocations(Report& report) {
+    if (!tonegen::counting_allocations()) {
+        report.skip("alloc/", "the engine was built without TONEGEN_COUNT_ALLOCATIONS");
+        return;
+    }
+    tonegen::FilterStage bandPass[4];
+    const size_t bandPassCount = tonegen::band_pass_stages(200, 2000, bandPass, 4);
+    tonegen::BiquadCoefficients bandStop[4];
+    const size_t bandStopCount = tonegen::band_stop_sections(400, 500, SAMPLE_RATE, bandStop, 4);
+    tonegen::ModulationParams modulations[4];
+    modulations[1].amplitude.shape = tonegen::LFO_ISOCHRONIC;
+    modulations[1].amplitude.rate = 10;
+    modulations[1].amplitude.depth = 1;
+    modulations[2].pitch.rate = 5;
+    modulations[2].pitch.depth = 0.5f;
+    modulations[3].envelope.attack = 0.01f;
+    modulations[3].envelope.decay = 0.02f;
+    modulations[3].envelope.sustain = 0.5f;
+    modulations[3].envelope.release = 0.05f;
+
+    std::vector<uint8_t> out(tonegen::MAX_BLOCK_FRAMES * 4 * sizeof(float) * tonegen::MAX_CHANNELS);
+    for (const NamedWave& wave : ALL_WAVES) {
+        const std::string name = std::string("alloc/") + wave.name;
+        if (!report.wants(name)) {
+            continue;
+        }
+        uint64_t allocations = 0;
+        for (size_t channels : {size_t(1), size_t(2), tonegen::MAX_CHANNELS}) {
+            for (int filter = 0; filter < 3; ++filter) {
+                for (const tonegen::ModulationParams& modulation : modulations) {
+                    tonegen::ToneParams params = tone(wave.wave, 440);
+                    params.beatFrequency = 6;
+                    params.modulation = modulation;
+                    std::unique_ptr<tonegen::ToneGenerator> generator = make_generator(params, channels);
+                    generator->setDither(true);
+                    if (filter == 1) {
+                        generator->setFilter(bandPass, bandPassCount);
+                    } else if (filter == 2) {
+                        generator->setFilter(bandStop, bandStopCount);
+                    }
+
+                    const uint64_t before = tonegen::thread_allocations();
+                    float* floats = reinterpret_cast<float*>(out.data());
+                    for (int block = 0; block < 8; ++block) {
+                        generator->process(floats, 1000);
+                        generator->process(reinterpret_cast<int16_t*>(out.data()), 777);
+                        generator->process(out.data(), static_cast<tonegen::SampleFormat>(block % 4), 1024);
+                        if (block == 3) {
+                            // A glide, a crossfade to the next wave and a filter change
+                            params.frequency = 660;
+                            params.pulseWidth = 0.3f;
+                            params.waveType = static_cast<tonegen::WaveType>((wave.wave + 1) % tonegen::WAVE_TYPE_COUNT);
+                            generator->publishParams(params);
+                            generator->publishFilter(bandPass, bandPassCount);
+                        } else if (block == 5) {
+                            generator->noteOff();
+                        }
+                    }
+                    allocations += tonegen::thread_allocations() - before;
+                }
+            }
+        }
+        report.check(name, allocations == 0, "%.0f heap allocations while rendering (limit %.0f)",
+                     static_cast<double>(allocations), 0);
+    }
+
+    if (report.wants("alloc/render thread")) {
+        tonegen::ToneParams params = tone(tonegen::PINK_NOISE, 440);
+        params.modulation = modulations[1];
+        std::unique_ptr<tonegen::ToneGenerator> generator = make_generator(params, 2);
+        generator->setFilter(bandPass, bandPassCount);
+        tonegen::RenderThread thread(*generator, tonegen::SAMPLE_INT16, 2048);
+        thread.start();
+        const uint64_t before = tonegen::thread_allocations();
+        for (const NamedWave& wave : ALL_WAVES) {
+            params.waveType = wave.wave;
+            generator->publishParams(params);
+            for (size_t frames = 0; frames < SAMPLE_RATE / 20;) {
+                const size_t read = thread.read(out.data(), 512);
+                frames += read;
+                if (read < 512) {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                }
+            }
+        }
+        const uint64_t reader = tonegen::thread_allocations() - before;
+        thread.stop();
+        const uint64_t producer = thread.status().allocations;
+        report.check("alloc/render thread producer", producer == 0, "%.0f heap allocations (limit %.0f)",
+                     static_cast<double>(producer), 0);
+        report.check("alloc/render thread reader", reader == 0, "%.0f heap allocations (limit %.0f)",
+                     static_cast<double>(reader), 0);
+    }
+}
+
+// Fastest of five 20 ms runs at 1024-frame blocks on the active ISA, in millions of mono
+// samples per second, so a busy machine has to be busy throughout to fail
+double throughput(tonegen::WaveType wave) {
+    const size_t block = 1024;
+    std::vector<float> out(block);
+    std::unique_ptr<tonegen::ToneGenerator> generator = make_generator(tone(wave, 440), 1);
+    double best = 0;
+    for (int run = 0; run < 5; ++run) {
+        const auto start = std::chrono::steady_clock::now();
+        size_t samples = 0;
+        double elapsed = 0;
+        while (elapsed < 0.02) {
+            generator->process(out.data(), block);
+            samples += block;
+            elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        }
+        best = std::max(best, samples / elapsed / 1e6);
+    }
+    return best;
+}
+
+void check_speed(Report& report, double scale) {
+    // Floors in millions of mono samples per second, for any ISA, then the least speedup over
+    // the scalar kernel measured in the same run: for 4-lane (SSE2, NEON), AVX2 and AVX-512
+    // kernels. About half what a current x86 core shows, so a SIMD kernel that fell back to
+    // scalar code fails on the host that runs it. 0 where the SIMD kernel isn't reliably faster.
+    const struct {
+        const char* name;
+        tonegen::WaveType wave;
+        double floor;
+        double speedup[3];
+    } KERNELS[] = {{"sine", tonegen::SINE, 120, {0, 1.4, 1.8}},
+                   {"square", tonegen::SQUARE, 20, {1.4, 2.5, 4}},
+                   {"saw", tonegen::SAW, 40, {1.4, 2.5, 3.5}},
+                   {"triangle", tonegen::TRIANGLE, 30, {1.5, 3, 4}},
+                   {"pulse", tonegen::PULSE, 30, {1.4, 2.5, 4}},
+                   {"binaural", tonegen::BINAURAL_BEATS, 70, {0, 1.3, 1.4}},
+                   {"wavetable", tonegen::WAVETABLE, 100, {0, 1.2, 1.2}},
+                   {"additive", tonegen::ADDITIVE, 10, {2.5, 4, 5}},
+                   {"white", tonegen::WHITE_NOISE, 30, {1.4, 2.5, 3}},
+                   {"pink", tonegen::PINK_NOISE, 10, {1.1, 1.2, 1.3}},
+                   {"brown", tonegen::BROWN_NOISE, 20, {1.1, 1.2, 1.2}},
+                   {"blue", tonegen::BLUE_NOISE, 10, {1.1, 1.2, 1.2}},
+                   {"violet", tonegen::VIOLET_NOISE, 25, {1.2, 1.3, 1.4}}};
+    const tonegen::CpuIsa isa = tonegen::active_isa();
+    const int width = isa == tonegen::ISA_AVX512 ? 2 : isa == tonegen::ISA_AVX2 ? 1 : 0;
+    for (const auto& kernel : KERNELS) {
+        const std::string name = std::string("speed/") + kernel.name + " " + tonegen::isa_name(isa);
+        if (!report.wants(name)) {
+            continue;
+        }
+        const double best = throughput(kernel.wave);
+        const double floor = kernel.floor * scale;
+        report.check(name, best >= floor, "%.1f Msamples/s (floor %.1f)", best, floor);
+
+        const double speedup = kernel.speedup[width];
+        if (isa == tonegen::ISA_SCALAR || speedup == 0) {
+            continue;
+        }
+        tonegen::set_active_isa(tonegen::ISA_SCALAR);
+        const double scalar = throughput(kernel.wave);
+        tonegen::set_active_isa(isa);
+        report.check(name + " vs scalar", best >= speedup * scalar, "%.2fx the scalar kernel (floor %.2fx)",
+                     best / scalar, speedup);
+    }
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    Settings settings;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--filter" && i + 1 < argc) {
+            settings.filter = argv[++i];
+        } else if (arg == "--speed-scale" && i + 1 < argc) {
+            settings.speedScale = std::max(std::atof(argv[++i]), 0.0);
+        } else if (arg == "--verbose") {
+            settings.verbose = true;
+        } else {
+            std::cerr << "Usage: tone_check [--filter TEXT] [--speed-scale X] [--verbose]" << std::endl;
+            return 1;
+        }
+    }
+
+    Report report(settings);
+    check_frequency(report);
+    check_distortion(report);
+    check_noise(report);
+    check_peak(report);
+    check_loops(report);
+    check_dither(report);
+    check_drift(report);
+    check_render_thread(report);
+    check_allocations(report);
+    if (settings.speedScale > 0) {
+        check_speed(report, settings.speedScale);
+    }
+    std::printf("%d checks passed, %d failed\n", report.passed(), report.failed());
+    return report.failed() == 0 ? 0 : 1;
+}
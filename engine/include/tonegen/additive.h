@@ -0,0 +1,84 @@
+#pragma once
+
+#include <vector>
+
+#include "tonegen/types.h"
+
+namespace tonegen {
+
+namespace detail {
+struct Complex;
+}
+
+struct Partial {
+    double ratio = 1;     // Frequency as a multiple of the fundamental; need not be an integer
+    float amplitude = 0;
+    float phase = 0;      // Start phase in turns
+};
+
+const size_t ADDITIVE_MAX_PARTIALS = 1024;
+
+// ADDITIVE_AUTO runs recursive oscillators for small partial counts and inverse-FFT
+// overlap-add synthesis from additive_ifft_threshold() on, where its per-partial cost is lower.
+enum AdditiveStrategy { ADDITIVE_AUTO, ADDITIVE_RECURSIVE, ADDITIVE_IFFT, ADDITIVE_STRATEGY_COUNT };
+
+// Partial count where the IFFT overtakes the recursive kernel of the active ISA
+size_t additive_ifft_threshold();
+
+// Sum of up to ADDITIVE_MAX_PARTIALS sinusoids over one fundamental. Partials at or above
+// Nyquist are skipped. Storage is allocated up front, so nothing allocates after construction.
+class AdditiveOscillator {
+public:
+    explicit AdditiveOscillator(int sampleRate = DEFAULT_SAMPLE_RATE);
+    ~AdditiveOscillator();
+
+    // Partials keep their running phase by index, so editing a timbre while it plays doesn't
+    // click; reset() restarts every partial at its Partial::phase. Extra partials are ignored.
+    void setPartials(const Partial* partials, size_t count);
+    void setFrequency(double frequency);
+    void setAmplitude(float amplitude);
+    void setStrategy(AdditiveStrategy strategy);
+    void reset();
+    // Moves on as if frames had been rendered; the next process() picks up exactly there
+    void skip(uint64_t frames);
+
+    size_t partialCount() const { return m_count; }
+    // The strategy process() uses for the current partial count
+    AdditiveStrategy activeStrategy() const;
+
+    void process(float* out, size_t frames);
+
+private:
+    void updatePartials();
+    void renderRecursive(float* out, size_t frames);
+    void synthesizeFrame(int64_t offset, float* rising, float* falling);
+    void synthesizeHop();
+    void advance(uint64_t frames);
+
+    int m_sampleRate;
+    double m_frequency;
+    float m_amplitude;
+    AdditiveStrategy m_strategy;
+    size_t m_count;
+
+    std::vector<Partial> m_partials;
+    std::vector<uint64_t> m_phases;
+    std::vector<uint64_t> m_increments;
+    std::vector<float> m_gains;
+    std::vector<uint32_t> m_blockPhases;
+    std::vector<uint32_t> m_blockIncrements;
+    std::vector<float> m_block;
+
+    // Overlap-add state: m_ready holds finished samples up to the time the phases point at
+    bool m_primed;
+    std::vector<float> m_ready;
+    size_t m_readyPos;
+    size_t m_readyEnd;
+    std::vector<float> m_overlap;
+    std::vector<float> m_discard;
+    std::vector<detail::Complex> m_spectrum;
+    std::vector<detail::Complex> m_work;
+    std::vector<double> m_frame;
+};
+
+} // namespace tonegen
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <memory>
+
+#include "tonegen/types.h"
+
+namespace tonegen {
+
+// Render-path buffers come from one of these: a single zeroed allocation at construction,
+// handed out in 64-byte aligned slices that live as long as the arena. Slices are only taken
+// while setting up, so nothing on the audio path ever reaches the heap.
+class BufferArena {
+public:
+    explicit BufferArena(size_t bytes);
+    BufferArena(const BufferArena&) = delete;
+    BufferArena& operator=(const BufferArena&) = delete;
+
+    // Throws std::bad_alloc when the arena was sized too small, which is a setup bug
+    template <typename T>
+    T* allocate(size_t count) {
+        return static_cast<T*>(allocateBytes(count * sizeof(T)));
+    }
+
+    size_t used() const { return m_used; }
+    size_t capacity() const { return m_capacity; }
+
+    // Bytes an arena needs for a slice of count elements of T, alignment included
+    template <typename T>
+    static size_t bytesFor(size_t count) {
+        return (count * sizeof(T) + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+    }
+
+private:
+    static const size_t ALIGNMENT = 64;
+
+    void* allocateBytes(size_t bytes);
+
+    std::unique_ptr<unsigned char[]> m_storage;
+    unsigned char* m_base;
+    size_t m_capacity;
+    size_t m_used;
+};
+
+// Heap allocations the calling thread has made. Only counted when the engine is built with
+// TONEGEN_COUNT_ALLOCATIONS (CMake option of that name), which replaces the global operator
+// new for the whole program; otherwise always 0.
+uint64_t thread_allocations();
+bool counting_allocations();
+
+} // namespace tonegen
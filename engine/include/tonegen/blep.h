@@ -0,0 +1,16 @@
+#pragma once
+
+#include "tonegen/types.h"
+
+namespace tonegen {
+
+// Band-limited (PolyBLEP/PolyBLAMP) classic waveforms, branch-free and vectorized.
+// Phases are 32-bit fixed point turns as in sine.h, so any fractional period is exact.
+void saw_block(float* out, size_t frames, uint32_t phase, uint32_t increment, float amplitude);
+void triangle_block(float* out, size_t frames, uint32_t phase, uint32_t increment, float amplitude);
+
+// width is the fraction of each cycle spent high; 0.5 gives a square wave. DC is removed, and
+// the pulse scaled so its taller side peaks at amplitude.
+void pulse_block(float* out, size_t frames, uint32_t phase, uint32_t increment, float amplitude, float width);
+
+} // namespace tonegen
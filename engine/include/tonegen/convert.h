@@ -0,0 +1,29 @@
+#pragma once
+
+#include "tonegen/types.h"
+
+namespace tonegen {
+
+// TPDF dither for the 8- and 16-bit formats: up to 1 LSB of triangular noise either way,
+// which turns rounding error into a steady noise floor instead of distortion that follows
+// the signal. Keeps its place in the noise sequence from one call to the next.
+struct Dither {
+    bool enabled = false;
+    uint32_t seed = 0x2545f491u;
+    uint32_t position = 0;
+};
+
+// Scales, rounds to nearest and saturates, so input beyond [-1, 1] clips instead of wrapping;
+// float output is clamped the same way. Runs on the widest SIMD the CPU has. A dither that is
+// enabled applies to the integer formats and advances by samples either way.
+void convert_samples(const float* in, void* out, SampleFormat format, size_t samples, Dither* dither = nullptr);
+
+void convert_to_int16(const float* in, int16_t* out, size_t samples);
+
+// Writes each mono sample to every channel of an interleaved buffer in the given format.
+// The kernel for the format and channel count is picked once per call. Dither is added
+// after the fan-out, at sample frame * channels + c, and advances by frames * channels.
+void convert_mono_to_interleaved(const float* in, void* out, SampleFormat format, size_t frames, int channels,
+                                 Dither* dither = nullptr);
+
+} // namespace tonegen
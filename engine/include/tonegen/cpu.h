@@ -0,0 +1,20 @@
+#pragma once
+
+namespace tonegen {
+
+// Instruction sets the engine has kernels for, in order of preference on each architecture.
+enum CpuIsa { ISA_SCALAR, ISA_SSE2, ISA_AVX2, ISA_AVX512, ISA_NEON, ISA_COUNT };
+
+const char* isa_name(CpuIsa isa);
+
+// Best ISA this host supports. Setting TONEGEN_ISA=scalar|sse2|avx2|avx512|neon in the
+// environment caps the choice, which is useful for comparing kernels on one machine.
+CpuIsa detect_isa();
+bool isa_supported(CpuIsa isa);
+
+// ISA the kernels are currently dispatched to. set_active_isa() returns false and keeps
+// the current selection when the host can't run the requested ISA.
+CpuIsa active_isa();
+bool set_active_isa(CpuIsa isa);
+
+} // namespace tonegen
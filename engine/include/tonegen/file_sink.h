@@ -0,0 +1,104 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "tonegen/types.h"
+
+namespace tonegen {
+
+// WAV becomes RF64 by itself if it outgrows 4 GB; RF64 is RF64 from the start; W64 (Sony
+// Wave64) has 64-bit sizes throughout; RAW is headerless interleaved PCM
+enum FileType { FILE_WAV, FILE_RF64, FILE_W64, FILE_RAW, FILE_TYPE_COUNT };
+
+// Each buffer the writer thread writes in one go; two of them keep the disk busy while the
+// next one fills
+const size_t FILE_SINK_BUFFER_BYTES = 4 * 1024 * 1024;
+const size_t FILE_SINK_BUFFERS = 2;
+
+// From the extension: .rf64, .w64, .raw or .pcm, anything else WAV
+FileType file_type_for(const std::string& path);
+
+struct FileSinkStats {
+    uint64_t bytes = 0;       // Audio written so far, headers excluded
+    double writeSeconds = 0;  // Writer thread time spent in the write calls
+    double waitSeconds = 0;   // Time writers spent waiting for a free buffer, summed
+    uint64_t waits = 0;       // Writes that had to wait for one
+};
+
+// Streams interleaved frames to an audio file through a fixed set of buffers and a writer
+// thread, so memory stays the same however long the file gets. write() only copies into a
+// buffer and waits only when every buffer is still queued for the disk. The header is
+// written with placeholder sizes at open() and patched at close().
+class FileSink {
+public:
+    explicit FileSink(size_t bufferBytes = FILE_SINK_BUFFER_BYTES, size_t buffers = FILE_SINK_BUFFERS);
+    ~FileSink();
+
+    FileSink(const FileSink&) = delete;
+    FileSink& operator=(const FileSink&) = delete;
+
+    // Creates or truncates path; false with error() set when it can't
+    bool open(const std::string& path, FileType type, int sampleRate, size_t channels, SampleFormat format);
+    // Drains the buffers and finishes the header; false if any write failed on the way
+    bool close();
+    bool isOpen() const { return m_file != nullptr; }
+
+    // Appends frames after the furthest frame written so far
+    bool write(const void* data, size_t frames);
+    // Frames starting at frame, for chunks that arrive out of order (render_offline). Safe to
+    // call from several threads at once.
+    bool writeAt(uint64_t frame, const void* data, size_t frames);
+
+    size_t frameBytes() const { return m_frameBytes; }
+    uint64_t frames() const { return m_endBytes / m_frameBytes; }
+    // Why open() or close() failed
+    const std::string& error() const { return m_error; }
+    FileSinkStats stats();
+
+private:
+    struct Buffer {
+        std::unique_ptr<uint8_t[]> data;
+        uint64_t offset; // From the start of the audio data
+        size_t bytes;
+    };
+
+    void run();
+    bool writeBytes(uint64_t offset, const uint8_t* data, size_t bytes);
+    // Hands m_filling to the writer thread
+    void submit();
+    std::vector<uint8_t> header(uint64_t dataBytes) const;
+    bool writeFile(uint64_t position, const void* data, size_t bytes);
+    bool fail(const char* what, int error);
+
+    size_t m_bufferBytes;
+    std::vector<Buffer> m_buffers;
+    FileType m_type;
+    int m_sampleRate;
+    size_t m_channels;
+    SampleFormat m_format;
+    size_t m_frameBytes;
+    std::FILE* m_file;
+    std::string m_path;
+    std::string m_error;
+    uint64_t m_headerBytes;
+    uint64_t m_endBytes; // Furthest byte of audio written
+
+    // Buffers move free -> filling -> queued -> writing -> free
+    std::mutex m_mutex;
+    std::condition_variable m_changed;
+    std::vector<Buffer*> m_free;
+    std::vector<Buffer*> m_queue; // Oldest first
+    Buffer* m_filling;
+    bool m_stop;
+    bool m_failed;
+    FileSinkStats m_stats;
+    std::thread m_thread;
+};
+
+} // namespace tonegen
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <vector>
+
+#include "tonegen/types.h"
+
+namespace tonegen {
+
+// Second-order sections from the RBJ Audio EQ Cookbook
+enum FilterType { FILTER_LOWPASS, FILTER_HIGHPASS, FILTER_BANDPASS, FILTER_NOTCH, FILTER_LOW_SHELF,
+                  FILTER_HIGH_SHELF, FILTER_PEAK, FILTER_TYPE_COUNT };
+
+struct FilterStage {
+    FilterType type = FILTER_LOWPASS;
+    double frequency = 1000; // Cutoff, center or shelf midpoint in Hz
+    double q = 0.7071;       // For bandpass, notch and peak: center frequency / bandwidth
+    float gainDb = 0;        // Shelves and peak only
+};
+
+// Normalized so a0 == 1: y = b0 x + b1 x[-1] + b2 x[-2] - a1 y[-1] - a2 y[-2]
+struct BiquadCoefficients {
+    double b0, b1, b2, a1, a2;
+};
+
+BiquadCoefficients biquad_coefficients(const FilterStage& stage, int sampleRate);
+
+// A bandpass, notch or peak stage spanning low..high Hz, centered on their geometric mean
+FilterStage band_stage(FilterType type, double low, double high, float gainDb = 0);
+
+// A Butterworth highpass at low and lowpass at high, count / 2 sections each; returns how
+// many stages were written
+size_t band_pass_stages(double low, double high, FilterStage* out, size_t count);
+
+// An order 2 * count Butterworth band-stop, -3 dB at low and high and steeper with every
+// section; returns how many sections were written. Its sections have their poles off the
+// center frequency, so they can't be written as cookbook notches.
+size_t band_stop_sections(double low, double high, int sampleRate, BiquadCoefficients* out, size_t count);
+
+const size_t FILTER_MAX_STAGES = 8;
+// Stage k runs k frames behind stage 0 so that the whole cascade fits one set of SIMD
+// registers; the price is this fixed delay while the bank is active
+const size_t FILTER_LATENCY = FILTER_MAX_STAGES - 1;
+// Coefficient changes glide linearly over this many frames
+const size_t FILTER_RAMP_FRAMES = 512;
+
+// The same cascade of up to FILTER_MAX_STAGES biquads on every channel of interleaved
+// frames. Storage is sized at construction; nothing allocates afterwards.
+class FilterBank {
+public:
+    explicit FilterBank(int sampleRate = DEFAULT_SAMPLE_RATE, size_t channels = 1);
+
+    // Safe while audio plays: coefficients ramp to the new response, and every point along
+    // the way is a stable filter. The bank passes audio through untouched, without the
+    // latency, until it first gets stages; from then on it keeps running, even with none.
+    void setStages(const FilterStage* stages, size_t count);
+    void setSections(const BiquadCoefficients* sections, size_t count);
+    size_t stageCount() const { return m_count; }
+    size_t channels() const { return m_channels; }
+
+    // Clears the filter state and jumps straight to the current stages
+    void reset();
+
+    void process(float* frames, size_t count);
+
+private:
+    int m_sampleRate;
+    size_t m_channels;
+    size_t m_count;
+    bool m_bypass;
+    size_t m_rampLeft;
+
+    // Per block of channels: coefficients, their targets and per-frame steps, then the
+    // state, in the lane layout of the kernels
+    std::vector<float> m_coefficients;
+    std::vector<float> m_targets;
+    std::vector<float> m_deltas;
+    std::vector<float> m_state;
+};
+
+} // namespace tonegen
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <list>
+#include <memory>
+#include <vector>
+
+#include "tonegen/types.h"
+
+namespace tonegen {
+
+// Loops are padded with whole periods to at least this long, so a player wraps rarely
+const size_t LOOP_MIN_FRAMES = 4096;
+// Longest single period the cache renders
+const double LOOP_MAX_SECONDS = 10;
+const size_t DEFAULT_LOOP_CACHE_BYTES = 16 * 1024 * 1024;
+
+// Frames in the shortest loop that holds a whole number of cycles of frequency: sampleRate
+// over gcd(sampleRate, frequency), counting the frequency in millihertz. 0 when it isn't a
+// whole number of millihertz or the loop would be longer than maxFrames.
+size_t exact_loop_frames(double frequency, int sampleRate, size_t maxFrames);
+
+// The same for everything params make, or 0 unless the output is strictly periodic: a
+// periodic wave or BINAURAL_BEATS with no modulation. Noise has no period, and WAVETABLE
+// and ADDITIVE depend on state ToneParams doesn't hold.
+size_t exact_loop_frames(const ToneParams& params, int sampleRate, size_t maxFrames);
+
+// A steady tone rendered once and converted to one device format, ready to play by copying
+// or by handing it to the device to repeat (OpenAlStream::startLoop)
+struct ToneLoop {
+    ToneParams params;
+    SampleFormat format;
+    size_t channels;
+    size_t periodFrames; // Shortest exact loop; frames is a whole number of these
+    size_t frames;
+    std::vector<uint8_t> data;
+
+    size_t frameBytes() const { return bytes_per_sample(format) * channels; }
+    // Copies count frames from position onwards, wrapping as often as needed; returns the
+    // position to carry on from
+    size_t copy(void* out, size_t count, size_t position) const;
+};
+
+// Renders loops for strictly periodic ToneParams and keeps the most recently used ones, up
+// to capacityBytes, so going back to an earlier preset is a lookup. find() renders on a miss,
+// which allocates: call it from the UI thread, not an audio callback.
+class LoopCache {
+public:
+    LoopCache(int sampleRate, size_t channels, SampleFormat format, size_t capacityBytes = DEFAULT_LOOP_CACHE_BYTES);
+
+    // The loop for params, or null when they aren't strictly periodic or the loop wouldn't
+    // fit. Loops handed out stay valid after they are evicted.
+    std::shared_ptr<const ToneLoop> find(const ToneParams& params);
+
+    void clear();
+    size_t size() const { return m_loops.size(); }
+    size_t bytes() const { return m_bytes; }
+    uint64_t hits() const { return m_hits; }
+    uint64_t misses() const { return m_misses; }
+
+private:
+    int m_sampleRate;
+    size_t m_channels;
+    SampleFormat m_format;
+    size_t m_capacityBytes;
+    std::list<std::shared_ptr<const ToneLoop>> m_loops; // Most recently used first
+    size_t m_bytes;
+    uint64_t m_hits;
+    uint64_t m_misses;
+};
+
+} // namespace tonegen
@@ -0,0 +1,74 @@
+#pragma once
+
+#include "tonegen/phase.h"
+
+namespace tonegen {
+
+// LFOs and envelopes are evaluated once every CONTROL_FRAMES frames; gain is interpolated
+// linearly between those points at audio rate and pitch holds for a segment
+const size_t CONTROL_FRAMES = 32;
+// Rise and fall time of LFO_ISOCHRONIC pulses, shortened if the pulse is too short for it
+const double ISOCHRONIC_EDGE_SECONDS = 0.005;
+
+// Value of the LFO at turns into its cycle, in [-1, 1]
+float lfo_value(const Lfo& lfo, double turns);
+
+// Evaluates ModulationParams along the output timeline. Frames are counted from reset(), so
+// the control points land in the same places however the output is split into blocks.
+class Modulator {
+public:
+    explicit Modulator(int sampleRate = DEFAULT_SAMPLE_RATE);
+
+    // Takes effect at the next control point; LFO phases carry on
+    void setParams(const ModulationParams& params);
+    // Restarts the LFOs at their start phases and the envelope at its attack
+    void reset();
+    // Starts the envelope's release; the gain stays at zero once it finishes
+    void noteOff();
+
+    bool modulatesAmplitude() const { return m_params.amplitude.depth != 0 || m_gain != 1 || m_nextGain != 1; }
+    bool modulatesPitch() const { return m_params.pitch.depth != 0; }
+    // The released envelope has reached silence
+    bool finished() const { return m_stage == ENVELOPE_DONE && m_gain == 0; }
+
+    // Frames until the next control point, and the pitch multiplier held until then
+    size_t segmentFrames() const { return CONTROL_FRAMES - m_offset; }
+    double pitchRatio() const { return m_pitch; }
+
+    // Applies the gain to the next frames of interleaved audio and moves along the timeline
+    void process(float* out, size_t frames, size_t channels = 1);
+    // Moves along the timeline without touching any audio
+    void advance(size_t frames);
+
+private:
+    enum EnvelopeStage { ENVELOPE_ATTACK, ENVELOPE_DECAY, ENVELOPE_SUSTAIN, ENVELOPE_RELEASE, ENVELOPE_DONE };
+
+    // Steps over each control point crossed, appending the gain there to points if given
+    void advance(size_t frames, float* points, size_t& count);
+    float currentGain() const;
+    double currentPitch() const;
+    // Moves the LFOs and the envelope one control segment on
+    void stepState();
+    // Moves past envelope stages that are already over
+    void settle();
+    float envelopeStep(float seconds) const;
+
+    int m_sampleRate;
+    ModulationParams m_params;
+    PhaseAccumulator m_amplitudePhase; // Advances by one control segment per step
+    PhaseAccumulator m_pitchPhase;
+    EnvelopeStage m_stage;
+    float m_level;
+    float m_releaseStep;
+    size_t m_offset; // Frames into the current segment
+
+    // The LFOs and the envelope stand at the end of the current segment; these hold the
+    // values at its start and end
+    float m_gain;
+    float m_nextGain;
+    double m_pitch;
+    // Control points for one process() call of up to MAX_BLOCK_FRAMES
+    float m_points[MAX_BLOCK_FRAMES / CONTROL_FRAMES + 2];
+};
+
+} // namespace tonegen
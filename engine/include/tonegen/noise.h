@@ -0,0 +1,67 @@
+#pragma once
+
+#include "tonegen/types.h"
+
+namespace tonegen {
+
+// Spectral slopes: pink -3 dB/octave, brown -6, blue +3, violet +6
+enum NoiseColor { NOISE_WHITE, NOISE_PINK, NOISE_BROWN, NOISE_BLUE, NOISE_VIOLET, NOISE_COLOR_COUNT };
+
+// Colored noise is scaled to this RMS (-14 dBFS) and clipped at full scale, about 5 sigma
+const float NOISE_COLOR_RMS = 0.2f;
+// Voss-McCartney rows; the slowest one changes every 2^PINK_NOISE_ROWS samples
+const size_t PINK_NOISE_ROWS = 16;
+// The white noise kernels render whole groups; aligned positions and lengths skip the copies
+const size_t NOISE_GROUP_FRAMES = 64;
+// Brown noise is integrated white noise with a leak below this frequency, so it can't drift
+const double BROWN_NOISE_CORNER = 10.0;
+
+// Counter-based white noise (Philox4x32-10), uniform in [-1, 1). Sample n of a seed is a pure
+// function of (seed, n), so any range can be rendered on its own, in any order or in parallel,
+// and every ISA produces the same bits.
+void white_noise_block(float* out, size_t frames, uint64_t seed, uint64_t position, float amplitude);
+
+// One noise stream with a position that can be moved anywhere. White, pink, blue and violet
+// are pure functions of the seed and the position, so seek() lands on exactly the samples a
+// continuous render would produce; brown replays its integrator over the leak's settling time
+// and matches to float precision. Nothing allocates.
+class NoiseGenerator {
+public:
+    explicit NoiseGenerator(int sampleRate = DEFAULT_SAMPLE_RATE, uint64_t seed = 0);
+
+    void setColor(NoiseColor color);
+    // Keeps the position
+    void setSeed(uint64_t seed);
+    void setAmplitude(float amplitude);
+    void seek(uint64_t position);
+
+    NoiseColor color() const { return m_color; }
+    uint64_t seed() const { return m_seed; }
+    uint64_t position() const { return m_position; }
+
+    void process(float* out, size_t frames);
+
+private:
+    double rowValue(size_t row, uint64_t index);
+    double whiteSample(uint64_t position);
+
+    int m_sampleRate;
+    NoiseColor m_color;
+    uint64_t m_seed;
+    float m_amplitude;
+    uint64_t m_position;
+
+    // Pink rows as of the previous sample, plus one cached group of values per row
+    double m_rows[PINK_NOISE_ROWS];
+    double m_rowSum;
+    uint64_t m_rowGroups[PINK_NOISE_ROWS];
+    float m_rowCache[PINK_NOISE_ROWS][NOISE_GROUP_FRAMES];
+
+    // Previous unscaled pink or white sample for blue and violet, integrator for brown
+    double m_previous;
+    double m_brown;
+    double m_leak;
+    float m_scratch[MAX_BLOCK_FRAMES];
+};
+
+} // namespace tonegen
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "tonegen/types.h"
+
+namespace tonegen {
+
+// Long renders are split into chunks this long unless asked otherwise
+const double OFFLINE_CHUNK_SECONDS = 10;
+
+// One tone rendered start to finish, as fast as the CPU allows
+struct OfflineJob {
+    ToneParams params;
+    int sampleRate = DEFAULT_SAMPLE_RATE;
+    size_t channels = 1; // Up to MAX_CHANNELS
+    SampleFormat format = SAMPLE_INT16;
+    bool dither = false;
+    uint64_t frames = 0;
+};
+
+// Takes each finished chunk of interleaved frames starting at frame. Chunks arrive out of
+// order and from several workers at once.
+typedef void (*ChunkWriter)(void* user, uint64_t frame, const void* data, size_t frames);
+
+struct OfflineStats {
+    uint64_t frames = 0;
+    size_t threads = 0;
+    size_t chunks = 0;
+    double wallSeconds = 0;
+    double busySeconds = 0; // Rendering time summed over the workers, writing excluded
+
+    // Seconds of audio per second of wall time
+    double realTimeFactor(int sampleRate) const {
+        return wallSeconds > 0 ? static_cast<double>(frames) / sampleRate / wallSeconds : 0;
+    }
+};
+
+// Renders job in chunks of chunkFrames on threads workers (0 for one per core). Each chunk
+// starts from ToneGenerator::seek, so it needs nothing from the one before and the result
+// matches one continuous render to within float rounding. Only the workers' generators and
+// one chunk buffer each are allocated.
+OfflineStats render_offline(const OfflineJob& job, size_t threads, size_t chunkFrames, ChunkWriter write, void* user);
+
+} // namespace tonegen
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <string>
+
+#include <AL/al.h>
+#include <AL/alc.h>
+
+#include "tonegen/types.h"
+
+namespace tonegen {
+
+// An OpenAL Soft device with no sound card behind it (ALC_SOFT_loopback): the mixer runs only
+// when render() asks, so sources and OpenAlStream play through the whole OpenAL path and the
+// mix comes back as fast as the CPU allows, on machines without audio hardware
+class OpenAlLoopback {
+public:
+    OpenAlLoopback();
+    ~OpenAlLoopback();
+
+    OpenAlLoopback(const OpenAlLoopback&) = delete;
+    OpenAlLoopback& operator=(const OpenAlLoopback&) = delete;
+
+    // Opens the device and makes current a context that mixes channels (1, 2, 4, 6, 7 or 8)
+    // of format at sampleRate; false with error() saying why when OpenAL can't
+    bool open(int sampleRate, size_t channels, SampleFormat format);
+    void close();
+    bool isOpen() const { return m_context != nullptr; }
+
+    // Mixes the next frames of every playing source into out, interleaved in the format
+    // given to open(); callback buffers render from inside this call. Nothing unless open.
+    void render(void* out, size_t frames);
+
+    ALCdevice* device() const { return m_device; }
+    ALCcontext* context() const { return m_context; }
+    size_t frameBytes() const { return m_frameBytes; }
+    // Mixed since open()
+    uint64_t frames() const { return m_frames; }
+    const std::string& error() const { return m_error; }
+
+private:
+    typedef ALCdevice*(ALC_APIENTRY* LoopbackOpenDevice)(const ALCchar* name);
+    typedef ALCboolean(ALC_APIENTRY* IsRenderFormatSupported)(ALCdevice* device, ALCsizei rate, ALCenum channels,
+                                                              ALCenum type);
+    typedef void(ALC_APIENTRY* RenderSamples)(ALCdevice* device, ALCvoid* buffer, ALCsizei samples);
+
+    bool fail(const std::string& message);
+
+    ALCdevice* m_device;
+    ALCcontext* m_context;
+    RenderSamples m_renderSamples;
+    size_t m_frameBytes;
+    uint64_t m_frames;
+    std::string m_error;
+};
+
+} // namespace tonegen
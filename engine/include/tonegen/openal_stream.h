@@ -0,0 +1,127 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <AL/al.h>
+#include <AL/alc.h>
+
+#include "tonegen/allocation.h"
+#include "tonegen/loop_cache.h"
+#include "tonegen/realtime.h"
+#include "tonegen/tone_generator.h"
+
+namespace tonegen {
+
+// OpenAL Soft mixes this many frames at a time unless asked otherwise
+const size_t OPENAL_DEFAULT_PERIOD_FRAMES = 1024;
+
+// Attributes for alcCreateContext, zero-terminated. Periods shorter than the default ask the
+// device to mix at sampleRate in periods of periodFrames (ALC_REFRESH), or the 1024-frame
+// default alone puts tens of milliseconds under a short buffer queue. Longer periods keep
+// the default attributes: a low refresh rate would only make the device periods longer.
+std::vector<ALCint> openal_context_attributes(int sampleRate, size_t periodFrames);
+
+// How long audio rendered now waits before it is heard, as last measured
+struct StreamLatency {
+    double queuedSeconds = 0; // Rendered and still in the source's buffer queue
+    double deviceSeconds = 0; // Mixed and on its way out of the device; 0 without AL_SOFT_source_latency
+    double totalSeconds() const { return queuedSeconds + deviceSeconds; }
+};
+
+// Plays a ToneGenerator through an OpenAL source without any help from the UI thread.
+// With AL_SOFT_callback_buffer the OpenAL mixer pulls blocks straight from the generator;
+// otherwise a streaming thread refills a queue of bufferCount buffers and sleeps until the
+// next one is due, going by the source's playback offset. Once start()ed the generator
+// belongs to whichever of those renders: change it with publishParams and publishFilter.
+// Create it with the context current; the source and buffers live as long as it does.
+// For low latency, use a few short buffers (64-256 frames) and a context made with
+// openal_context_attributes for the same period.
+// Buffers hold float samples when the implementation has AL_EXT_FLOAT32, which keeps the
+// generator's output as rendered and leaves rounding to the mixer; 16-bit otherwise.
+class OpenAlStream {
+public:
+    OpenAlStream(ToneGenerator& generator, size_t bufferFrames, size_t bufferCount);
+    ~OpenAlStream();
+
+    // False if OpenAL has no format for the generator's channel count
+    bool start();
+    // Plays a steady tone from one buffer the source repeats (AL_LOOPING): nothing renders
+    // and no thread wakes until stop(). Take the loop from a LoopCache made with this
+    // stream's sampleFormat() and the generator's channel count; false for any other.
+    bool startLoop(const ToneLoop& loop);
+    void stop();
+    bool playing() const { return m_playing; }
+    bool looping() const { return m_looping; }
+
+    // The callback path is used when the implementation offers it, unless told otherwise
+    void setUseCallback(bool use) { m_allowCallback = use; }
+    bool usesCallback() const { return m_usingCallback; }
+
+    // With manual refill the queue path starts no thread: the owner calls refill() instead,
+    // as a driver of an OpenAlLoopback device does between renders. Applies at the next start().
+    void setManualRefill(bool manual) { m_manualRefill = manual; }
+    // One pass of the streaming thread: refills and requeues the buffers that have played,
+    // restarts a source that ran dry (counted as an underrun) and measures the latency.
+    // Returns the seconds until the head buffer is done.
+    double refill();
+
+    // Applied by the streaming thread when it next starts; the callback path runs on the
+    // OpenAL mixer thread, whose priority is OpenAL Soft's business (rt-prio in alsoft.conf)
+    void setRealtime(const RealtimeOptions& options) { m_realtimeOptions = options; }
+    RealtimeStatus realtimeStatus();
+
+    ALuint source() const { return m_source; }
+    size_t bufferFrames() const { return m_bufferFrames; }
+    size_t bufferCount() const { return m_buffers.size(); }
+    SampleFormat sampleFormat() const { return m_sampleFormat; }
+    // Measured by the streaming thread after each refill, or asked of the source on the
+    // callback path, where nothing waits in a queue
+    StreamLatency latency() const;
+    // Times the queue ran dry and the source had to be restarted
+    uint64_t underruns() const { return m_underruns.load(std::memory_order_relaxed); }
+    // Heap allocations made while rendering; counted with TONEGEN_COUNT_ALLOCATIONS only
+    uint64_t allocations() const { return m_allocations.load(std::memory_order_relaxed); }
+
+private:
+    typedef void(AL_APIENTRY* GetSourcedv)(ALuint source, ALenum param, ALdouble* values);
+
+    void run();
+    // Seconds played of the buffer at the head of the queue, and the device latency when known
+    double playbackOffset(double* deviceLatency) const;
+    void fill(ALuint buffer);
+    void render(void* out, size_t frames);
+    static ALsizei AL_APIENTRY renderCallback(ALvoid* stream, ALvoid* data, ALsizei bytes);
+
+    ToneGenerator& m_generator;
+    size_t m_bufferFrames;
+    SampleFormat m_sampleFormat;
+    size_t m_frameBytes;
+    ALenum m_format;
+    ALuint m_source;
+    std::vector<ALuint> m_buffers;
+    BufferArena m_arena;
+    uint8_t* m_samples; // One buffer's worth, from m_arena
+    bool m_playing;
+    bool m_looping;
+    bool m_allowCallback;
+    bool m_usingCallback;
+    bool m_manualRefill;
+    GetSourcedv m_getSourcedv; // From AL_SOFT_source_latency, for a finer playback offset
+    std::atomic<uint64_t> m_underruns;
+    std::atomic<uint64_t> m_allocations;
+    std::atomic<double> m_queuedSeconds;
+    std::atomic<double> m_deviceSeconds;
+    RealtimeOptions m_realtimeOptions;
+    RealtimeStatus m_realtimeStatus; // Guarded by m_mutex
+
+    std::atomic<bool> m_stop;
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::thread m_thread;
+};
+
+} // namespace tonegen
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "tonegen/noise.h"
+#include "tonegen/phase.h"
+#include "tonegen/wavetable.h"
+
+namespace tonegen {
+
+// State for one oscillator, mono or interleaved across up to MAX_CHANNELS channels.
+// process() renders the next block and advances the phase; it never allocates.
+class Oscillator {
+public:
+    explicit Oscillator(int sampleRate = DEFAULT_SAMPLE_RATE);
+
+    void setWaveType(WaveType waveType);
+    void setFrequency(double frequency);
+    // Plays the frequency set last times ratio; cheap enough to call every control segment
+    void setPitchRatio(double ratio);
+    void setAmplitude(float amplitude);
+    void setSineAccuracy(SineAccuracy accuracy);
+    // Clamped to [0, 1]
+    void setPulseWidth(float width);
+    // Table for WAVETABLE; copying only shares the handle
+    void setWavetable(const Wavetable& table);
+    void setNoiseSeed(uint64_t seed);
+    // Frames of process() hold this many interleaved channels. Each channel runs its own phase,
+    // started phase turns after channel 0 and detuned by frequency Hz; moving the offset while
+    // playing shifts the channel by the difference. Noise is the same on every channel.
+    void setChannels(size_t channels);
+    void setChannelOffset(size_t channel, double frequency, double phase);
+    // Restarts the phase and the noise at sample zero
+    void reset();
+    // Moves on as if frames had been rendered at the current pitch, in constant time for the
+    // periodic waves; noise seeks
+    void skip(uint64_t frames);
+
+    WaveType waveType() const { return m_waveType; }
+    double frequency() const { return m_frequency; }
+    int sampleRate() const { return m_sampleRate; }
+    size_t channels() const { return m_channels; }
+
+    void process(float* out, size_t frames);
+
+private:
+    void renderPeriodic(float* out, size_t frames);
+    void renderInterleaved(float* out, size_t frames);
+    void updateIncrements(double ratio);
+
+    int m_sampleRate;
+    WaveType m_waveType;
+    double m_frequency;
+    size_t m_channels;
+    float m_amplitude;
+    SineAccuracy m_sineAccuracy;
+    float m_pulseWidth;
+    Wavetable m_wavetable;
+    // Per channel: the phase, increment at a pitch ratio of 1 and offsets from channel 0
+    PhaseAccumulator m_phases[MAX_CHANNELS];
+    uint64_t m_baseIncrements[MAX_CHANNELS];
+    double m_detune[MAX_CHANNELS];
+    uint64_t m_phaseOffsets[MAX_CHANNELS];
+    NoiseGenerator m_noise;
+    float m_scratch[MAX_BLOCK_FRAMES];
+};
+
+} // namespace tonegen
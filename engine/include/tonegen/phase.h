@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cmath>
+
+#include "tonegen/types.h"
+
+namespace tonegen {
+
+// 64-bit fixed point turns: 2^64 is one cycle, so wrapping is plain unsigned overflow and
+// the phase after n samples is exactly start + n * increment. The only drift against the
+// ideal tone is the rounding of frequency / sampleRate to a double, which stays well under
+// a millionth of a cycle over a 24 hour render.
+inline uint64_t phase_increment(double frequency, double sampleRate) {
+    double turns = frequency / sampleRate;
+    turns -= std::floor(turns); // negative and above-Nyquist frequencies alias like a real oscillator
+    const double scaled = std::ldexp(turns, 64);
+    return scaled >= 18446744073709551616.0 ? 0 : static_cast<uint64_t>(scaled);
+}
+
+struct PhaseAccumulator {
+    uint64_t phase = 0;
+    uint64_t increment = 0;
+
+    void setFrequency(double frequency, double sampleRate) { increment = phase_increment(frequency, sampleRate); }
+    void advance(size_t frames) { phase += increment * frames; }
+
+    // Top bits for the 32-bit SIMD kernels; blocks are short enough that the rounded
+    // increment can't drift before the next block resyncs from the 64-bit phase
+    uint32_t phase32() const { return static_cast<uint32_t>(phase >> 32); }
+    uint32_t increment32() const { return static_cast<uint32_t>((increment + (uint64_t(1) << 31)) >> 32); }
+
+    double turns() const { return std::ldexp(static_cast<double>(phase), -64); }
+    double incrementTurns() const { return std::ldexp(static_cast<double>(increment), -64); }
+};
+
+} // namespace tonegen
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <string>
+
+#include "tonegen/types.h"
+
+namespace tonegen {
+
+// Opt-in real-time setup for a thread that renders audio (RenderThread, OpenAlStream)
+struct RealtimeOptions {
+    bool enabled = false;
+    int priority = 0;           // SCHED_FIFO priority; 0 picks DEFAULT_REALTIME_PRIORITY
+    int cpu = -1;               // CPU to pin the thread to, -1 for any
+    bool lockMemory = true;     // mlockall, so nothing the process has or gets is paged out
+    size_t stackBytes = 256 * 1024; // Stack touched up front, so the render loop never faults on it
+};
+
+// Below the audio server's own threads (PipeWire and PulseAudio use 20) but above everything else
+const int DEFAULT_REALTIME_PRIORITY = 10;
+
+// What enter_realtime got. Each step is tried on its own, so a denied one leaves the others
+// in place; message says what was denied and why, empty when everything asked for was granted.
+struct RealtimeStatus {
+    bool requested = false;
+    bool scheduled = false;    // Running SCHED_FIFO
+    bool niced = false;        // SCHED_FIFO was denied, but the thread got a higher nice priority
+    bool memoryLocked = false;
+    bool pinned = false;
+    int priority = 0;
+    std::string message;
+};
+
+// Applies options to the calling thread. Does nothing unless options.enabled; never fails
+// harder than reporting what it could not do.
+RealtimeStatus enter_realtime(const RealtimeOptions& options);
+
+// Command-line opt-in shared by the frontends: "--realtime", "--realtime=CPU" to also pin the
+// thread, and "--realtime-priority=N". Returns false, untouched, for any other argument.
+bool parse_realtime_option(const char* arg, RealtimeOptions& options);
+
+// One line for a status display, such as "RT 10, locked, pinned" or "nice -10 (SCHED_FIFO
+// denied, ...)"; empty when real time wasn't requested
+std::string describe_realtime(const RealtimeStatus& status);
+
+} // namespace tonegen
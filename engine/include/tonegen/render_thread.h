@@ -0,0 +1,85 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include "tonegen/allocation.h"
+#include "tonegen/realtime.h"
+#include "tonegen/ring_buffer.h"
+#include "tonegen/tone_generator.h"
+
+namespace tonegen {
+
+// Ring occupancy as seen by the audio callback
+struct RenderStatus {
+    size_t bufferedFrames = 0; // Queued right now
+    size_t lowestFrames = 0;   // Fewest queued at any read since the previous status()
+    size_t aheadFrames = 0;    // Target the producer keeps topping up to
+    size_t maxAheadFrames = 0; // Most setRenderAhead accepts
+    uint64_t underruns = 0; // Reads that came up short and were padded with silence
+    uint64_t allocations = 0; // Heap allocations while rendering; counted with TONEGEN_COUNT_ALLOCATIONS only
+};
+
+// Renders a ToneGenerator ahead of the audio device on a producer thread, converted to the
+// device format, into a RingBuffer the device callback only copies out of. Once start()ed the
+// generator belongs to the producer: other threads change it through publishParams and
+// publishFilter, which it picks up when it next renders, up to the render-ahead depth later.
+class RenderThread {
+public:
+    // setRenderAhead moves up to maxAheadFrames (at least aheadFrames); the ring holds twice
+    // that, so a restart can render fresh audio behind the stale audio it replaces
+    RenderThread(ToneGenerator& generator, SampleFormat format, size_t aheadFrames, size_t maxAheadFrames = 0);
+    ~RenderThread();
+
+    void start();
+    void stop();
+    bool running() const { return m_thread.joinable(); }
+
+    // Applied by the producer thread when it next starts
+    void setRealtime(const RealtimeOptions& options) { m_realtimeOptions = options; }
+    // What the producer got, once it is running
+    RealtimeStatus realtimeStatus();
+
+    void setRenderAhead(size_t frames);
+    size_t renderAhead() const { return m_aheadFrames.load(std::memory_order_relaxed); }
+    size_t frameBytes() const { return m_frameBytes; }
+
+    // Drops the queued audio and restarts the generator at phase zero; reads pick up the
+    // fresh audio as soon as the producer has rendered it
+    void restart();
+
+    // Audio callback side: copies frames out of the ring, pads any shortfall with silence
+    // and returns how many frames were real audio. Wait-free.
+    size_t read(void* out, size_t frames);
+
+    RenderStatus status();
+
+private:
+    void run();
+
+    ToneGenerator& m_generator;
+    SampleFormat m_format;
+    size_t m_frameBytes;
+    RingBuffer<uint8_t> m_ring;
+    // One converted block, for the producer
+    BufferArena m_arena;
+    uint8_t* m_converted;
+    std::atomic<size_t> m_aheadFrames;
+    std::atomic<bool> m_stop;
+    std::atomic<bool> m_restart;
+    // Ring position the consumer skips to after a restart, plus one; zero when there is none
+    std::atomic<size_t> m_discardUntil;
+    std::atomic<size_t> m_lowestBytes;
+    std::atomic<uint64_t> m_underruns;
+    std::atomic<uint64_t> m_allocations;
+    RealtimeOptions m_realtimeOptions;
+    RealtimeStatus m_realtimeStatus; // Guarded by m_mutex
+    // The producer sleeps on this between top-ups; restart() and stop() wake it early
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::thread m_thread;
+};
+
+} // namespace tonegen
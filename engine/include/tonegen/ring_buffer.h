@@ -0,0 +1,95 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+#include "tonegen/types.h"
+
+namespace tonegen {
+
+// Wait-free ring for exactly one producer thread and one consumer thread. Storage is
+// allocated at construction, rounded up to a power of two; every call after that is a
+// bounded copy and a few atomic loads and stores.
+template <typename T>
+class RingBuffer {
+    static_assert(std::is_trivially_copyable<T>::value, "RingBuffer copies elements with memcpy");
+
+public:
+    explicit RingBuffer(size_t capacity) : m_storage(round_up(capacity)), m_mask(m_storage.size() - 1) {
+        m_written.store(0, std::memory_order_relaxed);
+        m_read.store(0, std::memory_order_relaxed);
+    }
+
+    size_t capacity() const { return m_storage.size(); }
+    // Either side may ask; the answer is exact for the caller's own side and a lower bound
+    // of free space or queued elements for the other
+    size_t size() const {
+        return m_written.load(std::memory_order_acquire) - m_read.load(std::memory_order_acquire);
+    }
+
+    // Producer side: queues up to count elements and returns how many fitted
+    size_t write(const T* data, size_t count) {
+        const size_t written = m_written.load(std::memory_order_relaxed);
+        const size_t read = m_read.load(std::memory_order_acquire);
+        count = std::min(count, capacity() - (written - read));
+        copy(m_storage.data(), written & m_mask, data, count, true);
+        m_written.store(written + count, std::memory_order_release);
+        return count;
+    }
+    size_t writable() const { return capacity() - size(); }
+    // Total elements ever written, the position the next write starts at
+    size_t writePosition() const { return m_written.load(std::memory_order_acquire); }
+
+    // Consumer side: takes up to count elements and returns how many there were
+    size_t read(T* data, size_t count) {
+        const size_t read = m_read.load(std::memory_order_relaxed);
+        const size_t written = m_written.load(std::memory_order_acquire);
+        count = std::min(count, written - read);
+        copy(data, read & m_mask, m_storage.data(), count, false);
+        m_read.store(read + count, std::memory_order_release);
+        return count;
+    }
+    // Drops everything queued before position, as returned by writePosition()
+    void discardUntil(size_t position) {
+        const size_t read = m_read.load(std::memory_order_relaxed);
+        const size_t written = m_written.load(std::memory_order_acquire);
+        if (position - read <= written - read) {
+            m_read.store(position, std::memory_order_release);
+        }
+    }
+
+private:
+    // Stops at the top bit instead of wrapping to 0, so an impossible capacity fails to
+    // allocate rather than looping forever
+    static size_t round_up(size_t capacity) {
+        size_t size = 1;
+        while (size < capacity && size <= std::numeric_limits<size_t>::max() / 2) {
+            size *= 2;
+        }
+        return size;
+    }
+
+    // Copies count elements between a flat array and the ring starting at offset, wrapping once
+    void copy(T* out, size_t offset, const T* in, size_t count, bool intoRing) {
+        const size_t first = std::min(count, capacity() - offset);
+        if (intoRing) {
+            std::memcpy(out + offset, in, first * sizeof(T));
+            std::memcpy(out, in + first, (count - first) * sizeof(T));
+        } else {
+            std::memcpy(out, in + offset, first * sizeof(T));
+            std::memcpy(out + first, in, (count - first) * sizeof(T));
+        }
+    }
+
+    std::vector<T> m_storage;
+    size_t m_mask;
+    // Each index on its own cache line, so the two threads don't bounce one line between them
+    alignas(64) std::atomic<size_t> m_written;
+    alignas(64) std::atomic<size_t> m_read;
+};
+
+} // namespace tonegen
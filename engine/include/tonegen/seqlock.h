@@ -0,0 +1,76 @@
+#pragma once
+
+#include <atomic>
+#include <cstring>
+#include <type_traits>
+
+#include "tonegen/types.h"
+
+namespace tonegen {
+
+// Readers give up after this many torn reads in a row and keep what they had
+const int SEQLOCK_READ_ATTEMPTS = 4;
+
+// Hands a trivially copyable value from one writer thread to readers that must never block,
+// such as an audio callback. store() never waits; load() retries only while a store is in
+// flight. The value is copied through relaxed atomic words, so a torn read is detected by
+// the sequence check rather than being a data race.
+template <typename T>
+class Seqlock {
+    static_assert(std::is_trivially_copyable<T>::value, "Seqlock values are copied bytewise");
+
+public:
+    Seqlock() : m_sequence(0) {
+        for (std::atomic<uint64_t>& word : m_words) {
+            word.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    // One writer at a time; concurrent writers must serialize among themselves
+    void store(const T& value) {
+        uint64_t words[WORDS] = {};
+        std::memcpy(words, &value, sizeof(T));
+        const uint32_t sequence = m_sequence.load(std::memory_order_relaxed);
+        m_sequence.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        for (size_t i = 0; i < WORDS; ++i) {
+            m_words[i].store(words[i], std::memory_order_relaxed);
+        }
+        m_sequence.store(sequence + 2, std::memory_order_release);
+    }
+
+    // Even, and different after every store(); 0 until the first one
+    uint32_t version() const { return m_sequence.load(std::memory_order_acquire); }
+
+    // Copies the latest value and its version; false, leaving value alone, if stores kept
+    // overlapping the read
+    bool load(T& value, uint32_t* version = nullptr) const {
+        for (int attempt = 0; attempt < SEQLOCK_READ_ATTEMPTS; ++attempt) {
+            const uint32_t before = m_sequence.load(std::memory_order_acquire);
+            if (before & 1) {
+                continue;
+            }
+            uint64_t words[WORDS];
+            for (size_t i = 0; i < WORDS; ++i) {
+                words[i] = m_words[i].load(std::memory_order_relaxed);
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (m_sequence.load(std::memory_order_relaxed) == before) {
+                std::memcpy(&value, words, sizeof(T));
+                if (version) {
+                    *version = before;
+                }
+                return true;
+            }
+        }
+        return false;
+    }
+
+private:
+    static const size_t WORDS = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+    std::atomic<uint32_t> m_sequence;
+    std::atomic<uint64_t> m_words[WORDS];
+};
+
+} // namespace tonegen
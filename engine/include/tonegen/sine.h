@@ -0,0 +1,13 @@
+#pragma once
+
+#include "tonegen/types.h"
+
+namespace tonegen {
+
+// Phases are 32-bit fixed point turns, so wrapping is free and 2^32 is one full cycle.
+// Writes out[i] = amplitude * sin(2*pi * (phase + i * increment) / 2^32) with the kernel
+// for the active ISA (see tonegen/cpu.h).
+void sine_block(float* out, size_t frames, uint32_t phase, uint32_t increment, float amplitude,
+                SineAccuracy accuracy = SINE_BALANCED);
+
+} // namespace tonegen
@@ -0,0 +1,135 @@
+#pragma once
+
+#include "tonegen/additive.h"
+#include "tonegen/allocation.h"
+#include "tonegen/convert.h"
+#include "tonegen/filter.h"
+#include "tonegen/modulation.h"
+#include "tonegen/oscillator.h"
+#include "tonegen/seqlock.h"
+
+namespace tonegen {
+
+// Published amplitude changes ramp, and waveform switches crossfade, over this long
+const double SMOOTHING_SECONDS = 0.01;
+// Published frequency changes glide exponentially, keeping the phase, over this long
+const double GLIDE_SECONDS = 0.02;
+
+// The engine object the frontends drive: owns the oscillators for the current
+// ToneParams and renders blocks of interleaved audio with 1 to MAX_CHANNELS channels.
+// Nothing here allocates after construction, so process() is safe to call from an
+// audio callback. Everything but the publish calls belongs to the thread that calls process().
+class ToneGenerator {
+public:
+    explicit ToneGenerator(int sampleRate = DEFAULT_SAMPLE_RATE, size_t channels = 1);
+
+    // Applies at once, without smoothing
+    void setParams(const ToneParams& params);
+    const ToneParams& params() const { return m_params; }
+    // Used by WAVETABLE; the default is the built-in sine
+    void setWavetable(const Wavetable& table);
+    // Used by ADDITIVE, with frequency as the fundamental; copies into preallocated storage
+    void setPartials(const Partial* partials, size_t count);
+    // Filters the output, e.g. band_stop_sections around the tone to notch noise. Changes
+    // glide in without clicks; the first filter adds FILTER_LATENCY frames of delay.
+    void setFilter(const FilterStage* stages, size_t count);
+    void setFilter(const BiquadCoefficients* sections, size_t count);
+
+    // Safe from one other thread while audio plays, and lock-free on both sides. The next
+    // process() picks up the latest values: frequency glides (ADDITIVE jumps, keeping its
+    // phases), amplitude ramps, and changes of waveform, pulse width, seed or channel phase
+    // crossfade from the old sound. Filters glide as with setFilter.
+    void publishParams(const ToneParams& params);
+    void publishFilter(const FilterStage* stages, size_t count);
+    void publishFilter(const BiquadCoefficients* sections, size_t count);
+
+    int sampleRate() const { return m_sampleRate; }
+    size_t channels() const { return m_channels; }
+
+    // Restarts every oscillator at phase zero, the modulation at its start and clears the
+    // filter; published values apply straight away and any smoothing in progress ends
+    void reset();
+    // reset(), then moves every oscillator, the noise, the modulation timeline and the dither
+    // to frame without rendering, so a render from here continues one started at reset()
+    // (to within float rounding). Cheap for steady pitch; a pitch LFO is replayed one control
+    // segment at a time. Filters start again from silence.
+    void seek(uint64_t frame);
+    // Releases the envelope of ToneParams::modulation; finished() turns true once it is silent
+    void noteOff();
+    bool finished() const { return m_modulator.finished(); }
+
+    // TPDF dither for the 8- and 16-bit outputs of process(); off by default
+    void setDither(bool enabled) { m_dither.enabled = enabled; }
+    bool dither() const { return m_dither.enabled; }
+
+    // frames counts whole frames of channels() samples each
+    void process(float* out, size_t frames);
+    void process(int16_t* out, size_t frames);
+    // Renders and converts a block at a time, saturating, straight into a device buffer
+    void process(void* out, SampleFormat format, size_t frames);
+
+private:
+    struct FilterSections {
+        BiquadCoefficients sections[FILTER_MAX_STAGES];
+        size_t count;
+    };
+
+    // Everything but the amplitude, which goes through setVoiceAmplitude
+    void configure(const ToneParams& params);
+    void setVoiceAmplitude(float amplitude);
+    // Picks up published values; parameters wait in m_pending until a crossfade ends
+    void poll();
+    void applyPending();
+    void render(float* out, size_t frames);
+    // Renders osc, mixing down to mono if it has two channels for mono binaural beats
+    void renderOscillator(Oscillator& osc, float* out, size_t frames);
+    void renderAdditive(float* out, size_t frames);
+    // Fades from the voice being replaced to the new one already in out
+    void crossfade(float* out, size_t frames);
+    void ramp(float* out, size_t frames);
+
+    int m_sampleRate;
+    size_t m_channels;
+    ToneParams m_params;
+    Oscillator m_primary;
+    AdditiveOscillator m_additive;
+    Modulator m_modulator;
+    FilterBank m_filter;
+
+    Seqlock<ToneParams> m_publishedParams;
+    Seqlock<FilterSections> m_publishedFilter;
+    uint32_t m_paramsVersion;
+    uint32_t m_filterVersion;
+    ToneParams m_pending;
+    bool m_hasPending;
+
+    // The voice being crossfaded out: a copy of the primary oscillator as it was, or the
+    // additive oscillator when switching away from ADDITIVE
+    Oscillator m_fading;
+    bool m_fadingAdditive;
+    double m_fadingGlide;
+    size_t m_fadeFrames;
+    size_t m_fadeLeft;
+
+    // Pitch ratio exp(m_glideLog * left / frames) on top of the modulation, held per segment
+    double m_glideLog;
+    double m_glide;
+    size_t m_glideFrames;
+    size_t m_glideLeft;
+    bool m_bent; // The oscillators play at a pitch ratio other than 1
+
+    // The voices play at m_voiceAmplitude; a ramp scales them from m_level by m_levelStep
+    float m_voiceAmplitude;
+    float m_level;
+    float m_levelStep;
+    size_t m_levelLeft;
+
+    // Block buffers, sliced from one arena so the generator itself stays small enough for a stack
+    BufferArena m_arena;
+    float* m_scratch;
+    float* m_fade;
+    float* m_mix; // Mono additive output, or both tones of mono binaural beats
+    Dither m_dither;
+};
+
+} // namespace tonegen
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace tonegen {
+
+const int DEFAULT_SAMPLE_RATE = 44100;
+const float DEFAULT_AMPLITUDE = 32760.0f / 32767.0f; // Same level the frontends used with int16 AMPLITUDE
+
+// Largest block the engine renders at once into its internal scratch buffers
+const size_t MAX_BLOCK_FRAMES = 256;
+// Interleaved output goes up to 7.1
+const size_t MAX_CHANNELS = 8;
+
+// Values are stable because frontends store them in widgets; add new types before WAVE_TYPE_COUNT
+enum WaveType { SINE, SQUARE, WHITE_NOISE, PINK_NOISE, BINAURAL_BEATS, SAW, TRIANGLE, PULSE, WAVETABLE,
+               ADDITIVE, BROWN_NOISE, BLUE_NOISE, VIOLET_NOISE, WAVE_TYPE_COUNT };
+
+enum SampleFormat { SAMPLE_UINT8, SAMPLE_INT16, SAMPLE_INT32, SAMPLE_FLOAT, SAMPLE_FORMAT_COUNT };
+
+inline size_t bytes_per_sample(SampleFormat format) {
+    switch (format) {
+        case SAMPLE_UINT8: return 1;
+        case SAMPLE_INT16: return 2;
+        case SAMPLE_INT32: return 4;
+        case SAMPLE_FLOAT: return 4;
+        default: return 0;
+    }
+}
+
+// Odd minimax polynomials for sin(2*pi*x) after folding x into a quarter turn.
+// Max absolute error against double precision sin, measured across a full cycle on every kernel:
+//   SINE_FAST      degree 5   6.8e-5  (-83 dB)
+//   SINE_BALANCED  degree 7   7.4e-7  (-123 dB)
+//   SINE_PRECISE   degree 9   2.3e-7  (-133 dB, float rounding limit)
+enum SineAccuracy { SINE_FAST, SINE_BALANCED, SINE_PRECISE, SINE_ACCURACY_COUNT };
+
+// Low-frequency shapes, bipolar in [-1, 1]. Phase 0 is the peak, except LFO_ISOCHRONIC: a
+// pulse that starts its rising edge there, with raised-cosine edges so it doesn't click.
+enum LfoShape { LFO_SINE, LFO_TRIANGLE, LFO_SQUARE, LFO_SAW, LFO_ISOCHRONIC, LFO_SHAPE_COUNT };
+
+struct Lfo {
+    LfoShape shape = LFO_SINE;
+    double rate = 0;   // Hz; control-rate evaluation keeps it useful up to a few hundred Hz
+    float depth = 0;   // 0 switches it off
+    float duty = 0.5f; // Fraction of the cycle LFO_SQUARE and LFO_ISOCHRONIC are high
+    float phase = 0;   // Start phase in turns
+};
+
+// Linear ADSR; times in seconds
+struct Envelope {
+    float attack = 0;
+    float decay = 0;
+    float sustain = 1;
+    float release = 0;
+};
+
+struct ModulationParams {
+    Lfo amplitude; // Gain swings between 1 - depth and 1; LFO_ISOCHRONIC at depth 1 gives isochronic tones
+    Lfo pitch;     // Vibrato and slow FM, depth in semitones; periodic waves and BINAURAL_BEATS only
+    Envelope envelope;
+};
+
+struct ToneParams {
+    WaveType waveType = SINE;
+    double frequency = 440;
+    // BINAURAL_BEATS plays frequency and frequency + beatFrequency: on even and odd channels
+    // when there are two or more, mixed together in mono
+    double beatFrequency = 0;
+    double channelPhase = 0; // Phase offset between neighbouring channels, in turns
+    float amplitude = DEFAULT_AMPLITUDE;
+    float pulseWidth = 0.5f; // PULSE duty cycle
+    SineAccuracy sineAccuracy = SINE_BALANCED;
+    uint64_t noiseSeed = 0; // Same seed, same noise: renders are reproducible
+    ModulationParams modulation;
+};
+
+} // namespace tonegen
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "tonegen/types.h"
+
+namespace tonegen {
+
+// Single-cycle tables with one band-limited mip level per octave: level k keeps the
+// harmonics up to WAVETABLE_SIZE / 2 >> k, so the last level is a pure sine.
+const int WAVETABLE_BITS = 11;
+const size_t WAVETABLE_SIZE = size_t(1) << WAVETABLE_BITS;
+const size_t WAVETABLE_LEVELS = WAVETABLE_BITS;
+
+enum WavetableShape { WAVETABLE_SINE, WAVETABLE_SQUARE, WAVETABLE_SAW, WAVETABLE_SHAPE_COUNT };
+
+// A cheap-to-copy handle to a mip chain. Built-in tables are generated at compile time and
+// live in read-only data; custom tables are shared between copies.
+class Wavetable {
+public:
+    // The built-in sine
+    Wavetable();
+
+    static Wavetable builtin(WavetableShape shape);
+
+    // Band-limits one cycle of any length into a full mip chain (resampled to WAVETABLE_SIZE,
+    // DC removed, gain() normalizing the peak to 1). Allocates, so load tables off the audio thread.
+    static Wavetable fromSingleCycle(const float* samples, size_t count);
+
+    // WAVETABLE_SIZE + 1 samples; the last repeats the first for interpolation
+    const float* level(size_t index) const { return m_levels[index]; }
+    // Scale that brings the loudest level to full scale
+    float gain() const { return m_gain; }
+
+    // Lowest level whose harmonics all stay below Nyquist at this 32-bit phase increment
+    static size_t levelFor(uint32_t increment);
+
+private:
+    const float* m_levels[WAVETABLE_LEVELS];
+    float m_gain;
+    std::shared_ptr<const std::vector<float>> m_storage;
+};
+
+// Linearly interpolated lookup into one level, with 32-bit phases as in sine.h
+void wavetable_block(float* out, size_t frames, const float* table, uint32_t phase, uint32_t increment,
+                     float amplitude);
+
+} // namespace tonegen
@@ -0,0 +1,280 @@
+#include "tonegen/additive.h"
+
+#include <algorithm>
+#include <cmath>
+#include <complex>
+
+#include "fft.h"
+#include "kernels.h"
+#include "tonegen/cpu.h"
+#include "tonegen/phase.h"
+
+namespace tonegen {
+
+namespace {
+
+using detail::Complex;
+
+// FFT^-1 synthesis after Rodet & Depalle: every hop, each partial adds the spectrum of a
+// Blackman-Harris windowed sinusoid (its main lobe, 2 * KERNEL_HALF_WIDTH + 1 bins) to one
+// frame. The inverse transform is divided by the window and faded with triangles that
+// overlap-add to one, so a partial costs a handful of bins per hop instead of a rotation
+// per sample.
+const size_t IFFT_SIZE = 4096;
+const size_t IFFT_HOP = IFFT_SIZE / 4;
+const int KERNEL_HALF_WIDTH = 4; // Main lobe of the 4-term window; sidelobes are below -92 dB
+const int KERNEL_OVERSAMPLE = 64;
+const double BLACKMAN_HARRIS[4] = {0.35875, 0.48829, 0.14128, 0.01168};
+
+struct IfftTables {
+    detail::RealFftPlan plan;
+    // Window spectrum around its center, sampled every 1 / KERNEL_OVERSAMPLE bins; the
+    // last entry is a guard for interpolation
+    std::vector<Complex> kernel;
+    // Triangle fade over the window, including the 1 / IFFT_SIZE inverse transform scale
+    std::vector<float> rising;
+    std::vector<float> falling;
+
+    IfftTables()
+        : plan(IFFT_SIZE), kernel(2 * KERNEL_HALF_WIDTH * KERNEL_OVERSAMPLE + 2), rising(IFFT_HOP),
+          falling(IFFT_HOP) {
+        const double n = static_cast<double>(IFFT_SIZE);
+        // Sum over the frame of e^(-2 pi i x t / n), in closed form
+        auto dirichlet = [n](double x) {
+            if (std::fabs(x) < 1e-12) {
+                return std::complex<double>(n, 0);
+            }
+            const std::complex<double> num = 1.0 - std::polar(1.0, -2 * detail::PI * x);
+            const std::complex<double> den = 1.0 - std::polar(1.0, -2 * detail::PI * x / n);
+            return num / den;
+        };
+        for (size_t i = 0; i < kernel.size(); ++i) {
+            const double delta = static_cast<double>(i) / KERNEL_OVERSAMPLE - KERNEL_HALF_WIDTH;
+            std::complex<double> w = 0;
+            for (int m = 0; m < 4; ++m) {
+                const double a = ((m & 1) ? -0.5 : 0.5) * BLACKMAN_HARRIS[m];
+                w += m == 0 ? 2 * a * dirichlet(delta) : a * (dirichlet(delta - m) + dirichlet(delta + m));
+            }
+            // Shift the time origin to the frame center so the kernel is smooth to interpolate
+            w *= std::polar(1.0, detail::PI * delta);
+            kernel[i] = {w.real(), w.imag()};
+        }
+
+        auto window = [n](size_t t) {
+            double w = 0;
+            for (int m = 0; m < 4; ++m) {
+                w += ((m & 1) ? -1 : 1) * BLACKMAN_HARRIS[m] * std::cos(2 * detail::PI * m * static_cast<double>(t) / n);
+            }
+            return w;
+        };
+        for (size_t i = 0; i < IFFT_HOP; ++i) {
+            const double fade = static_cast<double>(i) / IFFT_HOP;
+            rising[i] = static_cast<float>(fade / (n * window(IFFT_SIZE / 2 - IFFT_HOP + i)));
+            falling[i] = static_cast<float>((1 - fade) / (n * window(IFFT_SIZE / 2 + i)));
+        }
+    }
+};
+
+const IfftTables& ifft_tables() {
+    static const IfftTables tables;
+    return tables;
+}
+
+} // namespace
+
+AdditiveOscillator::AdditiveOscillator(int sampleRate)
+    : m_sampleRate(sampleRate), m_frequency(440), m_amplitude(DEFAULT_AMPLITUDE), m_strategy(ADDITIVE_AUTO),
+      m_count(0), m_partials(ADDITIVE_MAX_PARTIALS), m_phases(ADDITIVE_MAX_PARTIALS),
+      m_increments(ADDITIVE_MAX_PARTIALS), m_gains(ADDITIVE_MAX_PARTIALS), m_blockPhases(ADDITIVE_MAX_PARTIALS),
+      m_blockIncrements(ADDITIVE_MAX_PARTIALS), m_block(MAX_BLOCK_FRAMES),
+      m_primed(false), m_ready(IFFT_HOP), m_readyPos(0), m_readyEnd(0), m_overlap(IFFT_HOP),
+      m_discard(IFFT_HOP), m_spectrum(IFFT_SIZE), m_work(IFFT_SIZE / 2), m_frame(IFFT_SIZE) {
+    ifft_tables(); // Build the shared tables here rather than on the first audio callback
+}
+
+AdditiveOscillator::~AdditiveOscillator() = default;
+
+void AdditiveOscillator::setPartials(const Partial* partials, size_t count) {
+    count = std::min(count, ADDITIVE_MAX_PARTIALS);
+    const size_t previous = m_count;
+    std::copy(partials, partials + count, m_partials.begin());
+    m_count = count;
+    for (size_t p = previous; p < count; ++p) {
+        m_phases[p] = static_cast<uint64_t>(std::ldexp(m_partials[p].phase - std::floor(m_partials[p].phase), 64));
+    }
+    updatePartials();
+}
+
+void AdditiveOscillator::setFrequency(double frequency) {
+    m_frequency = frequency;
+    updatePartials();
+}
+
+void AdditiveOscillator::setAmplitude(float amplitude) {
+    m_amplitude = amplitude;
+    updatePartials();
+}
+
+void AdditiveOscillator::setStrategy(AdditiveStrategy strategy) {
+    m_strategy = strategy;
+}
+
+void AdditiveOscillator::reset() {
+    for (size_t p = 0; p < m_count; ++p) {
+        m_phases[p] = static_cast<uint64_t>(std::ldexp(m_partials[p].phase - std::floor(m_partials[p].phase), 64));
+    }
+    m_primed = false;
+    m_readyPos = 0;
+    m_readyEnd = 0;
+}
+
+void AdditiveOscillator::skip(uint64_t frames) {
+    // Finished samples come first; past them the phases move and the overlap-add restarts
+    const size_t ready = m_readyEnd - m_readyPos;
+    if (frames <= ready) {
+        m_readyPos += static_cast<size_t>(frames);
+        return;
+    }
+    advance(frames - ready);
+    m_primed = false;
+    m_readyPos = 0;
+    m_readyEnd = 0;
+}
+
+size_t additive_ifft_threshold() {
+    // The IFFT is scalar code, so the crossover moves with the width of the recursive kernel
+    switch (active_isa()) {
+        case ISA_SCALAR:
+            return 32;
+        case ISA_SSE2:
+        case ISA_NEON:
+            return 96;
+        default:
+            return 256;
+    }
+}
+
+AdditiveStrategy AdditiveOscillator::activeStrategy() const {
+    if (m_strategy != ADDITIVE_AUTO) {
+        return m_strategy;
+    }
+    return m_count < additive_ifft_threshold() ? ADDITIVE_RECURSIVE : ADDITIVE_IFFT;
+}
+
+void AdditiveOscillator::updatePartials() {
+    for (size_t p = 0; p < m_count; ++p) {
+        const double frequency = m_frequency * m_partials[p].ratio;
+        const bool audible = frequency > 0 && frequency < m_sampleRate / 2.0;
+        m_increments[p] = audible ? phase_increment(frequency, m_sampleRate) : 0;
+        m_gains[p] = audible ? m_amplitude * m_partials[p].amplitude : 0.0f;
+        m_blockIncrements[p] = static_cast<uint32_t>((m_increments[p] + (uint64_t(1) << 31)) >> 32);
+    }
+}
+
+void AdditiveOscillator::process(float* out, size_t frames) {
+    while (frames > 0) {
+        size_t chunk;
+        if (m_readyPos < m_readyEnd) {
+            // Hand out what the last hop finished, whichever strategy is active now
+            chunk = std::min(frames, m_readyEnd - m_readyPos);
+            std::copy(m_ready.begin() + m_readyPos, m_ready.begin() + m_readyPos + chunk, out);
+            m_readyPos += chunk;
+        } else if (activeStrategy() == ADDITIVE_IFFT) {
+            synthesizeHop();
+            continue;
+        } else {
+            chunk = std::min(frames, MAX_BLOCK_FRAMES);
+            renderRecursive(out, chunk);
+            m_primed = false;
+        }
+        out += chunk;
+        frames -= chunk;
+    }
+}
+
+void AdditiveOscillator::renderRecursive(float* out, size_t frames) {
+    for (size_t p = 0; p < m_count; ++p) {
+        m_blockPhases[p] = static_cast<uint32_t>(m_phases[p] >> 32);
+    }
+    const detail::AdditiveArgs args = {m_blockPhases.data(), m_blockIncrements.data(), m_gains.data(), m_count};
+    // The kernel works in whole 16-sample steps; MAX_BLOCK_FRAMES is a multiple of that
+    const size_t padded = (frames + 15) & ~size_t(15);
+    detail::kernels().additive(m_block.data(), padded, args);
+    std::copy(m_block.begin(), m_block.begin() + frames, out);
+    advance(frames);
+}
+
+void AdditiveOscillator::synthesizeFrame(int64_t offset, float* rising, float* falling) {
+    const IfftTables& tables = ifft_tables();
+    Complex* spectrum = m_spectrum.data();
+    std::fill(m_spectrum.begin(), m_spectrum.end(), Complex{0, 0});
+
+    // The frame center sits one hop past the time the phases point at, plus offset
+    const uint64_t centerFrames = static_cast<uint64_t>(static_cast<int64_t>(IFFT_HOP) + offset);
+    for (size_t p = 0; p < m_count; ++p) {
+        if (m_gains[p] == 0.0f) {
+            continue;
+        }
+        const uint32_t phase = static_cast<uint32_t>((m_phases[p] + m_increments[p] * centerFrames) >> 32);
+        // sin(theta) = (e^(i theta) - e^(-i theta)) / 2i: accumulate the positive frequency
+        // term only, with (-1)^k for the centered kernel, and mirror the spectrum once below
+        const double half = 0.5 * m_gains[p];
+        const Complex coefficient = {half * detail::sine_from_phase<SINE_PRECISE>(phase),
+                                     -half * detail::sine_from_phase<SINE_PRECISE>(phase + 0x40000000u)};
+        const double bin = std::ldexp(static_cast<double>(m_increments[p]), -64) * IFFT_SIZE;
+        const int64_t first = static_cast<int64_t>(std::ceil(bin - KERNEL_HALF_WIDTH));
+        const int64_t last = static_cast<int64_t>(std::floor(bin + KERNEL_HALF_WIDTH));
+        // Neighbouring bins sit whole bins apart in the kernel, so they share one fraction
+        const double position = (static_cast<double>(first) - bin + KERNEL_HALF_WIDTH) * KERNEL_OVERSAMPLE;
+        size_t index = static_cast<size_t>(position);
+        const double frac = position - static_cast<double>(index);
+        Complex signedCoefficient = (first & 1) ? Complex{-coefficient.re, -coefficient.im} : coefficient;
+        for (int64_t k = first; k <= last; ++k, index += KERNEL_OVERSAMPLE) {
+            const Complex a = tables.kernel[index];
+            const Complex b = tables.kernel[index + 1];
+            const Complex w = {a.re + (b.re - a.re) * frac, a.im + (b.im - a.im) * frac};
+            Complex& target = spectrum[static_cast<size_t>(k) & (IFFT_SIZE - 1)];
+            target = target + signedCoefficient * w;
+            signedCoefficient = {-signedCoefficient.re, -signedCoefficient.im};
+        }
+    }
+
+    // Hermitian bins 0..IFFT_SIZE / 2 of the real frame; kernels that wrapped past DC or
+    // Nyquist fold back here too
+    for (size_t k = 0; k <= IFFT_SIZE / 2; ++k) {
+        const Complex mirror = spectrum[(IFFT_SIZE - k) & (IFFT_SIZE - 1)];
+        spectrum[k] = spectrum[k] + Complex{mirror.re, -mirror.im};
+    }
+    tables.plan.inverse(spectrum, m_work.data(), m_frame.data());
+
+    const double* fadeIn = m_frame.data() + IFFT_SIZE / 2 - IFFT_HOP;
+    const double* fadeOut = m_frame.data() + IFFT_SIZE / 2;
+    for (size_t i = 0; i < IFFT_HOP; ++i) {
+        rising[i] = static_cast<float>(fadeIn[i]) * tables.rising[i];
+        falling[i] = static_cast<float>(fadeOut[i]) * tables.falling[i];
+    }
+}
+
+void AdditiveOscillator::synthesizeHop() {
+    if (!m_primed) {
+        // Entering from silence or the recursive path: rebuild the previous frame's tail
+        synthesizeFrame(-static_cast<int64_t>(IFFT_HOP), m_discard.data(), m_overlap.data());
+        m_primed = true;
+    }
+    synthesizeFrame(0, m_ready.data(), m_discard.data());
+    for (size_t i = 0; i < IFFT_HOP; ++i) {
+        m_ready[i] += m_overlap[i];
+    }
+    std::swap(m_overlap, m_discard);
+    m_readyPos = 0;
+    m_readyEnd = IFFT_HOP;
+    advance(IFFT_HOP);
+}
+
+void AdditiveOscillator::advance(uint64_t frames) {
+    for (size_t p = 0; p < m_count; ++p) {
+        m_phases[p] += m_increments[p] * frames;
+    }
+}
+
+} // namespace tonegen
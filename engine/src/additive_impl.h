@@ -0,0 +1,57 @@
+#pragma once
+
+// Recursive-oscillator additive synthesis shared by every ISA translation unit, written
+// against the lane types in lanes.h. Lanes run consecutive samples of one partial, so
+// accumulating into the output is a plain vertical add with no horizontal sums.
+
+#include "lanes.h"
+
+namespace tonegen {
+namespace detail {
+
+// Partials rendered together; their rotations are independent, which hides the latency
+// of each one's serial recurrence, and they share one load/store of the output
+const size_t ADDITIVE_GROUP = 4;
+
+template <typename L>
+TONEGEN_INLINE void additive_block(float* out, size_t frames, const AdditiveArgs& args) {
+    typedef typename L::F F;
+    for (size_t i = 0; i < frames; ++i) {
+        out[i] = 0.0f;
+    }
+
+    for (size_t first = 0; first < args.count; first += ADDITIVE_GROUP) {
+        // Lanes hold consecutive samples of one partial, started from the exact phase each
+        // block, and every step turns them all by LANES increments
+        F re[ADDITIVE_GROUP];
+        F im[ADDITIVE_GROUP];
+        F stepRe[ADDITIVE_GROUP];
+        F stepIm[ADDITIVE_GROUP];
+        float gain[ADDITIVE_GROUP];
+        for (size_t q = 0; q < ADDITIVE_GROUP; ++q) {
+            const size_t p = first + q < args.count ? first + q : first; // Pad with a silent copy
+            gain[q] = first + q < args.count ? args.gains[p] : 0.0f;
+            const uint32_t increment = args.increments[p];
+            const typename L::U phase = L::phases(args.phases[p], increment);
+            re[q] = lanes_sine<L, SINE_PRECISE>(phase + 0x40000000u);
+            im[q] = lanes_sine<L, SINE_PRECISE>(phase);
+            const uint32_t step = static_cast<uint32_t>(L::LANES) * increment;
+            stepRe[q] = L::splat(sine_from_phase<SINE_PRECISE>(step + 0x40000000u));
+            stepIm[q] = L::splat(sine_from_phase<SINE_PRECISE>(step));
+        }
+
+        for (size_t i = 0; i < frames; i += L::LANES) {
+            F sum = L::load(out + i);
+            for (size_t q = 0; q < ADDITIVE_GROUP; ++q) {
+                sum += gain[q] * im[q];
+                const F next = re[q] * stepRe[q] - im[q] * stepIm[q];
+                im[q] = re[q] * stepIm[q] + im[q] * stepRe[q];
+                re[q] = next;
+            }
+            L::store(out + i, sum);
+        }
+    }
+}
+
+} // namespace detail
+} // namespace tonegen
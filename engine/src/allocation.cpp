@@ -0,0 +1,106 @@
+#include "tonegen/allocation.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+namespace tonegen {
+
+#ifdef TONEGEN_COUNT_ALLOCATIONS
+namespace detail {
+thread_local uint64_t t_allocations = 0;
+}
+#endif
+
+BufferArena::BufferArena(size_t bytes)
+    : m_storage(new unsigned char[bytes + ALIGNMENT]), m_capacity(bytes), m_used(0) {
+    const size_t offset = reinterpret_cast<uintptr_t>(m_storage.get()) % ALIGNMENT;
+    m_base = m_storage.get() + (offset == 0 ? 0 : ALIGNMENT - offset);
+    // Touches every page now rather than on the first block
+    std::memset(m_base, 0, m_capacity);
+}
+
+void* BufferArena::allocateBytes(size_t bytes) {
+    bytes = (bytes + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+    if (bytes > m_capacity - m_used) {
+        throw std::bad_alloc();
+    }
+    void* slice = m_base + m_used;
+    m_used += bytes;
+    return slice;
+}
+
+uint64_t thread_allocations() {
+#ifdef TONEGEN_COUNT_ALLOCATIONS
+    return detail::t_allocations;
+#else
+    return 0;
+#endif
+}
+
+bool counting_allocations() {
+#ifdef TONEGEN_COUNT_ALLOCATIONS
+    return true;
+#else
+    return false;
+#endif
+}
+
+} // namespace tonegen
+
+#ifdef TONEGEN_COUNT_ALLOCATIONS
+// Replacements for the global allocation functions; they live in this file so that whatever
+// uses thread_allocations() links them in. Everything else forwards to malloc and free.
+namespace {
+
+void* counted_malloc(std::size_t size) {
+    ++tonegen::detail::t_allocations;
+    return std::malloc(size == 0 ? 1 : size);
+}
+
+void* counted_aligned_malloc(std::size_t size, std::align_val_t alignment) {
+    ++tonegen::detail::t_allocations;
+    const std::size_t align = static_cast<std::size_t>(alignment);
+    return std::aligned_alloc(align, (size + align - 1) / align * align);
+}
+
+} // namespace
+
+void* operator new(std::size_t size) {
+    if (void* p = counted_malloc(size)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+void* operator new[](std::size_t size) {
+    if (void* p = counted_malloc(size)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept { return counted_malloc(size); }
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept { return counted_malloc(size); }
+void* operator new(std::size_t size, std::align_val_t alignment) {
+    if (void* p = counted_aligned_malloc(size, alignment)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+void* operator new[](std::size_t size, std::align_val_t alignment) {
+    if (void* p = counted_aligned_malloc(size, alignment)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { std::free(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+#endif
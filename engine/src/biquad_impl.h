@@ -0,0 +1,95 @@
+#pragma once
+
+// Biquad cascade shared by every ISA translation unit. BIQUAD_LANES logical lanes are split
+// into as many native vectors as the lane type needs; one frame advances every stage of
+// every channel at once in transposed direct form II.
+
+#include "lanes.h"
+
+namespace tonegen {
+namespace detail {
+
+template <typename L, size_t V>
+TONEGEN_INLINE void biquad_frame(float* frame, size_t channels, const typename L::F (&c)[BIQUAD_COEFFICIENTS][V],
+                                 typename L::F (&z1)[V], typename L::F (&z2)[V], typename L::F (&y)[V]) {
+    typedef typename L::F F;
+    float input[BIQUAD_CHANNELS] = {};
+    for (size_t ch = 0; ch < channels; ++ch) {
+        input[ch] = frame[ch];
+    }
+
+    // Each stage takes the previous stage's last output; the first stage of a channel
+    // takes the new frame
+    F x[V];
+    for (size_t v = 0; v < V; ++v) {
+        const size_t lane = v * L::LANES;
+        x[v] = L::shiftIn(y[v], lane % FILTER_MAX_STAGES == 0 ? input[lane / FILTER_MAX_STAGES]
+                                                              : L::get(y[v - 1], L::LANES - 1));
+        for (size_t j = FILTER_MAX_STAGES - lane % FILTER_MAX_STAGES; j < L::LANES; j += FILTER_MAX_STAGES) {
+            L::set(x[v], j, input[(lane + j) / FILTER_MAX_STAGES]);
+        }
+        x[v] += BIQUAD_DENORMAL_GUARD;
+    }
+
+    for (size_t v = 0; v < V; ++v) {
+        y[v] = c[BIQUAD_B0][v] * x[v] + z1[v];
+        z1[v] = c[BIQUAD_B1][v] * x[v] - c[BIQUAD_A1][v] * y[v] + z2[v];
+        z2[v] = c[BIQUAD_B2][v] * x[v] - c[BIQUAD_A2][v] * y[v];
+    }
+
+    for (size_t ch = 0; ch < channels; ++ch) {
+        const size_t lane = ch * FILTER_MAX_STAGES + FILTER_MAX_STAGES - 1;
+        frame[ch] = L::get(y[lane / L::LANES], lane % L::LANES);
+    }
+}
+
+template <typename L>
+TONEGEN_INLINE void biquad_block(float* frames, size_t count, const BiquadArgs& args) {
+    typedef typename L::F F;
+    const size_t V = BIQUAD_LANES / L::LANES;
+    F c[BIQUAD_COEFFICIENTS][V];
+    F z1[V];
+    F z2[V];
+    F y[V];
+    for (size_t v = 0; v < V; ++v) {
+        for (size_t k = 0; k < BIQUAD_COEFFICIENTS; ++k) {
+            c[k][v] = L::load(args.coefficients + k * BIQUAD_LANES + v * L::LANES);
+        }
+        z1[v] = L::load(args.state + BIQUAD_Z1 * BIQUAD_LANES + v * L::LANES);
+        z2[v] = L::load(args.state + BIQUAD_Z2 * BIQUAD_LANES + v * L::LANES);
+        y[v] = L::load(args.state + BIQUAD_Y * BIQUAD_LANES + v * L::LANES);
+    }
+
+    size_t n = 0;
+    if (args.rampFrames > 0) {
+        F d[BIQUAD_COEFFICIENTS][V];
+        for (size_t v = 0; v < V; ++v) {
+            for (size_t k = 0; k < BIQUAD_COEFFICIENTS; ++k) {
+                d[k][v] = L::load(args.deltas + k * BIQUAD_LANES + v * L::LANES);
+            }
+        }
+        for (const size_t ramp = std::min(args.rampFrames, count); n < ramp; ++n) {
+            for (size_t v = 0; v < V; ++v) {
+                for (size_t k = 0; k < BIQUAD_COEFFICIENTS; ++k) {
+                    c[k][v] += d[k][v];
+                }
+            }
+            biquad_frame<L, V>(frames + n * args.stride, args.channels, c, z1, z2, y);
+        }
+    }
+    for (; n < count; ++n) {
+        biquad_frame<L, V>(frames + n * args.stride, args.channels, c, z1, z2, y);
+    }
+
+    for (size_t v = 0; v < V; ++v) {
+        for (size_t k = 0; k < BIQUAD_COEFFICIENTS; ++k) {
+            L::store(args.coefficients + k * BIQUAD_LANES + v * L::LANES, c[k][v]);
+        }
+        L::store(args.state + BIQUAD_Z1 * BIQUAD_LANES + v * L::LANES, z1[v]);
+        L::store(args.state + BIQUAD_Z2 * BIQUAD_LANES + v * L::LANES, z2[v]);
+        L::store(args.state + BIQUAD_Y * BIQUAD_LANES + v * L::LANES, y[v]);
+    }
+}
+
+} // namespace detail
+} // namespace tonegen
@@ -0,0 +1,95 @@
+#pragma once
+
+// Branch-free PolyBLEP/PolyBLAMP oscillators shared by every ISA translation unit,
+// written once against the lane types in lanes.h.
+
+#include "lanes.h"
+
+namespace tonegen {
+namespace detail {
+
+// T is float when every lane shares one increment, or L::F when each lane has its own
+template <typename T>
+struct BlepConstants {
+    T dt;
+    T invDt;
+    float width;
+    float pulseScale; // Keeps the DC-free pulse within +-1
+};
+
+// Residual of a band-limited step of height 2 at t == 0, non-zero within dt on either side
+template <typename L, typename T>
+TONEGEN_INLINE typename L::F poly_blep(typename L::F t, T invDt) {
+    const typename L::F before = 1.0f + L::max((t - 1.0f) * invDt, -1.0f);
+    const typename L::F after = 1.0f - L::min(t * invDt, 1.0f);
+    return before * before - after * after;
+}
+
+// Residual of a band-limited corner with a slope change of one per sample at t == 0
+template <typename L, typename T>
+TONEGEN_INLINE typename L::F poly_blamp(typename L::F t, T invDt) {
+    const typename L::F before = L::max((t - 1.0f) * invDt + 1.0f, 0.0f);
+    const typename L::F after = L::max(1.0f - t * invDt, 0.0f);
+    return (before * before * before + after * after * after) * (1.0f / 6.0f);
+}
+
+template <int Shape, typename L, typename T>
+TONEGEN_INLINE typename L::F blep_sample(typename L::U phase, uint32_t width, const BlepConstants<T>& c) {
+    typedef typename L::F F;
+    const F t = L::turns(phase);
+    if (Shape == BLEP_SAW) {
+        return 2.0f * t - 1.0f - poly_blep<L>(t, c.invDt);
+    } else if (Shape == BLEP_PULSE) {
+        // turns() keeps the top 24 bits, so the falling edge is measured from width rounded the
+        // same way; otherwise a sample just before the edge can read as low yet get the residual
+        // for high, and come out at -2
+        const F naive = L::select(t < c.width, L::splat(1.0f), L::splat(-1.0f));
+        const F sinceFall = L::turns(phase - (width & 0xffffff00u));
+        return (naive + poly_blep<L>(t, c.invDt) - poly_blep<L>(sinceFall, c.invDt) - (2.0f * c.width - 1.0f)) *
+               c.pulseScale;
+    } else {
+        // Starts at zero rising like the sine; corners at a quarter and three quarters of a turn,
+        // where the slope of 4 turns per cycle flips sign
+        const F rising = L::turns(phase + 0x40000000u);
+        const F naive = 1.0f - 4.0f * L::abs(rising - 0.5f);
+        const T slopeChange = 8.0f * c.dt;
+        return naive + slopeChange * (poly_blamp<L>(rising, c.invDt) -
+                                      poly_blamp<L>(L::turns(phase - 0x40000000u), c.invDt));
+    }
+}
+
+// Removing the DC moves the levels of a pulse to 2 (1 - width) and -2 width; this brings the
+// larger of the two back to 1, so a narrow pulse peaks at the amplitude instead of clipping
+TONEGEN_INLINE float pulse_scale(float width) {
+    return 0.5f / std::max(std::max(width, 1.0f - width), 0.5f);
+}
+
+TONEGEN_INLINE BlepConstants<float> blep_constants(uint32_t increment, uint32_t width) {
+    BlepConstants<float> c;
+    // Above Nyquist/2 the residuals would overlap; the tone aliases anyway at that point
+    c.dt = std::min(std::max(static_cast<float>(increment) * PHASE_TO_TURNS, 1e-9f), 0.5f);
+    c.invDt = 1.0f / c.dt;
+    c.width = ScalarLanes::turns(width);
+    c.pulseScale = pulse_scale(c.width);
+    return c;
+}
+
+template <int Shape, typename L>
+TONEGEN_INLINE void blep_block(float* out, size_t frames, const BlepArgs& args) {
+    const BlepConstants<float> c = blep_constants(args.increment, args.width);
+
+    typename L::U phase = L::phases(args.phase, args.increment);
+    const uint32_t stride = static_cast<uint32_t>(L::LANES) * args.increment;
+    size_t i = 0;
+    for (; i + L::LANES <= frames; i += L::LANES) {
+        L::store(out + i, args.amplitude * blep_sample<Shape, L>(phase, args.width, c));
+        phase += stride;
+    }
+    uint32_t tail = args.phase + static_cast<uint32_t>(i) * args.increment;
+    for (; i < frames; ++i, tail += args.increment) {
+        out[i] = args.amplitude * blep_sample<Shape, ScalarLanes>(tail, args.width, c);
+    }
+}
+
+} // namespace detail
+} // namespace tonegen
@@ -0,0 +1,146 @@
+#include "tonegen/convert.h"
+
+#include <algorithm>
+#include <array>
+#include <utility>
+
+#include "kernels.h"
+
+namespace tonegen {
+
+namespace {
+
+template <int Format> struct SampleType;
+template <> struct SampleType<SAMPLE_UINT8> { typedef uint8_t T; };
+template <> struct SampleType<SAMPLE_INT16> { typedef int16_t T; };
+template <> struct SampleType<SAMPLE_INT32> { typedef int32_t T; };
+template <> struct SampleType<SAMPLE_FLOAT> { typedef float T; };
+
+typedef void (*FanOutFn)(const void* in, void* out, size_t frames);
+
+// Copies converted mono samples to every channel. Format and fan-out are both compile-time
+// constants here, so the loop is straight-line code the compiler can vectorize.
+template <int Format, int Channels>
+void fan_out(const void* in, void* out, size_t frames) {
+    typedef typename SampleType<Format>::T T;
+    const T* src = static_cast<const T*>(in);
+    T* dst = static_cast<T*>(out);
+    for (size_t i = 0; i < frames; ++i) {
+        for (int c = 0; c < Channels; ++c) {
+            dst[i * Channels + c] = src[i];
+        }
+    }
+}
+
+// Fan-outs beyond MAX_CHANNELS, which the engine never renders itself
+template <int Format>
+void fan_out_wide(const void* in, void* out, size_t frames, int channels) {
+    typedef typename SampleType<Format>::T T;
+    const T* src = static_cast<const T*>(in);
+    T* dst = static_cast<T*>(out);
+    for (size_t i = 0; i < frames; ++i) {
+        dst = std::fill_n(dst, channels, src[i]);
+    }
+}
+
+template <int Format, size_t... Fanout>
+constexpr std::array<FanOutFn, MAX_CHANNELS> fan_out_row(std::index_sequence<Fanout...>) {
+    return {{fan_out<Format, static_cast<int>(Fanout) + 1>...}};
+}
+
+// One kernel per (format, fan-out), picked once per call instead of per sample
+const std::array<FanOutFn, MAX_CHANNELS> FAN_OUT_KERNELS[SAMPLE_FORMAT_COUNT] = {
+    fan_out_row<SAMPLE_UINT8>(std::make_index_sequence<MAX_CHANNELS>()),
+    fan_out_row<SAMPLE_INT16>(std::make_index_sequence<MAX_CHANNELS>()),
+    fan_out_row<SAMPLE_INT32>(std::make_index_sequence<MAX_CHANNELS>()),
+    fan_out_row<SAMPLE_FLOAT>(std::make_index_sequence<MAX_CHANNELS>()),
+};
+
+void fan_out_any(const void* in, void* out, SampleFormat format, size_t frames, int channels) {
+    if (channels <= static_cast<int>(MAX_CHANNELS)) {
+        FAN_OUT_KERNELS[format][channels - 1](in, out, frames);
+        return;
+    }
+    switch (format) {
+        case SAMPLE_UINT8: fan_out_wide<SAMPLE_UINT8>(in, out, frames, channels); break;
+        case SAMPLE_INT16: fan_out_wide<SAMPLE_INT16>(in, out, frames, channels); break;
+        case SAMPLE_INT32: fan_out_wide<SAMPLE_INT32>(in, out, frames, channels); break;
+        case SAMPLE_FLOAT: fan_out_wide<SAMPLE_FLOAT>(in, out, frames, channels); break;
+        default: break;
+    }
+}
+
+} // namespace
+
+void convert_samples(const float* in, void* out, SampleFormat format, size_t samples, Dither* dither) {
+    if (format < 0 || format >= SAMPLE_FORMAT_COUNT) {
+        return;
+    }
+    const bool dithered = dither != nullptr && dither->enabled;
+    detail::ConvertArgs args;
+    args.seed = dithered ? dither->seed : 0;
+    args.position = dithered ? dither->position : 0;
+    detail::kernels().convert[format][dithered](in, out, samples, args);
+    if (dither != nullptr) {
+        dither->position += static_cast<uint32_t>(samples);
+    }
+}
+
+void convert_to_int16(const float* in, int16_t* out, size_t samples) {
+    convert_samples(in, out, SAMPLE_INT16, samples);
+}
+
+void convert_mono_to_interleaved(const float* in, void* out, SampleFormat format, size_t frames, int channels,
+                                 Dither* dither) {
+    if (format < 0 || format >= SAMPLE_FORMAT_COUNT || channels < 1) {
+        return;
+    }
+    if (channels == 1) {
+        convert_samples(in, out, format, frames, dither);
+        return;
+    }
+    unsigned char* dst = static_cast<unsigned char*>(out);
+    const size_t sampleBytes = bytes_per_sample(format);
+    const size_t frameBytes = sampleBytes * static_cast<size_t>(channels);
+    if (dither != nullptr && dither->enabled) {
+        // Dither after the fan-out, at interleaved sample frame * channels + c, so the channels
+        // get independent noise and the positions match a generator rendering them itself
+        alignas(64) float wide[MAX_BLOCK_FRAMES * MAX_CHANNELS];
+        const size_t capacity = MAX_BLOCK_FRAMES * MAX_CHANNELS;
+        const size_t chunkFrames = capacity / static_cast<size_t>(channels);
+        while (frames > 0 && chunkFrames > 0) {
+            const size_t chunk = std::min(frames, chunkFrames);
+            fan_out_any(in, wide, SAMPLE_FLOAT, chunk, channels);
+            convert_samples(wide, dst, format, chunk * static_cast<size_t>(channels), dither);
+            in += chunk;
+            dst += chunk * frameBytes;
+            frames -= chunk;
+        }
+        // Frames wider than the scratch buffer go out in runs of one sample
+        for (; frames > 0; ++in, --frames) {
+            for (size_t left = static_cast<size_t>(channels); left > 0;) {
+                const size_t run = std::min(left, capacity);
+                std::fill_n(wide, run, *in);
+                convert_samples(wide, dst, format, run, dither);
+                dst += run * sampleBytes;
+                left -= run;
+            }
+        }
+        return;
+    }
+    // Converts a block at a time while it is still mono, then copies it out to the channels
+    alignas(64) unsigned char block[MAX_BLOCK_FRAMES * sizeof(float)];
+    if (dither != nullptr) {
+        dither->position += static_cast<uint32_t>(frames * static_cast<size_t>(channels));
+    }
+    while (frames > 0) {
+        const size_t chunk = std::min(frames, MAX_BLOCK_FRAMES);
+        convert_samples(in, block, format, chunk);
+        fan_out_any(block, dst, format, chunk, channels);
+        in += chunk;
+        dst += chunk * frameBytes;
+        frames -= chunk;
+    }
+}
+
+} // namespace tonegen
@@ -0,0 +1,92 @@
+#pragma once
+
+// The float-to-device-format stage shared by every ISA translation unit: scales, adds
+// optional TPDF dither, saturates and narrows, one vector of samples at a time.
+
+#include "lanes.h"
+
+namespace tonegen {
+namespace detail {
+
+template <int Format> struct ConvertFormat;
+template <> struct ConvertFormat<SAMPLE_UINT8> {
+    typedef uint8_t T;
+    static constexpr float SCALE = 127.5f;
+    static constexpr float OFFSET = 127.5f;
+    static constexpr float LOW = 0.0f;
+    static constexpr float HIGH = 255.0f;
+    static constexpr bool DITHER = true;
+};
+template <> struct ConvertFormat<SAMPLE_INT16> {
+    typedef int16_t T;
+    static constexpr float SCALE = 32767.0f;
+    static constexpr float OFFSET = 0.0f;
+    static constexpr float LOW = -32768.0f;
+    static constexpr float HIGH = 32767.0f;
+    static constexpr bool DITHER = true;
+};
+// Dither would sit far below float precision at this scale
+template <> struct ConvertFormat<SAMPLE_INT32> {
+    typedef int32_t T;
+    static constexpr float SCALE = 2147483648.0f;
+    static constexpr float OFFSET = 0.0f;
+    static constexpr float LOW = -2147483648.0f;
+    static constexpr float HIGH = 2147483520.0f; // Largest float below 2^31
+    static constexpr bool DITHER = false;
+};
+template <> struct ConvertFormat<SAMPLE_FLOAT> {
+    typedef float T;
+    static constexpr float SCALE = 1.0f;
+    static constexpr float OFFSET = 0.0f;
+    static constexpr float LOW = -1.0f;
+    static constexpr float HIGH = 1.0f;
+    static constexpr bool DITHER = false;
+};
+
+// Triangular noise in (-1, 1) LSB for sample index: two 16-bit uniforms from one integer
+// hash (lowbias32), so any stretch can be converted on its own and lanes need no state
+template <typename L>
+TONEGEN_INLINE typename L::F tpdf_dither(typename L::U index, uint32_t seed) {
+    typename L::U h = index ^ seed;
+    h ^= h >> 16;
+    h *= 0x7feb352du;
+    h ^= h >> 15;
+    h *= 0x846ca68bu;
+    h ^= h >> 16;
+    return (L::toFloat((h & 0xffffu) + (h >> 16)) - 65535.0f) * (1.0f / 65536.0f);
+}
+
+template <int Format, bool Dither, typename L>
+TONEGEN_INLINE void convert_vector(const float* in, typename ConvertFormat<Format>::T* out, uint32_t index,
+                                   const ConvertArgs& args) {
+    typedef ConvertFormat<Format> C;
+    // Rounds to nearest: shifted up to start at 0.5, truncation does the rest
+    const bool rounds = Format == SAMPLE_UINT8 || Format == SAMPLE_INT16;
+    const float shift = rounds ? 0.5f - C::LOW : 0.0f;
+    typename L::F y = L::load(in) * C::SCALE + (C::OFFSET + shift);
+    if (Dither && C::DITHER) {
+        y += tpdf_dither<L>(L::phases(index, 1), args.seed);
+    }
+    y = L::min(L::max(y, C::LOW + shift), C::HIGH + shift);
+    if (Format == SAMPLE_FLOAT) {
+        L::store(reinterpret_cast<float*>(out), y);
+    } else {
+        L::template storeAs<typename C::T>(out, L::truncate(y) - static_cast<int32_t>(shift - 0.5f));
+    }
+}
+
+template <int Format, bool Dither, typename L>
+TONEGEN_INLINE void convert_block(const float* in, void* out, size_t samples, const ConvertArgs& args) {
+    typedef typename ConvertFormat<Format>::T T;
+    T* dst = static_cast<T*>(out);
+    size_t i = 0;
+    for (; i + L::LANES <= samples; i += L::LANES) {
+        convert_vector<Format, Dither, L>(in + i, dst + i, args.position + static_cast<uint32_t>(i), args);
+    }
+    for (; i < samples; ++i) {
+        convert_vector<Format, Dither, ScalarLanes>(in + i, dst + i, args.position + static_cast<uint32_t>(i), args);
+    }
+}
+
+} // namespace detail
+} // namespace tonegen
@@ -0,0 +1,162 @@
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+
+#include "tonegen/blep.h"
+#include "tonegen/wavetable.h"
+#include "kernels.h"
+
+namespace tonegen {
+
+namespace {
+
+bool host_supports(CpuIsa isa) {
+    switch (isa) {
+        case ISA_SCALAR:
+            return true;
+#if defined(TONEGEN_X86) && (defined(__GNUC__) || defined(__clang__))
+        case ISA_SSE2:
+            return __builtin_cpu_supports("sse2");
+        case ISA_AVX2:
+            return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+        case ISA_AVX512:
+            return __builtin_cpu_supports("avx512f");
+#elif defined(TONEGEN_X86)
+        case ISA_SSE2:
+            return true; // Every x86-64 host has SSE2; wider kernels need the GCC/Clang builtins
+#endif
+#ifdef TONEGEN_NEON
+        case ISA_NEON:
+            return true;
+#endif
+        default:
+            return false;
+    }
+}
+
+CpuIsa isa_from_env() {
+    const char* value = std::getenv("TONEGEN_ISA");
+    if (!value) {
+        return ISA_COUNT;
+    }
+    for (int isa = 0; isa < ISA_COUNT; ++isa) {
+        if (std::strcmp(value, isa_name(static_cast<CpuIsa>(isa))) == 0) {
+            return static_cast<CpuIsa>(isa);
+        }
+    }
+    return ISA_COUNT;
+}
+
+bool allowed_by_cap(CpuIsa isa, CpuIsa cap) {
+    if (cap == ISA_COUNT || isa == ISA_SCALAR) {
+        return true;
+    }
+    if (isa == ISA_NEON || cap == ISA_NEON) {
+        return isa == cap;
+    }
+    return isa <= cap;
+}
+
+struct Dispatch {
+    detail::KernelTable tables[ISA_COUNT];
+    std::atomic<int> active;
+
+    Dispatch() : active(ISA_SCALAR) {
+        for (int isa = 0; isa < ISA_COUNT; ++isa) {
+            detail::fill_kernels_scalar(tables[isa]);
+        }
+#ifdef TONEGEN_X86
+        detail::fill_kernels_sse2(tables[ISA_SSE2]);
+        detail::fill_kernels_avx2(tables[ISA_AVX2]);
+        detail::fill_kernels_avx512(tables[ISA_AVX512]);
+#endif
+#ifdef TONEGEN_NEON
+        detail::fill_kernels_neon(tables[ISA_NEON]);
+#endif
+        active = detect_isa();
+    }
+};
+
+Dispatch& dispatch() {
+    static Dispatch instance;
+    return instance;
+}
+
+} // namespace
+
+const char* isa_name(CpuIsa isa) {
+    switch (isa) {
+        case ISA_SCALAR: return "scalar";
+        case ISA_SSE2: return "sse2";
+        case ISA_AVX2: return "avx2";
+        case ISA_AVX512: return "avx512";
+        case ISA_NEON: return "neon";
+        default: return "unknown";
+    }
+}
+
+bool isa_supported(CpuIsa isa) {
+    return isa >= ISA_SCALAR && isa < ISA_COUNT && host_supports(isa);
+}
+
+CpuIsa detect_isa() {
+    const CpuIsa cap = isa_from_env();
+    const CpuIsa preference[] = {ISA_AVX512, ISA_AVX2, ISA_NEON, ISA_SSE2, ISA_SCALAR};
+    for (CpuIsa isa : preference) {
+        if (allowed_by_cap(isa, cap) && host_supports(isa)) {
+            return isa;
+        }
+    }
+    return ISA_SCALAR;
+}
+
+CpuIsa active_isa() {
+    return static_cast<CpuIsa>(dispatch().active.load(std::memory_order_relaxed));
+}
+
+bool set_active_isa(CpuIsa isa) {
+    if (!isa_supported(isa)) {
+        return false;
+    }
+    dispatch().active.store(isa, std::memory_order_relaxed);
+    return true;
+}
+
+namespace detail {
+
+const KernelTable& kernels() {
+    Dispatch& d = dispatch();
+    return d.tables[d.active.load(std::memory_order_relaxed)];
+}
+
+} // namespace detail
+
+void sine_block(float* out, size_t frames, uint32_t phase, uint32_t increment, float amplitude,
+                SineAccuracy accuracy) {
+    detail::kernels().sine[accuracy](out, frames, phase, increment, amplitude);
+}
+
+void saw_block(float* out, size_t frames, uint32_t phase, uint32_t increment, float amplitude) {
+    const detail::BlepArgs args = {phase, increment, amplitude, 0};
+    detail::kernels().blep[detail::BLEP_SAW](out, frames, args);
+}
+
+void triangle_block(float* out, size_t frames, uint32_t phase, uint32_t increment, float amplitude) {
+    const detail::BlepArgs args = {phase, increment, amplitude, 0};
+    detail::kernels().blep[detail::BLEP_TRIANGLE](out, frames, args);
+}
+
+void pulse_block(float* out, size_t frames, uint32_t phase, uint32_t increment, float amplitude, float width) {
+    width = std::min(std::max(width, 0.0f), 1.0f);
+    const detail::BlepArgs args = {phase, increment, amplitude,
+                                   static_cast<uint32_t>(static_cast<double>(width) * 4294967295.0)};
+    detail::kernels().blep[detail::BLEP_PULSE](out, frames, args);
+}
+
+void wavetable_block(float* out, size_t frames, const float* table, uint32_t phase, uint32_t increment,
+                     float amplitude) {
+    const detail::WavetableArgs args = {table, phase, increment, amplitude};
+    detail::kernels().wavetable(out, frames, args);
+}
+
+} // namespace tonegen
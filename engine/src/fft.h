@@ -0,0 +1,173 @@
+#pragma once
+
+// In-place radix-2 complex FFT that works both in constant expressions, where the
+// built-in wavetables are generated, and at run time for custom tables; FftPlan is the
+// precomputed variant for the additive engine's per-frame inverse transforms.
+
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+namespace tonegen {
+namespace detail {
+
+constexpr double PI = 3.14159265358979323846;
+
+// Taylor series sine for constant expressions, accurate to double rounding after the
+// argument is reduced to [-pi, pi]
+constexpr double const_sin(double x) {
+    while (x > PI) {
+        x -= 2 * PI;
+    }
+    while (x < -PI) {
+        x += 2 * PI;
+    }
+    double term = x;
+    double sum = x;
+    for (int k = 1; k < 14; ++k) {
+        term *= -x * x / ((2 * k) * (2 * k + 1));
+        sum += term;
+    }
+    return sum;
+}
+
+constexpr double const_cos(double x) { return const_sin(x + PI / 2); }
+
+// std::complex has no constexpr arithmetic before C++20
+struct Complex {
+    double re;
+    double im;
+};
+
+constexpr Complex operator+(Complex a, Complex b) { return {a.re + b.re, a.im + b.im}; }
+constexpr Complex operator-(Complex a, Complex b) { return {a.re - b.re, a.im - b.im}; }
+constexpr Complex operator*(Complex a, Complex b) {
+    return {a.re * b.re - a.im * b.im, a.re * b.im + a.im * b.re};
+}
+
+// n must be a power of two. The inverse transform is unscaled: x[t] = sum X[k] e^(2 pi i k t / n).
+constexpr void fft(Complex* data, size_t n, bool inverse) {
+    for (size_t i = 1, j = 0; i < n; ++i) {
+        size_t bit = n >> 1;
+        for (; j & bit; bit >>= 1) {
+            j ^= bit;
+        }
+        j ^= bit;
+        if (i < j) {
+            const Complex tmp = data[i];
+            data[i] = data[j];
+            data[j] = tmp;
+        }
+    }
+    for (size_t len = 2; len <= n; len <<= 1) {
+        // One twiddle per stage and a recurrence within it: log2(n) * eps drift, far below float
+        const double angle = (inverse ? 2 : -2) * PI / static_cast<double>(len);
+        const Complex step = {const_cos(angle), const_sin(angle)};
+        for (size_t i = 0; i < n; i += len) {
+            Complex w = {1, 0};
+            for (size_t j = 0; j < len / 2; ++j) {
+                const Complex u = data[i + j];
+                const Complex v = data[i + j + len / 2] * w;
+                data[i + j] = u + v;
+                data[i + j + len / 2] = u - v;
+                w = w * step;
+            }
+        }
+    }
+}
+
+// Run-time transform of one size with precomputed twiddles and bit reversal, for callers
+// that transform every block. Construction allocates; transforms don't.
+class FftPlan {
+public:
+    explicit FftPlan(size_t n) : m_size(n), m_reversed(n), m_twiddles(n) {
+        size_t bits = 0;
+        while ((size_t(1) << bits) < n) {
+            ++bits;
+        }
+        for (size_t i = 0; i < n; ++i) {
+            size_t r = 0;
+            for (size_t b = 0; b < bits; ++b) {
+                r |= ((i >> b) & 1) << (bits - 1 - b);
+            }
+            m_reversed[i] = r;
+        }
+        // Stage len reads its len / 2 twiddles contiguously from m_twiddles[len / 2]
+        for (size_t len = 2; len <= n; len <<= 1) {
+            for (size_t j = 0; j < len / 2; ++j) {
+                const double angle = 2 * PI * static_cast<double>(j) / static_cast<double>(len);
+                m_twiddles[len / 2 + j] = {std::cos(angle), std::sin(angle)};
+            }
+        }
+    }
+
+    size_t size() const { return m_size; }
+
+    // Unscaled inverse transform, as fft(data, size(), true)
+    void inverse(Complex* data) const {
+        for (size_t i = 0; i < m_size; ++i) {
+            const size_t j = m_reversed[i];
+            if (i < j) {
+                const Complex tmp = data[i];
+                data[i] = data[j];
+                data[j] = tmp;
+            }
+        }
+        for (size_t len = 2; len <= m_size; len <<= 1) {
+            const Complex* twiddles = &m_twiddles[len / 2];
+            for (size_t i = 0; i < m_size; i += len) {
+                Complex* a = data + i;
+                Complex* b = data + i + len / 2;
+                for (size_t j = 0; j < len / 2; ++j) {
+                    const Complex u = a[j];
+                    const Complex v = b[j] * twiddles[j];
+                    a[j] = u + v;
+                    b[j] = u - v;
+                }
+            }
+        }
+    }
+
+private:
+    size_t m_size;
+    std::vector<size_t> m_reversed;
+    std::vector<Complex> m_twiddles;
+};
+
+// Inverse transform of a Hermitian spectrum to n real samples through one complex
+// transform of n / 2: even samples land in the real part and odd ones in the imaginary.
+class RealFftPlan {
+public:
+    explicit RealFftPlan(size_t n) : m_half(n / 2), m_twiddles(n / 2) {
+        for (size_t k = 0; k < n / 2; ++k) {
+            const double angle = 2 * PI * static_cast<double>(k) / static_cast<double>(n);
+            m_twiddles[k] = {std::cos(angle), std::sin(angle)};
+        }
+    }
+
+    size_t size() const { return 2 * m_half.size(); }
+
+    // spectrum holds bins 0..n/2; out receives n samples, unscaled like FftPlan::inverse.
+    // work is scratch of n / 2 entries owned by the caller, so one plan can be shared.
+    void inverse(const Complex* spectrum, Complex* work, double* out) const {
+        const size_t half = m_half.size();
+        for (size_t k = 0; k < half; ++k) {
+            const Complex a = spectrum[k];
+            const Complex b = {spectrum[half - k].re, -spectrum[half - k].im};
+            const Complex odd = (a - b) * m_twiddles[k];
+            work[k] = a + b + Complex{-odd.im, odd.re};
+        }
+        m_half.inverse(work);
+        for (size_t m = 0; m < half; ++m) {
+            out[2 * m] = work[m].re;
+            out[2 * m + 1] = work[m].im;
+        }
+    }
+
+private:
+    FftPlan m_half;
+    std::vector<Complex> m_twiddles;
+};
+
+} // namespace detail
+} // namespace tonegen
@@ -0,0 +1,360 @@
+#define _FILE_OFFSET_BITS 64 // 64-bit off_t for pwrite on 32-bit POSIX systems
+
+#include "tonegen/file_sink.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <unistd.h>
+#define TONEGEN_POSIX_FILES 1
+#endif
+
+namespace tonegen {
+
+namespace {
+
+const unsigned WAVE_FORMAT_PCM = 1;
+const unsigned WAVE_FORMAT_IEEE_FLOAT = 3;
+const unsigned WAVE_FORMAT_EXTENSIBLE = 0xFFFE;
+// Body of the ds64 chunk RF64 needs; a WAV keeps the room as a JUNK chunk in case it grows into one
+const uint64_t DS64_BYTES = 28;
+const uint64_t RIFF_LIMIT = 0xFFFFFFFFull;
+// writeBytes offset meaning "after the furthest byte written"
+const uint64_t APPEND = ~0ull;
+
+// Sony Wave64 chunk GUIDs, as stored
+const uint8_t W64_RIFF[16] = {'r', 'i', 'f', 'f', 0x2E, 0x91, 0xCF, 0x11, 0xA5, 0xD6, 0x28, 0xDB, 0x04, 0xC1, 0x00, 0x00};
+const uint8_t W64_WAVE[16] = {'w', 'a', 'v', 'e', 0xF3, 0xAC, 0xD3, 0x11, 0x8C, 0xD1, 0x00, 0xC0, 0x4F, 0x8E, 0xDB, 0x8A};
+const uint8_t W64_FMT[16] = {'f', 'm', 't', ' ', 0xF3, 0xAC, 0xD3, 0x11, 0x8C, 0xD1, 0x00, 0xC0, 0x4F, 0x8E, 0xDB, 0x8A};
+const uint8_t W64_DATA[16] = {'d', 'a', 't', 'a', 0xF3, 0xAC, 0xD3, 0x11, 0x8C, 0xD1, 0x00, 0xC0, 0x4F, 0x8E, 0xDB, 0x8A};
+// KSDATAFORMAT_SUBTYPE_PCM and _IEEE_FLOAT after their leading format tag
+const uint8_t SUBTYPE_TAIL[14] = {0x00, 0x00, 0x00, 0x00, 0x10, 0x00, 0x80, 0x00, 0x00, 0xAA, 0x00, 0x38, 0x9B, 0x71};
+
+void put(std::vector<uint8_t>& out, uint64_t value, int bytes) {
+    for (int i = 0; i < bytes; ++i) {
+        out.push_back(static_cast<uint8_t>(value >> (8 * i)));
+    }
+}
+
+void put(std::vector<uint8_t>& out, const char* id) {
+    out.insert(out.end(), id, id + 4);
+}
+
+void put(std::vector<uint8_t>& out, const uint8_t (&guid)[16]) {
+    out.insert(out.end(), guid, guid + 16);
+}
+
+// WAVEFORMATEX, or WAVEFORMATEXTENSIBLE with a speaker mask beyond stereo
+std::vector<uint8_t> format_chunk(int sampleRate, size_t channels, SampleFormat format) {
+    const size_t sampleBytes = bytes_per_sample(format);
+    const unsigned tag = format == SAMPLE_FLOAT ? WAVE_FORMAT_IEEE_FLOAT : WAVE_FORMAT_PCM;
+    const bool extensible = channels > 2;
+    std::vector<uint8_t> chunk;
+    put(chunk, extensible ? WAVE_FORMAT_EXTENSIBLE : tag, 2);
+    put(chunk, channels, 2);
+    put(chunk, static_cast<uint64_t>(sampleRate), 4);
+    put(chunk, static_cast<uint64_t>(sampleRate) * channels * sampleBytes, 4);
+    put(chunk, channels * sampleBytes, 2);
+    put(chunk, sampleBytes * 8, 2);
+    if (extensible) {
+        put(chunk, 22, 2);
+        put(chunk, sampleBytes * 8, 2);
+        // The first channels speakers in the standard order; none named past the 18 there are
+        put(chunk, channels <= 18 ? (1ull << channels) - 1 : 0, 4);
+        put(chunk, tag, 2);
+        chunk.insert(chunk.end(), SUBTYPE_TAIL, SUBTYPE_TAIL + sizeof(SUBTYPE_TAIL));
+    }
+    return chunk;
+}
+
+// Zero bytes after dataBytes of audio that end the data chunk on the container's alignment
+uint64_t padding(FileType type, uint64_t dataBytes) {
+    switch (type) {
+        case FILE_WAV:
+        case FILE_RF64:
+            return dataBytes % 2;
+        case FILE_W64:
+            return (8 - dataBytes % 8) % 8;
+        default:
+            return 0;
+    }
+}
+
+double seconds_since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+} // namespace
+
+FileType file_type_for(const std::string& path) {
+    const size_t dot = path.find_last_of("./");
+    std::string extension = dot != std::string::npos && path[dot] == '.' ? path.substr(dot + 1) : "";
+    std::transform(extension.begin(), extension.end(), extension.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    if (extension == "rf64") {
+        return FILE_RF64;
+    }
+    if (extension == "w64") {
+        return FILE_W64;
+    }
+    if (extension == "raw" || extension == "pcm") {
+        return FILE_RAW;
+    }
+    return FILE_WAV;
+}
+
+FileSink::FileSink(size_t bufferBytes, size_t buffers)
+    : m_bufferBytes(std::max<size_t>(bufferBytes, 1)), m_buffers(std::max<size_t>(buffers, 1)), m_type(FILE_WAV),
+      m_sampleRate(DEFAULT_SAMPLE_RATE), m_channels(1), m_format(SAMPLE_INT16), m_frameBytes(2), m_file(nullptr),
+      m_headerBytes(0), m_endBytes(0), m_filling(nullptr), m_stop(false), m_failed(false) {
+    for (Buffer& buffer : m_buffers) {
+        buffer.data.reset(new uint8_t[m_bufferBytes]);
+        buffer.offset = 0;
+        buffer.bytes = 0;
+    }
+}
+
+FileSink::~FileSink() {
+    close();
+}
+
+bool FileSink::open(const std::string& path, FileType type, int sampleRate, size_t channels, SampleFormat format) {
+    close();
+    m_error.clear();
+    if (sampleRate <= 0 || channels < 1 || channels > 0xFFFF || bytes_per_sample(format) == 0) {
+        m_error = path + ": unsupported sample rate, channel count or format";
+        return false;
+    }
+    m_type = type;
+    m_sampleRate = sampleRate;
+    m_channels = channels;
+    m_format = format;
+    m_frameBytes = bytes_per_sample(format) * channels;
+    m_path = path;
+    m_file = std::fopen(path.c_str(), "wb");
+    if (!m_file) {
+        return fail("open", errno);
+    }
+    // The fallback writes straight through rather than copying into a stdio buffer first
+    std::setvbuf(m_file, nullptr, _IONBF, 0);
+
+    const std::vector<uint8_t> placeholder = header(0);
+    m_headerBytes = placeholder.size();
+    if (!writeFile(0, placeholder.data(), placeholder.size())) {
+        std::fclose(m_file);
+        m_file = nullptr;
+        return false;
+    }
+
+    m_endBytes = 0;
+    m_stats = FileSinkStats();
+    m_free.clear();
+    for (Buffer& buffer : m_buffers) {
+        m_free.push_back(&buffer);
+    }
+    m_queue.clear();
+    m_filling = nullptr;
+    m_stop = false;
+    m_failed = false;
+    m_thread = std::thread(&FileSink::run, this);
+    return true;
+}
+
+bool FileSink::close() {
+    if (!m_file) {
+        return true;
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_filling) {
+            submit();
+        }
+        m_stop = true;
+    }
+    m_changed.notify_all();
+    m_thread.join();
+
+    bool ok = !m_failed;
+    if (ok) {
+        const uint8_t zeros[8] = {};
+        const std::vector<uint8_t> patched = header(m_endBytes);
+        ok = writeFile(m_headerBytes + m_endBytes, zeros, static_cast<size_t>(padding(m_type, m_endBytes))) &&
+             writeFile(0, patched.data(), patched.size());
+    }
+    if (std::fclose(m_file) != 0 && ok) {
+        ok = fail("close", errno);
+    }
+    m_file = nullptr;
+    return ok;
+}
+
+bool FileSink::write(const void* data, size_t frames) {
+    return writeBytes(APPEND, static_cast<const uint8_t*>(data), frames * m_frameBytes);
+}
+
+bool FileSink::writeAt(uint64_t frame, const void* data, size_t frames) {
+    return writeBytes(frame * m_frameBytes, static_cast<const uint8_t*>(data), frames * m_frameBytes);
+}
+
+FileSinkStats FileSink::stats() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_stats;
+}
+
+bool FileSink::writeBytes(uint64_t offset, const uint8_t* data, size_t bytes) {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (!m_file) {
+        return false;
+    }
+    if (offset == APPEND) {
+        offset = m_endBytes;
+    }
+    while (bytes > 0 && !m_failed) {
+        // A buffer holds one contiguous run, so a jump elsewhere sends it off part full
+        if (m_filling && (m_filling->offset + m_filling->bytes != offset || m_filling->bytes == m_bufferBytes)) {
+            submit();
+        }
+        if (!m_filling) {
+            if (m_free.empty()) {
+                // Every buffer is waiting for the disk
+                const auto start = std::chrono::steady_clock::now();
+                m_changed.wait(lock, [this] { return !m_free.empty() || m_failed; });
+                m_stats.waitSeconds += seconds_since(start);
+                ++m_stats.waits;
+                continue;
+            }
+            m_filling = m_free.back();
+            m_free.pop_back();
+            m_filling->offset = offset;
+            m_filling->bytes = 0;
+        }
+        const size_t count = std::min(bytes, m_bufferBytes - m_filling->bytes);
+        std::memcpy(m_filling->data.get() + m_filling->bytes, data, count);
+        m_filling->bytes += count;
+        offset += count;
+        data += count;
+        bytes -= count;
+        m_endBytes = std::max(m_endBytes, offset);
+    }
+    return !m_failed;
+}
+
+void FileSink::submit() {
+    m_queue.push_back(m_filling);
+    m_filling = nullptr;
+    m_changed.notify_all();
+}
+
+void FileSink::run() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    for (;;) {
+        m_changed.wait(lock, [this] { return m_stop || !m_queue.empty(); });
+        if (m_queue.empty()) {
+            return;
+        }
+        Buffer* buffer = m_queue.front();
+        m_queue.erase(m_queue.begin());
+        // After a failure the queue is only drained, so waiting writers are let go
+        const bool skip = m_failed;
+        lock.unlock();
+        const auto start = std::chrono::steady_clock::now();
+        const bool written = skip || writeFile(m_headerBytes + buffer->offset, buffer->data.get(), buffer->bytes);
+        const double seconds = seconds_since(start);
+        lock.lock();
+        if (!skip && written) {
+            m_stats.bytes += buffer->bytes;
+        }
+        m_failed = m_failed || !written;
+        m_stats.writeSeconds += seconds;
+        m_free.push_back(buffer);
+        m_changed.notify_all();
+    }
+}
+
+// Sizes come from dataBytes of audio; the length is the same for any dataBytes, so the final
+// header overwrites the placeholder exactly
+std::vector<uint8_t> FileSink::header(uint64_t dataBytes) const {
+    const std::vector<uint8_t> format = format_chunk(m_sampleRate, m_channels, m_format);
+    const uint64_t frames = dataBytes / m_frameBytes;
+    std::vector<uint8_t> out;
+    switch (m_type) {
+        case FILE_WAV:
+        case FILE_RF64: {
+            const uint64_t riffBytes = 4 + (8 + DS64_BYTES) + (8 + format.size()) + 8 + dataBytes + padding(m_type, dataBytes);
+            const bool rf64 = m_type == FILE_RF64 || riffBytes > RIFF_LIMIT;
+            put(out, rf64 ? "RF64" : "RIFF");
+            put(out, rf64 ? RIFF_LIMIT : riffBytes, 4);
+            put(out, "WAVE");
+            put(out, rf64 ? "ds64" : "JUNK");
+            put(out, DS64_BYTES, 4);
+            put(out, rf64 ? riffBytes : 0, 8);
+            put(out, rf64 ? dataBytes : 0, 8);
+            put(out, rf64 ? frames : 0, 8);
+            put(out, 0, 4); // No table of other oversized chunks
+            put(out, "fmt ");
+            put(out, format.size(), 4);
+            out.insert(out.end(), format.begin(), format.end());
+            put(out, "data");
+            put(out, rf64 ? RIFF_LIMIT : dataBytes, 4);
+            break;
+        }
+        case FILE_W64: {
+            // Sizes count the 24-byte chunk header; the fmt bodies are already multiples of 8
+            const uint64_t headerBytes = 40 + (24 + format.size()) + 24;
+            put(out, W64_RIFF);
+            put(out, headerBytes + dataBytes + padding(m_type, dataBytes), 8);
+            put(out, W64_WAVE);
+            put(out, W64_FMT);
+            put(out, 24 + format.size(), 8);
+            out.insert(out.end(), format.begin(), format.end());
+            put(out, W64_DATA);
+            put(out, 24 + dataBytes, 8);
+            break;
+        }
+        default:
+            break;
+    }
+    return out;
+}
+
+bool FileSink::writeFile(uint64_t position, const void* data, size_t bytes) {
+    const uint8_t* next = static_cast<const uint8_t*>(data);
+#ifdef TONEGEN_POSIX_FILES
+    // pwrite carries its own offset, so the header patch and the audio never share a file position
+    const int descriptor = fileno(m_file);
+    while (bytes > 0) {
+        const ssize_t written = pwrite(descriptor, next, bytes, static_cast<off_t>(position));
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return fail("write", errno);
+        }
+        next += written;
+        position += static_cast<uint64_t>(written);
+        bytes -= static_cast<size_t>(written);
+    }
+    return true;
+#else
+#ifdef _WIN32
+    const bool placed = _fseeki64(m_file, static_cast<long long>(position), SEEK_SET) == 0;
+#else
+    const bool placed = std::fseek(m_file, static_cast<long>(position), SEEK_SET) == 0;
+#endif
+    if (!placed || std::fwrite(next, 1, bytes, m_file) != bytes) {
+        return fail("write", errno);
+    }
+    return true;
+#endif
+}
+
+bool FileSink::fail(const char* what, int error) {
+    m_error = m_path + ": " + what + " failed: " + std::strerror(error);
+    return false;
+}
+
+} // namespace tonegen
@@ -0,0 +1,230 @@
+#include "tonegen/filter.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <complex>
+
+#include "fft.h"
+#include "kernels.h"
+
+namespace tonegen {
+
+namespace {
+
+const BiquadCoefficients IDENTITY = {1, 0, 0, 0, 0};
+
+size_t block_count(size_t channels) {
+    return (channels + detail::BIQUAD_CHANNELS - 1) / detail::BIQUAD_CHANNELS;
+}
+
+// Q of section k of an order 2 * sections Butterworth filter
+double butterworth_q(size_t k, size_t sections) {
+    return 1 / (2 * std::cos(detail::PI * static_cast<double>(2 * k + 1) / static_cast<double>(4 * sections)));
+}
+
+} // namespace
+
+BiquadCoefficients biquad_coefficients(const FilterStage& stage, int sampleRate) {
+    const double frequency = std::min(std::max(stage.frequency, 1e-3), 0.499 * sampleRate);
+    const double w0 = 2 * detail::PI * frequency / sampleRate;
+    const double cosw = std::cos(w0);
+    const double alpha = std::sin(w0) / (2 * std::max(stage.q, 1e-3));
+    const double a = std::pow(10.0, stage.gainDb / 40.0);
+    const double shelf = 2 * std::sqrt(a) * alpha;
+
+    // b0, b1, b2, a0, a1, a2 before normalizing
+    std::array<double, 6> r;
+    switch (stage.type) {
+        case FILTER_LOWPASS:
+            r = {(1 - cosw) / 2, 1 - cosw, (1 - cosw) / 2, 1 + alpha, -2 * cosw, 1 - alpha};
+            break;
+        case FILTER_HIGHPASS:
+            r = {(1 + cosw) / 2, -(1 + cosw), (1 + cosw) / 2, 1 + alpha, -2 * cosw, 1 - alpha};
+            break;
+        case FILTER_BANDPASS:
+            r = {alpha, 0, -alpha, 1 + alpha, -2 * cosw, 1 - alpha};
+            break;
+        case FILTER_NOTCH:
+            r = {1, -2 * cosw, 1, 1 + alpha, -2 * cosw, 1 - alpha};
+            break;
+        case FILTER_LOW_SHELF:
+            r = {a * ((a + 1) - (a - 1) * cosw + shelf), 2 * a * ((a - 1) - (a + 1) * cosw),
+                 a * ((a + 1) - (a - 1) * cosw - shelf), (a + 1) + (a - 1) * cosw + shelf,
+                 -2 * ((a - 1) + (a + 1) * cosw), (a + 1) + (a - 1) * cosw - shelf};
+            break;
+        case FILTER_HIGH_SHELF:
+            r = {a * ((a + 1) + (a - 1) * cosw + shelf), -2 * a * ((a - 1) + (a + 1) * cosw),
+                 a * ((a + 1) + (a - 1) * cosw - shelf), (a + 1) - (a - 1) * cosw + shelf,
+                 2 * ((a - 1) - (a + 1) * cosw), (a + 1) - (a - 1) * cosw - shelf};
+            break;
+        case FILTER_PEAK:
+            r = {1 + alpha * a, -2 * cosw, 1 - alpha * a, 1 + alpha / a, -2 * cosw, 1 - alpha / a};
+            break;
+        default:
+            return IDENTITY;
+    }
+    return {r[0] / r[3], r[1] / r[3], r[2] / r[3], r[4] / r[3], r[5] / r[3]};
+}
+
+FilterStage band_stage(FilterType type, double low, double high, float gainDb) {
+    FilterStage stage;
+    stage.type = type;
+    stage.frequency = std::sqrt(low * high);
+    stage.q = stage.frequency / std::max(high - low, 1e-3);
+    stage.gainDb = gainDb;
+    return stage;
+}
+
+size_t band_pass_stages(double low, double high, FilterStage* out, size_t count) {
+    const size_t sections = count / 2;
+    for (size_t k = 0; k < sections; ++k) {
+        out[k].type = FILTER_HIGHPASS;
+        out[k].frequency = low;
+        out[k].q = butterworth_q(k, sections);
+        out[sections + k].type = FILTER_LOWPASS;
+        out[sections + k].frequency = high;
+        out[sections + k].q = butterworth_q(k, sections);
+    }
+    return 2 * sections;
+}
+
+size_t band_stop_sections(double low, double high, int sampleRate, BiquadCoefficients* out, size_t count) {
+    typedef std::complex<double> Complex;
+    const double fs2 = 2.0 * sampleRate;
+    const double edgeLimit = 0.499 * sampleRate;
+    // Prewarped analog band edges, so the bilinear transform puts -3 dB exactly at low and high
+    const double w1 = fs2 * std::tan(detail::PI * std::min(std::max(low, 1e-3), edgeLimit) / sampleRate);
+    const double w2 = fs2 * std::tan(detail::PI * std::min(std::max(high, low + 1e-3), edgeLimit) / sampleRate);
+    const double center = std::sqrt(w1 * w2);
+    const double bandwidth = std::max(w2 - w1, 1e-9);
+    // The analog zeros at +-j center land on the unit circle here
+    const double cosCenter = std::cos(2 * std::atan(center / fs2));
+
+    auto bilinear = [fs2](Complex s) { return (fs2 + s) / (fs2 - s); };
+    // One section from a pair of poles that are either conjugates or both real, with unity
+    // gain at DC; the product of the sections is then unity at DC and Nyquist as well
+    auto section = [&](Complex p, Complex q) {
+        const Complex zp = bilinear(p);
+        const Complex zq = bilinear(q);
+        BiquadCoefficients c;
+        c.a1 = -(zp + zq).real();
+        c.a2 = (zp * zq).real();
+        const double gain = (1 + c.a1 + c.a2) / (2 - 2 * cosCenter);
+        c.b0 = gain;
+        c.b1 = -2 * cosCenter * gain;
+        c.b2 = gain;
+        return c;
+    };
+
+    // Each lowpass prototype pole p becomes the two roots of s^2 - (bandwidth / p) s + center^2.
+    // Poles above the real axis give two sections, paired with the roots of their conjugate;
+    // the real pole of an odd order gives one.
+    size_t written = 0;
+    for (size_t k = 0; k < count && written < count; ++k) {
+        const Complex pole = std::polar(1.0, detail::PI * static_cast<double>(2 * k + count + 1) /
+                                                 static_cast<double>(2 * count));
+        if (pole.imag() < -1e-12) {
+            continue;
+        }
+        const Complex b = bandwidth / pole;
+        const Complex root = std::sqrt(b * b - 4 * center * center);
+        const Complex r1 = (b + root) / 2.0;
+        const Complex r2 = (b - root) / 2.0;
+        if (pole.imag() > 1e-12) {
+            out[written++] = section(r1, std::conj(r1));
+            out[written++] = section(r2, std::conj(r2));
+        } else {
+            out[written++] = section(r1, r2);
+        }
+    }
+    return written;
+}
+
+FilterBank::FilterBank(int sampleRate, size_t channels)
+    : m_sampleRate(sampleRate), m_channels(std::max<size_t>(channels, 1)), m_count(0), m_bypass(true),
+      m_rampLeft(0),
+      m_coefficients(block_count(m_channels) * detail::BIQUAD_COEFFICIENTS * detail::BIQUAD_LANES),
+      m_targets(m_coefficients.size()), m_deltas(m_coefficients.size()),
+      m_state(block_count(m_channels) * detail::BIQUAD_STATE * detail::BIQUAD_LANES) {
+    setStages(nullptr, 0);
+    reset();
+}
+
+void FilterBank::setStages(const FilterStage* stages, size_t count) {
+    BiquadCoefficients sections[FILTER_MAX_STAGES];
+    count = std::min(count, FILTER_MAX_STAGES);
+    for (size_t s = 0; s < count; ++s) {
+        sections[s] = biquad_coefficients(stages[s], m_sampleRate);
+    }
+    setSections(sections, count);
+}
+
+void FilterBank::setSections(const BiquadCoefficients* sections, size_t count) {
+    m_count = std::min(count, FILTER_MAX_STAGES);
+
+    const size_t blockSize = detail::BIQUAD_COEFFICIENTS * detail::BIQUAD_LANES;
+    for (size_t b = 0; b < block_count(m_channels); ++b) {
+        float* target = m_targets.data() + b * blockSize;
+        for (size_t lane = 0; lane < detail::BIQUAD_LANES; ++lane) {
+            const size_t stage = lane % FILTER_MAX_STAGES;
+            const BiquadCoefficients& c = stage < m_count ? sections[stage] : IDENTITY;
+            target[detail::BIQUAD_B0 * detail::BIQUAD_LANES + lane] = static_cast<float>(c.b0);
+            target[detail::BIQUAD_B1 * detail::BIQUAD_LANES + lane] = static_cast<float>(c.b1);
+            target[detail::BIQUAD_B2 * detail::BIQUAD_LANES + lane] = static_cast<float>(c.b2);
+            target[detail::BIQUAD_A1 * detail::BIQUAD_LANES + lane] = static_cast<float>(c.a1);
+            target[detail::BIQUAD_A2 * detail::BIQUAD_LANES + lane] = static_cast<float>(c.a2);
+        }
+    }
+
+    if (m_bypass) {
+        if (m_count > 0) {
+            reset();
+        }
+        return;
+    }
+    // The stable region of (a1, a2) is a triangle, so each frame of a linear ramp between
+    // two stable filters is stable too
+    for (size_t i = 0; i < m_targets.size(); ++i) {
+        m_deltas[i] = (m_targets[i] - m_coefficients[i]) / FILTER_RAMP_FRAMES;
+    }
+    m_rampLeft = FILTER_RAMP_FRAMES;
+}
+
+void FilterBank::reset() {
+    std::copy(m_targets.begin(), m_targets.end(), m_coefficients.begin());
+    std::fill(m_state.begin(), m_state.end(), 0.0f);
+    m_rampLeft = 0;
+    m_bypass = m_count == 0;
+}
+
+void FilterBank::process(float* frames, size_t count) {
+    if (m_bypass) {
+        return;
+    }
+    const detail::BiquadFn biquad = detail::kernels().biquad;
+    while (count > 0) {
+        const size_t chunk = m_rampLeft > 0 ? std::min(count, m_rampLeft) : count;
+        for (size_t b = 0; b < block_count(m_channels); ++b) {
+            detail::BiquadArgs args;
+            args.stride = m_channels;
+            args.channels = std::min(m_channels - b * detail::BIQUAD_CHANNELS, detail::BIQUAD_CHANNELS);
+            args.coefficients = m_coefficients.data() + b * detail::BIQUAD_COEFFICIENTS * detail::BIQUAD_LANES;
+            args.deltas = m_deltas.data() + b * detail::BIQUAD_COEFFICIENTS * detail::BIQUAD_LANES;
+            args.rampFrames = m_rampLeft > 0 ? chunk : 0;
+            args.state = m_state.data() + b * detail::BIQUAD_STATE * detail::BIQUAD_LANES;
+            biquad(frames + b * detail::BIQUAD_CHANNELS, chunk, args);
+        }
+        if (m_rampLeft > 0) {
+            m_rampLeft -= chunk;
+            if (m_rampLeft == 0) {
+                // Land exactly on the targets rather than on the summed steps
+                std::copy(m_targets.begin(), m_targets.end(), m_coefficients.begin());
+            }
+        }
+        frames += chunk * m_channels;
+        count -= chunk;
+    }
+}
+
+} // namespace tonegen
@@ -0,0 +1,67 @@
+#pragma once
+
+// Control-rate gain shared by every ISA translation unit: multiplies interleaved audio by a
+// line drawn between control points, one segment of CONTROL_FRAMES frames at a time.
+
+#include "lanes.h"
+
+namespace tonegen {
+namespace detail {
+
+// Every sample gets start + step * its frame index, so the line doesn't depend on the lane
+// count; lane j of vector v scales sample v * LANES + j of each period
+template <typename L, size_t V>
+TONEGEN_INLINE void gain_segment(float* out, size_t frames, size_t channels, float start, float step) {
+    typedef typename L::F F;
+    const size_t period = V * L::LANES;
+    F frame[V];
+    for (size_t v = 0; v < V; ++v) {
+        float index[L::LANES];
+        for (size_t j = 0; j < L::LANES; ++j) {
+            index[j] = static_cast<float>((v * L::LANES + j) / channels);
+        }
+        frame[v] = L::load(index);
+    }
+    const F periodFrames = L::splat(static_cast<float>(period / channels));
+
+    const size_t samples = frames * channels;
+    size_t i = 0;
+    for (; i + period <= samples; i += period) {
+        for (size_t v = 0; v < V; ++v) {
+            float* p = out + i + v * L::LANES;
+            L::store(p, L::load(p) * (start + step * frame[v]));
+            frame[v] += periodFrames;
+        }
+    }
+    for (; i < samples; ++i) {
+        out[i] *= start + step * static_cast<float>(i / channels);
+    }
+}
+
+template <typename L>
+TONEGEN_INLINE void gain_block(float* out, size_t frames, const GainArgs& args) {
+    const size_t vectors = interleave_period(L::LANES, args.channels);
+    size_t offset = args.offset;
+    for (const float* point = args.points; frames > 0; ++point) {
+        const size_t n = std::min(frames, CONTROL_FRAMES - offset);
+        const float step = (point[1] - point[0]) * (1.0f / CONTROL_FRAMES);
+        const float start = point[0] + step * static_cast<float>(offset);
+        switch (vectors) {
+            case 1: gain_segment<L, 1>(out, n, args.channels, start, step); break;
+            case 2: gain_segment<L, 2>(out, n, args.channels, start, step); break;
+            case 3: gain_segment<L, 3>(out, n, args.channels, start, step); break;
+            case 4: gain_segment<L, 4>(out, n, args.channels, start, step); break;
+            case 5: gain_segment<L, 5>(out, n, args.channels, start, step); break;
+            case 6: gain_segment<L, 6>(out, n, args.channels, start, step); break;
+            case 7: gain_segment<L, 7>(out, n, args.channels, start, step); break;
+            case 8: gain_segment<L, 8>(out, n, args.channels, start, step); break;
+            default: break;
+        }
+        out += n * args.channels;
+        frames -= n;
+        offset = 0;
+    }
+}
+
+} // namespace detail
+} // namespace tonegen
@@ -0,0 +1,94 @@
+#pragma once
+
+// Periodic waves rendered straight into interleaved frames, shared by every ISA translation
+// unit. Each lane runs the phase of the channel its sample belongs to, so a vector holds
+// several channels at once and no per-channel loop or shuffle is needed.
+
+#include "blep_impl.h"
+#include "wavetable_impl.h"
+
+namespace tonegen {
+namespace detail {
+
+template <int Shape, typename L, typename T>
+TONEGEN_INLINE typename L::F periodic_sample(typename L::U phase, const InterleavedArgs& args,
+                                             const BlepConstants<T>& c) {
+    if (Shape == PERIODIC_SAW || Shape == PERIODIC_PULSE || Shape == PERIODIC_TRIANGLE) {
+        const int blep = Shape == PERIODIC_SAW ? BLEP_SAW : Shape == PERIODIC_PULSE ? BLEP_PULSE : BLEP_TRIANGLE;
+        return blep_sample<blep, L>(phase, args.width, c);
+    } else if (Shape == PERIODIC_WAVETABLE) {
+        return wavetable_sample<L>(phase, args.table);
+    } else {
+        return lanes_sine<L, Shape <= PERIODIC_SINE_PRECISE ? Shape : SINE_BALANCED>(phase);
+    }
+}
+
+template <int Shape, typename L, size_t V>
+TONEGEN_INLINE void interleaved_vectors(float* out, size_t frames, const InterleavedArgs& args) {
+    typedef typename L::F F;
+    typedef typename L::U U;
+    const size_t channels = args.channels;
+    const size_t period = V * L::LANES;
+
+    const bool blep = Shape == PERIODIC_SAW || Shape == PERIODIC_PULSE || Shape == PERIODIC_TRIANGLE;
+    float channelDt[MAX_CHANNELS] = {};
+    for (size_t ch = 0; blep && ch < channels; ++ch) {
+        channelDt[ch] = blep_constants(args.increments[ch], args.width).dt;
+    }
+
+    // Lane j of vector v starts at sample v * LANES + j and moves on by one period
+    U phase[V];
+    U stride[V];
+    BlepConstants<F> c[V];
+    for (size_t v = 0; v < V; ++v) {
+        uint32_t phases[L::LANES];
+        uint32_t strides[L::LANES];
+        float dt[L::LANES];
+        for (size_t j = 0; j < L::LANES; ++j) {
+            const size_t sample = v * L::LANES + j;
+            const size_t ch = sample % channels;
+            phases[j] = args.phases[ch] + static_cast<uint32_t>(sample / channels) * args.increments[ch];
+            strides[j] = static_cast<uint32_t>(period / channels) * args.increments[ch];
+            dt[j] = channelDt[ch];
+        }
+        phase[v] = L::loadU(phases);
+        stride[v] = L::loadU(strides);
+        c[v].dt = L::load(dt);
+        c[v].invDt = blep ? 1.0f / c[v].dt : c[v].dt;
+        c[v].width = ScalarLanes::turns(args.width);
+        c[v].pulseScale = pulse_scale(c[v].width);
+    }
+
+    const size_t samples = frames * channels;
+    size_t i = 0;
+    for (; i + period <= samples; i += period) {
+        for (size_t v = 0; v < V; ++v) {
+            L::store(out + i + v * L::LANES, args.amplitude * periodic_sample<Shape, L>(phase[v], args, c[v]));
+            phase[v] += stride[v];
+        }
+    }
+    for (; i < samples; ++i) {
+        const size_t ch = i % channels;
+        const uint32_t tail = args.phases[ch] + static_cast<uint32_t>(i / channels) * args.increments[ch];
+        out[i] = args.amplitude * periodic_sample<Shape, ScalarLanes>(
+                                      tail, args, blep_constants(args.increments[ch], args.width));
+    }
+}
+
+template <int Shape, typename L>
+TONEGEN_INLINE void interleaved_block(float* out, size_t frames, const InterleavedArgs& args) {
+    switch (interleave_period(L::LANES, args.channels)) {
+        case 1: interleaved_vectors<Shape, L, 1>(out, frames, args); break;
+        case 2: interleaved_vectors<Shape, L, 2>(out, frames, args); break;
+        case 3: interleaved_vectors<Shape, L, 3>(out, frames, args); break;
+        case 4: interleaved_vectors<Shape, L, 4>(out, frames, args); break;
+        case 5: interleaved_vectors<Shape, L, 5>(out, frames, args); break;
+        case 6: interleaved_vectors<Shape, L, 6>(out, frames, args); break;
+        case 7: interleaved_vectors<Shape, L, 7>(out, frames, args); break;
+        case 8: interleaved_vectors<Shape, L, 8>(out, frames, args); break;
+        default: break;
+    }
+}
+
+} // namespace detail
+} // namespace tonegen
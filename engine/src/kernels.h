@@ -0,0 +1,190 @@
+#pragma once
+
+// Internal declarations for the per-ISA kernels and the table cpu_dispatch.cpp fills.
+// Each ISA lives in its own translation unit and uses function-level target attributes,
+// so no file needs special compiler flags and one binary carries every kernel.
+
+#include <algorithm>
+#include <cmath>
+
+#include "tonegen/cpu.h"
+#include "tonegen/filter.h"
+#include "tonegen/modulation.h"
+#include "tonegen/noise.h"
+#include "tonegen/sine.h"
+
+#if defined(__GNUC__) || defined(__clang__)
+#define TONEGEN_TARGET(isa) __attribute__((target(isa)))
+#else
+#define TONEGEN_TARGET(isa)
+#endif
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define TONEGEN_X86 1
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__) || defined(__aarch64__)
+#define TONEGEN_NEON 1
+#endif
+
+namespace tonegen {
+namespace detail {
+
+const float PHASE_TO_TURNS = 1.0f / 4294967296.0f;
+
+// Coefficients of r * P(r^2) ~ sin(2*pi*r) on [-0.25, 0.25], lowest order first
+template <int Accuracy> struct SinePoly;
+template <> struct SinePoly<SINE_FAST> {
+    static constexpr int ORDER = 3;
+    static constexpr float C[ORDER] = {6.2812800766394989f, -41.095242688673387f, 73.585514753586622f};
+};
+template <> struct SinePoly<SINE_BALANCED> {
+    static constexpr int ORDER = 4;
+    static constexpr float C[ORDER] = {6.2831640443025059f, -41.337142371122681f, 81.340768888700921f,
+                                       -70.993433282793333f};
+};
+template <> struct SinePoly<SINE_PRECISE> {
+    static constexpr int ORDER = 5;
+    static constexpr float C[ORDER] = {6.2831853018906836f, -41.341691864338294f, 81.60326572878715f,
+                                       -76.598207920452481f, 39.873231779483113f};
+};
+
+// Reference evaluation of one sample; the SIMD kernels use it for their tails
+template <int Accuracy>
+inline float sine_from_phase(uint32_t phase) {
+    typedef SinePoly<Accuracy> Poly;
+    float r = static_cast<float>(static_cast<int32_t>(phase)) * PHASE_TO_TURNS; // [-0.5, 0.5) turns
+    float a = std::fabs(r);
+    a = std::min(a, 0.5f - a); // fold into a quarter turn, sin(pi - x) == sin(x)
+    r = std::copysign(a, r);
+    const float r2 = r * r;
+    float p = Poly::C[Poly::ORDER - 1];
+    for (int k = Poly::ORDER - 2; k >= 0; --k) {
+        p = p * r2 + Poly::C[k];
+    }
+    return r * p;
+}
+
+typedef void (*SineFn)(float* out, size_t frames, uint32_t phase, uint32_t increment, float amplitude);
+
+enum BlepShape { BLEP_SAW, BLEP_PULSE, BLEP_TRIANGLE, BLEP_SHAPE_COUNT };
+
+struct BlepArgs {
+    uint32_t phase;
+    uint32_t increment;
+    float amplitude;
+    uint32_t width; // Pulse duty cycle as a phase offset
+};
+
+typedef void (*BlepFn)(float* out, size_t frames, const BlepArgs& args);
+
+struct WavetableArgs {
+    const float* table; // One mip level, WAVETABLE_SIZE + 1 samples
+    uint32_t phase;
+    uint32_t increment;
+    float amplitude;
+};
+
+typedef void (*WavetableFn)(float* out, size_t frames, const WavetableArgs& args);
+
+// Sums gains[p] * sin(phases[p] + i * increments[p]) by complex rotation; frames must be
+// a multiple of 16
+struct AdditiveArgs {
+    const uint32_t* phases;
+    const uint32_t* increments;
+    const float* gains;
+    size_t count;
+};
+
+typedef void (*AdditiveFn)(float* out, size_t frames, const AdditiveArgs& args);
+
+// White noise in whole groups of NOISE_GROUP_FRAMES samples, uniform in [-1, 1) times amplitude
+struct NoiseArgs {
+    uint32_t key[2];
+    uint32_t stream;
+    uint64_t group; // Index of the first group, position / NOISE_GROUP_FRAMES
+    float amplitude;
+};
+
+typedef void (*NoiseFn)(float* out, size_t groups, const NoiseArgs& args);
+
+// Biquad cascades run as a pipeline across lanes: lane channel * FILTER_MAX_STAGES + stage
+// filters what the previous lane produced one frame earlier
+const size_t BIQUAD_CHANNELS = 2;
+const size_t BIQUAD_LANES = BIQUAD_CHANNELS * FILTER_MAX_STAGES;
+enum { BIQUAD_B0, BIQUAD_B1, BIQUAD_B2, BIQUAD_A1, BIQUAD_A2, BIQUAD_COEFFICIENTS };
+enum { BIQUAD_Z1, BIQUAD_Z2, BIQUAD_Y, BIQUAD_STATE };
+// Keeps every state variable far above the denormal range without an audible trace
+const float BIQUAD_DENORMAL_GUARD = 1e-20f;
+
+struct BiquadArgs {
+    size_t stride;       // Channels per interleaved frame
+    size_t channels;     // Channels in this block, starting at frames[0]; at most BIQUAD_CHANNELS
+    float* coefficients; // [BIQUAD_COEFFICIENTS][BIQUAD_LANES]
+    const float* deltas; // Added to the coefficients before each of the first rampFrames frames
+    size_t rampFrames;
+    float* state;        // [BIQUAD_STATE][BIQUAD_LANES]
+};
+
+typedef void (*BiquadFn)(float* frames, size_t count, const BiquadArgs& args);
+
+// Multiplies interleaved frames by gains interpolated linearly between points, which sit
+// every CONTROL_FRAMES frames; the first frame is offset frames past points[0]
+struct GainArgs {
+    const float* points;
+    size_t offset;
+    size_t channels;
+};
+
+typedef void (*GainFn)(float* out, size_t frames, const GainArgs& args);
+
+// The periodic waves again, each channel of interleaved frames from its own phase
+enum PeriodicShape { PERIODIC_SINE_FAST, PERIODIC_SINE_BALANCED, PERIODIC_SINE_PRECISE, PERIODIC_SAW,
+                     PERIODIC_PULSE, PERIODIC_TRIANGLE, PERIODIC_WAVETABLE, PERIODIC_SHAPE_COUNT };
+
+struct InterleavedArgs {
+    size_t channels; // 1 to MAX_CHANNELS
+    uint32_t phases[MAX_CHANNELS];
+    uint32_t increments[MAX_CHANNELS];
+    float amplitude;
+    uint32_t width;     // Pulse duty cycle as a phase offset
+    const float* table; // Wavetable mip level
+};
+
+typedef void (*InterleavedFn)(float* out, size_t frames, const InterleavedArgs& args);
+
+// Float samples to a device format, saturating; the dithering variants add TPDF noise
+// keyed by seed and each sample's position
+struct ConvertArgs {
+    uint32_t seed;
+    uint32_t position; // Of in[0], counting every sample converted with this seed
+};
+
+typedef void (*ConvertFn)(const float* in, void* out, size_t samples, const ConvertArgs& args);
+
+struct KernelTable {
+    SineFn sine[SINE_ACCURACY_COUNT];
+    BlepFn blep[BLEP_SHAPE_COUNT];
+    WavetableFn wavetable;
+    AdditiveFn additive;
+    NoiseFn noise;
+    BiquadFn biquad;
+    GainFn gain;
+    InterleavedFn interleaved[PERIODIC_SHAPE_COUNT];
+    ConvertFn convert[SAMPLE_FORMAT_COUNT][2]; // [format][dither]
+};
+
+void fill_kernels_scalar(KernelTable& table);
+#ifdef TONEGEN_X86
+void fill_kernels_sse2(KernelTable& table);
+void fill_kernels_avx2(KernelTable& table);
+void fill_kernels_avx512(KernelTable& table);
+#endif
+#ifdef TONEGEN_NEON
+void fill_kernels_neon(KernelTable& table);
+#endif
+
+const KernelTable& kernels();
+
+} // namespace detail
+} // namespace tonegen
@@ -0,0 +1,130 @@
+#include "additive_impl.h"
+#include "biquad_impl.h"
+#include "blep_impl.h"
+#include "convert_impl.h"
+#include "gain_impl.h"
+#include "interleave_impl.h"
+#include "noise_impl.h"
+#include "wavetable_impl.h"
+
+#ifdef TONEGEN_X86
+
+#include <immintrin.h>
+
+namespace tonegen {
+namespace detail {
+
+namespace {
+
+template <int Accuracy>
+TONEGEN_TARGET("avx2,fma")
+void sine_avx2(float* out, size_t frames, uint32_t phase, uint32_t increment, float amplitude) {
+    typedef SinePoly<Accuracy> Poly;
+    const __m256 scale = _mm256_set1_ps(PHASE_TO_TURNS);
+    const __m256 half = _mm256_set1_ps(0.5f);
+    const __m256 signMask = _mm256_set1_ps(-0.0f);
+    const __m256 amp = _mm256_set1_ps(amplitude);
+    const __m256i inc = _mm256_set1_epi32(static_cast<int>(increment));
+    const __m256i step = _mm256_set1_epi32(static_cast<int>(increment * 8));
+    __m256i ph = _mm256_add_epi32(_mm256_set1_epi32(static_cast<int>(phase)),
+                                  _mm256_mullo_epi32(_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7), inc));
+
+    size_t i = 0;
+    for (; i + 8 <= frames; i += 8) {
+        __m256 r = _mm256_mul_ps(_mm256_cvtepi32_ps(ph), scale);
+        const __m256 sign = _mm256_and_ps(r, signMask);
+        __m256 a = _mm256_andnot_ps(signMask, r);
+        a = _mm256_min_ps(a, _mm256_sub_ps(half, a));
+        r = _mm256_or_ps(a, sign);
+        const __m256 r2 = _mm256_mul_ps(r, r);
+        __m256 p = _mm256_set1_ps(Poly::C[Poly::ORDER - 1]);
+        for (int k = Poly::ORDER - 2; k >= 0; --k) {
+            p = _mm256_fmadd_ps(p, r2, _mm256_set1_ps(Poly::C[k]));
+        }
+        _mm256_storeu_ps(out + i, _mm256_mul_ps(_mm256_mul_ps(r, p), amp));
+        ph = _mm256_add_epi32(ph, step);
+    }
+    phase += static_cast<uint32_t>(i) * increment;
+    for (; i < frames; ++i, phase += increment) {
+        out[i] = amplitude * sine_from_phase<Accuracy>(phase);
+    }
+}
+
+template <int Shape>
+TONEGEN_TARGET("avx2,fma")
+void blep_avx2(float* out, size_t frames, const BlepArgs& args) {
+    blep_block<Shape, VectorLanes<32>>(out, frames, args);
+}
+
+TONEGEN_TARGET("avx2,fma")
+void wavetable_avx2(float* out, size_t frames, const WavetableArgs& args) {
+    wavetable_block<VectorLanes<32>>(out, frames, args);
+}
+
+TONEGEN_TARGET("avx2,fma")
+void additive_avx2(float* out, size_t frames, const AdditiveArgs& args) {
+    additive_block<VectorLanes<32>>(out, frames, args);
+}
+
+TONEGEN_TARGET("avx2,fma")
+void noise_avx2(float* out, size_t groups, const NoiseArgs& args) {
+    noise_block<VectorLanes<32>>(out, groups, args);
+}
+
+TONEGEN_TARGET("avx2,fma")
+void biquad_avx2(float* frames, size_t count, const BiquadArgs& args) {
+    biquad_block<VectorLanes<32>>(frames, count, args);
+}
+
+TONEGEN_TARGET("avx2,fma")
+void gain_avx2(float* out, size_t frames, const GainArgs& args) {
+    gain_block<VectorLanes<32>>(out, frames, args);
+}
+
+template <int Shape>
+TONEGEN_TARGET("avx2,fma")
+void interleaved_avx2(float* out, size_t frames, const InterleavedArgs& args) {
+    interleaved_block<Shape, VectorLanes<32>>(out, frames, args);
+}
+
+template <int Format, bool Dither>
+TONEGEN_TARGET("avx2,fma")
+void convert_avx2(const float* in, void* out, size_t samples, const ConvertArgs& args) {
+    convert_block<Format, Dither, VectorLanes<32>>(in, out, samples, args);
+}
+
+} // namespace
+
+void fill_kernels_avx2(KernelTable& table) {
+    table.sine[SINE_FAST] = sine_avx2<SINE_FAST>;
+    table.sine[SINE_BALANCED] = sine_avx2<SINE_BALANCED>;
+    table.sine[SINE_PRECISE] = sine_avx2<SINE_PRECISE>;
+    table.blep[BLEP_SAW] = blep_avx2<BLEP_SAW>;
+    table.blep[BLEP_PULSE] = blep_avx2<BLEP_PULSE>;
+    table.blep[BLEP_TRIANGLE] = blep_avx2<BLEP_TRIANGLE>;
+    table.wavetable = wavetable_avx2;
+    table.additive = additive_avx2;
+    table.noise = noise_avx2;
+    table.biquad = biquad_avx2;
+    table.gain = gain_avx2;
+    table.interleaved[PERIODIC_SINE_FAST] = interleaved_avx2<PERIODIC_SINE_FAST>;
+    table.interleaved[PERIODIC_SINE_BALANCED] = interleaved_avx2<PERIODIC_SINE_BALANCED>;
+    table.interleaved[PERIODIC_SINE_PRECISE] = interleaved_avx2<PERIODIC_SINE_PRECISE>;
+    table.interleaved[PERIODIC_SAW] = interleaved_avx2<PERIODIC_SAW>;
+    table.interleaved[PERIODIC_PULSE] = interleaved_avx2<PERIODIC_PULSE>;
+    table.interleaved[PERIODIC_TRIANGLE] = interleaved_avx2<PERIODIC_TRIANGLE>;
+    table.interleaved[PERIODIC_WAVETABLE] = interleaved_avx2<PERIODIC_WAVETABLE>;
+    table.convert[SAMPLE_UINT8][0] = convert_avx2<SAMPLE_UINT8, false>;
+    table.convert[SAMPLE_UINT8][1] = convert_avx2<SAMPLE_UINT8, true>;
+    table.convert[SAMPLE_INT16][0] = convert_avx2<SAMPLE_INT16, false>;
+    table.convert[SAMPLE_INT16][1] = convert_avx2<SAMPLE_INT16, true>;
+    table.convert[SAMPLE_INT32][0] = convert_avx2<SAMPLE_INT32, false>;
+    table.convert[SAMPLE_INT32][1] = convert_avx2<SAMPLE_INT32, true>;
+    table.convert[SAMPLE_FLOAT][0] = convert_avx2<SAMPLE_FLOAT, false>;
+    table.convert[SAMPLE_FLOAT][1] = convert_avx2<SAMPLE_FLOAT, true>;
+}
+
+} // namespace detail
+} // namespace tonegen
+
+#endif // TONEGEN_X86
@@ -0,0 +1,138 @@
+#include "additive_impl.h"
+#include "biquad_impl.h"
+#include "blep_impl.h"
+#include "convert_impl.h"
+#include "gain_impl.h"
+#include "interleave_impl.h"
+#include "noise_impl.h"
+#include "wavetable_impl.h"
+
+#ifdef TONEGEN_X86
+
+#include <immintrin.h>
+
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ == 12
+// GCC 12 headers build the pass-through operand of unmasked AVX-512 intrinsics from a
+// self-initialised _mm512_undefined_epi32(), which -Wall reports once inlined here.
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+
+namespace tonegen {
+namespace detail {
+
+namespace {
+
+template <int Accuracy>
+TONEGEN_TARGET("avx512f")
+void sine_avx512(float* out, size_t frames, uint32_t phase, uint32_t increment, float amplitude) {
+    typedef SinePoly<Accuracy> Poly;
+    const __m512 scale = _mm512_set1_ps(PHASE_TO_TURNS);
+    const __m512 half = _mm512_set1_ps(0.5f);
+    const __m512i signMask = _mm512_set1_epi32(static_cast<int>(0x80000000u));
+    const __m512 amp = _mm512_set1_ps(amplitude);
+    const __m512i inc = _mm512_set1_epi32(static_cast<int>(increment));
+    const __m512i step = _mm512_set1_epi32(static_cast<int>(increment * 16));
+    __m512i ph = _mm512_add_epi32(
+        _mm512_set1_epi32(static_cast<int>(phase)),
+        _mm512_mullo_epi32(_mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15), inc));
+
+    size_t i = 0;
+    for (; i + 16 <= frames; i += 16) {
+        const __m512 r = _mm512_mul_ps(_mm512_cvtepi32_ps(ph), scale);
+        const __m512i sign = _mm512_and_si512(_mm512_castps_si512(r), signMask);
+        __m512 a = _mm512_abs_ps(r);
+        a = _mm512_min_ps(a, _mm512_sub_ps(half, a));
+        const __m512 folded = _mm512_castsi512_ps(_mm512_or_si512(_mm512_castps_si512(a), sign));
+        const __m512 r2 = _mm512_mul_ps(folded, folded);
+        __m512 p = _mm512_set1_ps(Poly::C[Poly::ORDER - 1]);
+        for (int k = Poly::ORDER - 2; k >= 0; --k) {
+            p = _mm512_fmadd_ps(p, r2, _mm512_set1_ps(Poly::C[k]));
+        }
+        _mm512_storeu_ps(out + i, _mm512_mul_ps(_mm512_mul_ps(folded, p), amp));
+        ph = _mm512_add_epi32(ph, step);
+    }
+    phase += static_cast<uint32_t>(i) * increment;
+    for (; i < frames; ++i, phase += increment) {
+        out[i] = amplitude * sine_from_phase<Accuracy>(phase);
+    }
+}
+
+template <int Shape>
+TONEGEN_TARGET("avx512f")
+void blep_avx512(float* out, size_t frames, const BlepArgs& args) {
+    blep_block<Shape, VectorLanes<64>>(out, frames, args);
+}
+
+TONEGEN_TARGET("avx512f")
+void wavetable_avx512(float* out, size_t frames, const WavetableArgs& args) {
+    // Lane gathers are scalar loads, so 16 lanes only add insert overhead over 8
+    wavetable_block<VectorLanes<32>>(out, frames, args);
+}
+
+TONEGEN_TARGET("avx512f")
+void additive_avx512(float* out, size_t frames, const AdditiveArgs& args) {
+    additive_block<VectorLanes<64>>(out, frames, args);
+}
+
+TONEGEN_TARGET("avx512f")
+void noise_avx512(float* out, size_t groups, const NoiseArgs& args) {
+    noise_block<VectorLanes<64>>(out, groups, args);
+}
+
+TONEGEN_TARGET("avx512f")
+void biquad_avx512(float* frames, size_t count, const BiquadArgs& args) {
+    biquad_block<VectorLanes<64>>(frames, count, args);
+}
+
+TONEGEN_TARGET("avx512f")
+void gain_avx512(float* out, size_t frames, const GainArgs& args) {
+    gain_block<VectorLanes<64>>(out, frames, args);
+}
+
+template <int Shape>
+TONEGEN_TARGET("avx512f")
+void interleaved_avx512(float* out, size_t frames, const InterleavedArgs& args) {
+    interleaved_block<Shape, VectorLanes<64>>(out, frames, args);
+}
+
+template <int Format, bool Dither>
+TONEGEN_TARGET("avx512f")
+void convert_avx512(const float* in, void* out, size_t samples, const ConvertArgs& args) {
+    convert_block<Format, Dither, VectorLanes<64>>(in, out, samples, args);
+}
+
+} // namespace
+
+void fill_kernels_avx512(KernelTable& table) {
+    table.sine[SINE_FAST] = sine_avx512<SINE_FAST>;
+    table.sine[SINE_BALANCED] = sine_avx512<SINE_BALANCED>;
+    table.sine[SINE_PRECISE] = sine_avx512<SINE_PRECISE>;
+    table.blep[BLEP_SAW] = blep_avx512<BLEP_SAW>;
+    table.blep[BLEP_PULSE] = blep_avx512<BLEP_PULSE>;
+    table.blep[BLEP_TRIANGLE] = blep_avx512<BLEP_TRIANGLE>;
+    table.wavetable = wavetable_avx512;
+    table.additive = additive_avx512;
+    table.noise = noise_avx512;
+    table.biquad = biquad_avx512;
+    table.gain = gain_avx512;
+    table.interleaved[PERIODIC_SINE_FAST] = interleaved_avx512<PERIODIC_SINE_FAST>;
+    table.interleaved[PERIODIC_SINE_BALANCED] = interleaved_avx512<PERIODIC_SINE_BALANCED>;
+    table.interleaved[PERIODIC_SINE_PRECISE] = interleaved_avx512<PERIODIC_SINE_PRECISE>;
+    table.interleaved[PERIODIC_SAW] = interleaved_avx512<PERIODIC_SAW>;
+    table.interleaved[PERIODIC_PULSE] = interleaved_avx512<PERIODIC_PULSE>;
+    table.interleaved[PERIODIC_TRIANGLE] = interleaved_avx512<PERIODIC_TRIANGLE>;
+    table.interleaved[PERIODIC_WAVETABLE] = interleaved_avx512<PERIODIC_WAVETABLE>;
+    table.convert[SAMPLE_UINT8][0] = convert_avx512<SAMPLE_UINT8, false>;
+    table.convert[SAMPLE_UINT8][1] = convert_avx512<SAMPLE_UINT8, true>;
+    table.convert[SAMPLE_INT16][0] = convert_avx512<SAMPLE_INT16, false>;
+    table.convert[SAMPLE_INT16][1] = convert_avx512<SAMPLE_INT16, true>;
+    table.convert[SAMPLE_INT32][0] = convert_avx512<SAMPLE_INT32, false>;
+    table.convert[SAMPLE_INT32][1] = convert_avx512<SAMPLE_INT32, true>;
+    table.convert[SAMPLE_FLOAT][0] = convert_avx512<SAMPLE_FLOAT, false>;
+    table.convert[SAMPLE_FLOAT][1] = convert_avx512<SAMPLE_FLOAT, true>;
+}
+
+} // namespace detail
+} // namespace tonegen
+
+#endif // TONEGEN_X86
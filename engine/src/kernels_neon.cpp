@@ -0,0 +1,118 @@
+#include "additive_impl.h"
+#include "biquad_impl.h"
+#include "blep_impl.h"
+#include "convert_impl.h"
+#include "gain_impl.h"
+#include "interleave_impl.h"
+#include "noise_impl.h"
+#include "wavetable_impl.h"
+
+#ifdef TONEGEN_NEON
+
+#include <arm_neon.h>
+
+namespace tonegen {
+namespace detail {
+
+namespace {
+
+template <int Accuracy>
+void sine_neon(float* out, size_t frames, uint32_t phase, uint32_t increment, float amplitude) {
+    typedef SinePoly<Accuracy> Poly;
+    const float32x4_t scale = vdupq_n_f32(PHASE_TO_TURNS);
+    const float32x4_t half = vdupq_n_f32(0.5f);
+    const uint32x4_t signMask = vdupq_n_u32(0x80000000u);
+    const uint32x4_t step = vdupq_n_u32(increment * 4);
+    const uint32_t lanes[4] = {phase, phase + increment, phase + increment * 2, phase + increment * 3};
+    uint32x4_t ph = vld1q_u32(lanes);
+
+    size_t i = 0;
+    for (; i + 4 <= frames; i += 4) {
+        const float32x4_t r = vmulq_f32(vcvtq_f32_s32(vreinterpretq_s32_u32(ph)), scale);
+        float32x4_t a = vabsq_f32(r);
+        a = vminq_f32(a, vsubq_f32(half, a));
+        const float32x4_t folded = vbslq_f32(signMask, r, a);
+        const float32x4_t r2 = vmulq_f32(folded, folded);
+        float32x4_t p = vdupq_n_f32(Poly::C[Poly::ORDER - 1]);
+        for (int k = Poly::ORDER - 2; k >= 0; --k) {
+            p = vmlaq_f32(vdupq_n_f32(Poly::C[k]), p, r2);
+        }
+        vst1q_f32(out + i, vmulq_n_f32(vmulq_f32(folded, p), amplitude));
+        ph = vaddq_u32(ph, step);
+    }
+    phase += static_cast<uint32_t>(i) * increment;
+    for (; i < frames; ++i, phase += increment) {
+        out[i] = amplitude * sine_from_phase<Accuracy>(phase);
+    }
+}
+
+template <int Shape>
+void blep_neon(float* out, size_t frames, const BlepArgs& args) {
+    blep_block<Shape, VectorLanes<16>>(out, frames, args);
+}
+
+void wavetable_neon(float* out, size_t frames, const WavetableArgs& args) {
+    wavetable_block<VectorLanes<16>>(out, frames, args);
+}
+
+void additive_neon(float* out, size_t frames, const AdditiveArgs& args) {
+    additive_block<VectorLanes<16>>(out, frames, args);
+}
+
+void noise_neon(float* out, size_t groups, const NoiseArgs& args) {
+    noise_block<VectorLanes<16>>(out, groups, args);
+}
+
+void biquad_neon(float* frames, size_t count, const BiquadArgs& args) {
+    biquad_block<VectorLanes<16>>(frames, count, args);
+}
+
+void gain_neon(float* out, size_t frames, const GainArgs& args) {
+    gain_block<VectorLanes<16>>(out, frames, args);
+}
+
+template <int Shape>
+void interleaved_neon(float* out, size_t frames, const InterleavedArgs& args) {
+    interleaved_block<Shape, VectorLanes<16>>(out, frames, args);
+}
+
+template <int Format, bool Dither>
+void convert_neon(const float* in, void* out, size_t samples, const ConvertArgs& args) {
+    convert_block<Format, Dither, VectorLanes<16>>(in, out, samples, args);
+}
+
+} // namespace
+
+void fill_kernels_neon(KernelTable& table) {
+    table.sine[SINE_FAST] = sine_neon<SINE_FAST>;
+    table.sine[SINE_BALANCED] = sine_neon<SINE_BALANCED>;
+    table.sine[SINE_PRECISE] = sine_neon<SINE_PRECISE>;
+    table.blep[BLEP_SAW] = blep_neon<BLEP_SAW>;
+    table.blep[BLEP_PULSE] = blep_neon<BLEP_PULSE>;
+    table.blep[BLEP_TRIANGLE] = blep_neon<BLEP_TRIANGLE>;
+    table.wavetable = wavetable_neon;
+    table.additive = additive_neon;
+    table.noise = noise_neon;
+    table.biquad = biquad_neon;
+    table.gain = gain_neon;
+    table.interleaved[PERIODIC_SINE_FAST] = interleaved_neon<PERIODIC_SINE_FAST>;
+    table.interleaved[PERIODIC_SINE_BALANCED] = interleaved_neon<PERIODIC_SINE_BALANCED>;
+    table.interleaved[PERIODIC_SINE_PRECISE] = interleaved_neon<PERIODIC_SINE_PRECISE>;
+    table.interleaved[PERIODIC_SAW] = interleaved_neon<PERIODIC_SAW>;
+    table.interleaved[PERIODIC_PULSE] = interleaved_neon<PERIODIC_PULSE>;
+    table.interleaved[PERIODIC_TRIANGLE] = interleaved_neon<PERIODIC_TRIANGLE>;
+    table.interleaved[PERIODIC_WAVETABLE] = interleaved_neon<PERIODIC_WAVETABLE>;
+    table.convert[SAMPLE_UINT8][0] = convert_neon<SAMPLE_UINT8, false>;
+    table.convert[SAMPLE_UINT8][1] = convert_neon<SAMPLE_UINT8, true>;
+    table.convert[SAMPLE_INT16][0] = convert_neon<SAMPLE_INT16, false>;
+    table.convert[SAMPLE_INT16][1] = convert_neon<SAMPLE_INT16, true>;
+    table.convert[SAMPLE_INT32][0] = convert_neon<SAMPLE_INT32, false>;
+    table.convert[SAMPLE_INT32][1] = convert_neon<SAMPLE_INT32, true>;
+    table.convert[SAMPLE_FLOAT][0] = convert_neon<SAMPLE_FLOAT, false>;
+    table.convert[SAMPLE_FLOAT][1] = convert_neon<SAMPLE_FLOAT, true>;
+}
+
+} // namespace detail
+} // namespace tonegen
+
+#endif // TONEGEN_NEON
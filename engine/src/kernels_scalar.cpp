@@ -0,0 +1,90 @@
+#include "additive_impl.h"
+#include "biquad_impl.h"
+#include "blep_impl.h"
+#include "convert_impl.h"
+#include "gain_impl.h"
+#include "interleave_impl.h"
+#include "noise_impl.h"
+#include "wavetable_impl.h"
+
+namespace tonegen {
+namespace detail {
+
+namespace {
+
+template <int Accuracy>
+void sine_scalar(float* out, size_t frames, uint32_t phase, uint32_t increment, float amplitude) {
+    for (size_t i = 0; i < frames; ++i) {
+        out[i] = amplitude * sine_from_phase<Accuracy>(phase);
+        phase += increment;
+    }
+}
+
+template <int Shape>
+void blep_scalar(float* out, size_t frames, const BlepArgs& args) {
+    blep_block<Shape, ScalarLanes>(out, frames, args);
+}
+
+void wavetable_scalar(float* out, size_t frames, const WavetableArgs& args) {
+    wavetable_block<ScalarLanes>(out, frames, args);
+}
+
+void additive_scalar(float* out, size_t frames, const AdditiveArgs& args) {
+    additive_block<ScalarLanes>(out, frames, args);
+}
+
+void noise_scalar(float* out, size_t groups, const NoiseArgs& args) {
+    noise_block<ScalarLanes>(out, groups, args);
+}
+
+void biquad_scalar(float* frames, size_t count, const BiquadArgs& args) {
+    biquad_block<ScalarLanes>(frames, count, args);
+}
+
+void gain_scalar(float* out, size_t frames, const GainArgs& args) {
+    gain_block<ScalarLanes>(out, frames, args);
+}
+
+template <int Shape>
+void interleaved_scalar(float* out, size_t frames, const InterleavedArgs& args) {
+    interleaved_block<Shape, ScalarLanes>(out, frames, args);
+}
+
+template <int Format, bool Dither>
+void convert_scalar(const float* in, void* out, size_t samples, const ConvertArgs& args) {
+    convert_block<Format, Dither, ScalarLanes>(in, out, samples, args);
+}
+
+} // namespace
+
+void fill_kernels_scalar(KernelTable& table) {
+    table.sine[SINE_FAST] = sine_scalar<SINE_FAST>;
+    table.sine[SINE_BALANCED] = sine_scalar<SINE_BALANCED>;
+    table.sine[SINE_PRECISE] = sine_scalar<SINE_PRECISE>;
+    table.blep[BLEP_SAW] = blep_scalar<BLEP_SAW>;
+    table.blep[BLEP_PULSE] = blep_scalar<BLEP_PULSE>;
+    table.blep[BLEP_TRIANGLE] = blep_scalar<BLEP_TRIANGLE>;
+    table.wavetable = wavetable_scalar;
+    table.additive = additive_scalar;
+    table.noise = noise_scalar;
+    table.biquad = biquad_scalar;
+    table.gain = gain_scalar;
+    table.interleaved[PERIODIC_SINE_FAST] = interleaved_scalar<PERIODIC_SINE_FAST>;
+    table.interleaved[PERIODIC_SINE_BALANCED] = interleaved_scalar<PERIODIC_SINE_BALANCED>;
+    table.interleaved[PERIODIC_SINE_PRECISE] = interleaved_scalar<PERIODIC_SINE_PRECISE>;
+    table.interleaved[PERIODIC_SAW] = interleaved_scalar<PERIODIC_SAW>;
+    table.interleaved[PERIODIC_PULSE] = interleaved_scalar<PERIODIC_PULSE>;
+    table.interleaved[PERIODIC_TRIANGLE] = interleaved_scalar<PERIODIC_TRIANGLE>;
+    table.interleaved[PERIODIC_WAVETABLE] = interleaved_scalar<PERIODIC_WAVETABLE>;
+    table.convert[SAMPLE_UINT8][0] = convert_scalar<SAMPLE_UINT8, false>;
+    table.convert[SAMPLE_UINT8][1] = convert_scalar<SAMPLE_UINT8, true>;
+    table.convert[SAMPLE_INT16][0] = convert_scalar<SAMPLE_INT16, false>;
+    table.convert[SAMPLE_INT16][1] = convert_scalar<SAMPLE_INT16, true>;
+    table.convert[SAMPLE_INT32][0] = convert_scalar<SAMPLE_INT32, false>;
+    table.convert[SAMPLE_INT32][1] = convert_scalar<SAMPLE_INT32, true>;
+    table.convert[SAMPLE_FLOAT][0] = convert_scalar<SAMPLE_FLOAT, false>;
+    table.convert[SAMPLE_FLOAT][1] = convert_scalar<SAMPLE_FLOAT, true>;
+}
+
+} // namespace detail
+} // namespace tonegen
@@ -0,0 +1,129 @@
+#include "additive_impl.h"
+#include "biquad_impl.h"
+#include "blep_impl.h"
+#include "convert_impl.h"
+#include "gain_impl.h"
+#include "interleave_impl.h"
+#include "noise_impl.h"
+#include "wavetable_impl.h"
+
+#ifdef TONEGEN_X86
+
+#include <emmintrin.h>
+
+namespace tonegen {
+namespace detail {
+
+namespace {
+
+template <int Accuracy>
+TONEGEN_TARGET("sse2")
+void sine_sse2(float* out, size_t frames, uint32_t phase, uint32_t increment, float amplitude) {
+    typedef SinePoly<Accuracy> Poly;
+    const __m128 scale = _mm_set1_ps(PHASE_TO_TURNS);
+    const __m128 half = _mm_set1_ps(0.5f);
+    const __m128 signMask = _mm_set1_ps(-0.0f);
+    const __m128 amp = _mm_set1_ps(amplitude);
+    const __m128i step = _mm_set1_epi32(static_cast<int>(increment * 4));
+    __m128i ph = _mm_setr_epi32(static_cast<int>(phase), static_cast<int>(phase + increment),
+                                static_cast<int>(phase + increment * 2), static_cast<int>(phase + increment * 3));
+
+    size_t i = 0;
+    for (; i + 4 <= frames; i += 4) {
+        __m128 r = _mm_mul_ps(_mm_cvtepi32_ps(ph), scale);
+        const __m128 sign = _mm_and_ps(r, signMask);
+        __m128 a = _mm_andnot_ps(signMask, r);
+        a = _mm_min_ps(a, _mm_sub_ps(half, a));
+        r = _mm_or_ps(a, sign);
+        const __m128 r2 = _mm_mul_ps(r, r);
+        __m128 p = _mm_set1_ps(Poly::C[Poly::ORDER - 1]);
+        for (int k = Poly::ORDER - 2; k >= 0; --k) {
+            p = _mm_add_ps(_mm_mul_ps(p, r2), _mm_set1_ps(Poly::C[k]));
+        }
+        _mm_storeu_ps(out + i, _mm_mul_ps(_mm_mul_ps(r, p), amp));
+        ph = _mm_add_epi32(ph, step);
+    }
+    phase += static_cast<uint32_t>(i) * increment;
+    for (; i < frames; ++i, phase += increment) {
+        out[i] = amplitude * sine_from_phase<Accuracy>(phase);
+    }
+}
+
+template <int Shape>
+TONEGEN_TARGET("sse2")
+void blep_sse2(float* out, size_t frames, const BlepArgs& args) {
+    blep_block<Shape, VectorLanes<16>>(out, frames, args);
+}
+
+TONEGEN_TARGET("sse2")
+void wavetable_sse2(float* out, size_t frames, const WavetableArgs& args) {
+    wavetable_block<VectorLanes<16>>(out, frames, args);
+}
+
+TONEGEN_TARGET("sse2")
+void additive_sse2(float* out, size_t frames, const AdditiveArgs& args) {
+    additive_block<VectorLanes<16>>(out, frames, args);
+}
+
+TONEGEN_TARGET("sse2")
+void noise_sse2(float* out, size_t groups, const NoiseArgs& args) {
+    noise_block<VectorLanes<16>>(out, groups, args);
+}
+
+TONEGEN_TARGET("sse2")
+void biquad_sse2(float* frames, size_t count, const BiquadArgs& args) {
+    biquad_block<VectorLanes<16>>(frames, count, args);
+}
+
+TONEGEN_TARGET("sse2")
+void gain_sse2(float* out, size_t frames, const GainArgs& args) {
+    gain_block<VectorLanes<16>>(out, frames, args);
+}
+
+template <int Shape>
+TONEGEN_TARGET("sse2")
+void interleaved_sse2(float* out, size_t frames, const InterleavedArgs& args) {
+    interleaved_block<Shape, VectorLanes<16>>(out, frames, args);
+}
+
+template <int Format, bool Dither>
+TONEGEN_TARGET("sse2")
+void convert_sse2(const float* in, void* out, size_t samples, const ConvertArgs& args) {
+    convert_block<Format, Dither, VectorLanes<16>>(in, out, samples, args);
+}
+
+} // namespace
+
+void fill_kernels_sse2(KernelTable& table) {
+    table.sine[SINE_FAST] = sine_sse2<SINE_FAST>;
+    table.sine[SINE_BALANCED] = sine_sse2<SINE_BALANCED>;
+    table.sine[SINE_PRECISE] = sine_sse2<SINE_PRECISE>;
+    table.blep[BLEP_SAW] = blep_sse2<BLEP_SAW>;
+    table.blep[BLEP_PULSE] = blep_sse2<BLEP_PULSE>;
+    table.blep[BLEP_TRIANGLE] = blep_sse2<BLEP_TRIANGLE>;
+    table.wavetable = wavetable_sse2;
+    table.additive = additive_sse2;
+    table.noise = noise_sse2;
+    table.biquad = biquad_sse2;
+    table.gain = gain_sse2;
+    table.interleaved[PERIODIC_SINE_FAST] = interleaved_sse2<PERIODIC_SINE_FAST>;
+    table.interleaved[PERIODIC_SINE_BALANCED] = interleaved_sse2<PERIODIC_SINE_BALANCED>;
+    table.interleaved[PERIODIC_SINE_PRECISE] = interleaved_sse2<PERIODIC_SINE_PRECISE>;
+    table.interleaved[PERIODIC_SAW] = interleaved_sse2<PERIODIC_SAW>;
+    table.interleaved[PERIODIC_PULSE] = interleaved_sse2<PERIODIC_PULSE>;
+    table.interleaved[PERIODIC_TRIANGLE] = interleaved_sse2<PERIODIC_TRIANGLE>;
+    table.interleaved[PERIODIC_WAVETABLE] = interleaved_sse2<PERIODIC_WAVETABLE>;
+    table.convert[SAMPLE_UINT8][0] = convert_sse2<SAMPLE_UINT8, false>;
+    table.convert[SAMPLE_UINT8][1] = convert_sse2<SAMPLE_UINT8, true>;
+    table.convert[SAMPLE_INT16][0] = convert_sse2<SAMPLE_INT16, false>;
+    table.convert[SAMPLE_INT16][1] = convert_sse2<SAMPLE_INT16, true>;
+    table.convert[SAMPLE_INT32][0] = convert_sse2<SAMPLE_INT32, false>;
+    table.convert[SAMPLE_INT32][1] = convert_sse2<SAMPLE_INT32, true>;
+    table.convert[SAMPLE_FLOAT][0] = convert_sse2<SAMPLE_FLOAT, false>;
+    table.convert[SAMPLE_FLOAT][1] = convert_sse2<SAMPLE_FLOAT, true>;
+}
+
+} // namespace detail
+} // namespace tonegen
+
+#endif // TONEGEN_X86
@@ -0,0 +1,250 @@
+#pragma once
+
+// Lane types the shared kernels are written against: ScalarLanes for reference paths and
+// tails, VectorLanes<Bytes> (GCC/Clang vector extensions) for the ISA kernels, which
+// compile to native SIMD once inlined under a target attribute.
+
+#include <cstring>
+#include <utility>
+
+#include "kernels.h"
+
+#ifdef TONEGEN_X86
+#include <immintrin.h>
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define TONEGEN_INLINE inline __attribute__((always_inline))
+#define TONEGEN_VECTOR_EXTENSIONS 1
+#else
+#define TONEGEN_INLINE inline
+#endif
+
+#if defined(__GNUC__) && !defined(__clang__)
+// Vector arguments never cross a call boundary: every helper is force-inlined into a
+// kernel that carries the matching target attribute. GCC reports at the end of the
+// translation unit, so the warning stays off for the including kernel file.
+#pragma GCC diagnostic ignored "-Wpsabi"
+#endif
+
+namespace tonegen {
+namespace detail {
+
+struct ScalarLanes {
+    typedef float F;
+    typedef int32_t I;
+    typedef uint32_t U;
+    static const size_t LANES = 1;
+
+    static TONEGEN_INLINE U phases(uint32_t phase, uint32_t) { return phase; }
+    // Phase in [0, 1) turns; 24 bits survive the conversion exactly
+    static TONEGEN_INLINE F turns(U phase) {
+        return static_cast<float>(static_cast<int32_t>(phase >> 8)) * (1.0f / 16777216.0f);
+    }
+    // Phase in [-0.5, 0.5) turns
+    static TONEGEN_INLINE F signedTurns(U phase) { return static_cast<float>(static_cast<int32_t>(phase)) * PHASE_TO_TURNS; }
+    // Top 24 bits as a fraction in [-1, 1), exact in float
+    static TONEGEN_INLINE F unit(U bits) { return static_cast<float>(static_cast<int32_t>(bits) >> 8) * (1.0f / 8388608.0f); }
+    // Full 64-bit product a * b split into halves
+    static TONEGEN_INLINE U mulhilo(U a, uint32_t b, U& lo) {
+        const uint64_t p = uint64_t(a) * b;
+        lo = static_cast<uint32_t>(p);
+        return static_cast<uint32_t>(p >> 32);
+    }
+    static TONEGEN_INLINE F splat(float x) { return x; }
+    static TONEGEN_INLINE F ramp(size_t first) { return static_cast<float>(first); }
+    static TONEGEN_INLINE F select(bool mask, F a, F b) { return mask ? a : b; }
+    static TONEGEN_INLINE F max(F a, float b) { return a > b ? a : b; }
+    static TONEGEN_INLINE F min(F a, float b) { return a < b ? a : b; }
+    static TONEGEN_INLINE F abs(F a) { return std::fabs(a); }
+    static TONEGEN_INLINE F gather(const float* table, U index) { return table[index]; }
+    static TONEGEN_INLINE float get(F v, size_t) { return v; }
+    static TONEGEN_INLINE void set(F& v, size_t, float x) { v = x; }
+    // Lanes moved up by one, first entering lane 0
+    static TONEGEN_INLINE F shiftIn(F, float first) { return first; }
+    static TONEGEN_INLINE F load(const float* in) { return *in; }
+    static TONEGEN_INLINE U loadU(const uint32_t* in) { return *in; }
+    static TONEGEN_INLINE void store(float* out, F y) { *out = y; }
+    // Rounds toward zero, as a C cast does
+    static TONEGEN_INLINE I truncate(F x) { return static_cast<int32_t>(x); }
+    static TONEGEN_INLINE F toFloat(U bits) { return static_cast<float>(static_cast<int32_t>(bits)); }
+    // Narrows in-range integers to T and stores them
+    template <typename T>
+    static TONEGEN_INLINE void storeAs(T* out, I v) { *out = static_cast<T>(v); }
+};
+
+#ifdef TONEGEN_VECTOR_EXTENSIONS
+
+template <int Bytes>
+struct VectorTypes {
+    typedef float F __attribute__((vector_size(Bytes)));
+    typedef int32_t I __attribute__((vector_size(Bytes)));
+    typedef uint32_t U __attribute__((vector_size(Bytes)));
+    typedef uint64_t W __attribute__((vector_size(Bytes)));
+};
+
+// 32x32->64 multiply of every lane by a constant, as even and odd lanes. GCC turns a
+// constant 64-bit vector multiply into shift and add chains, so x86 spells out pmuludq.
+template <int Bytes>
+struct VectorMul {
+    typedef typename VectorTypes<Bytes>::U U;
+    typedef typename VectorTypes<Bytes>::W W;
+    static TONEGEN_INLINE U mulhilo(U a, uint32_t b, U& lo) {
+        const W even = ((W)a & 0xffffffffu) * b;
+        const W odd = ((W)a >> 32) * b;
+        lo = (U)((even & 0xffffffffu) | (odd << 32));
+        return (U)((even >> 32) | (odd & ~W{} << 32));
+    }
+};
+
+#ifdef TONEGEN_X86
+
+template <>
+struct VectorMul<16> {
+    typedef VectorTypes<16>::U U;
+    TONEGEN_TARGET("sse2") static inline U mulhilo(U a, uint32_t b, U& lo) {
+        const __m128i m = _mm_set1_epi32(static_cast<int>(b));
+        const __m128i low = _mm_set1_epi64x(0xffffffff);
+        const __m128i even = _mm_mul_epu32((__m128i)a, m);
+        const __m128i odd = _mm_mul_epu32(_mm_srli_epi64((__m128i)a, 32), m);
+        lo = (U)_mm_or_si128(_mm_and_si128(even, low), _mm_slli_epi64(odd, 32));
+        return (U)_mm_or_si128(_mm_srli_epi64(even, 32), _mm_andnot_si128(low, odd));
+    }
+};
+
+template <>
+struct VectorMul<32> {
+    typedef VectorTypes<32>::U U;
+    TONEGEN_TARGET("avx2") static inline U mulhilo(U a, uint32_t b, U& lo) {
+        const __m256i m = _mm256_set1_epi32(static_cast<int>(b));
+        const __m256i even = _mm256_mul_epu32((__m256i)a, m);
+        const __m256i odd = _mm256_mul_epu32(_mm256_srli_epi64((__m256i)a, 32), m);
+        lo = (U)_mm256_mullo_epi32((__m256i)a, m);
+        return (U)_mm256_blend_epi32(_mm256_srli_epi64(even, 32), odd, 0xaa);
+    }
+};
+
+template <>
+struct VectorMul<64> {
+    typedef VectorTypes<64>::U U;
+    TONEGEN_TARGET("avx512f") static inline U mulhilo(U a, uint32_t b, U& lo) {
+        const __m512i m = _mm512_set1_epi32(static_cast<int>(b));
+        const __m512i even = _mm512_mul_epu32((__m512i)a, m);
+        const __m512i odd = _mm512_mul_epu32(_mm512_srli_epi64((__m512i)a, 32), m);
+        lo = (U)_mm512_mullo_epi32((__m512i)a, m);
+        return (U)_mm512_mask_blend_epi32(0xaaaa, _mm512_srli_epi64(even, 32), odd);
+    }
+};
+
+#endif
+
+// The vector typedefs only become dependent types when pulled in through VectorTypes
+template <int Bytes>
+struct VectorLanes {
+    typedef typename VectorTypes<Bytes>::F F;
+    typedef typename VectorTypes<Bytes>::I I;
+    typedef typename VectorTypes<Bytes>::U U;
+    static const size_t LANES = Bytes / 4;
+
+    static TONEGEN_INLINE U phases(uint32_t phase, uint32_t increment) {
+        U lanes;
+        for (size_t j = 0; j < LANES; ++j) {
+            lanes[j] = phase + static_cast<uint32_t>(j) * increment;
+        }
+        return lanes;
+    }
+    static TONEGEN_INLINE F turns(U phase) {
+        return __builtin_convertvector((I)(phase >> 8), F) * (1.0f / 16777216.0f);
+    }
+    static TONEGEN_INLINE F signedTurns(U phase) { return __builtin_convertvector((I)phase, F) * PHASE_TO_TURNS; }
+    static TONEGEN_INLINE F unit(U bits) { return __builtin_convertvector((I)bits >> 8, F) * (1.0f / 8388608.0f); }
+    static TONEGEN_INLINE U mulhilo(U a, uint32_t b, U& lo) { return VectorMul<Bytes>::mulhilo(a, b, lo); }
+    static TONEGEN_INLINE F splat(float x) { return F{} + x; }
+    // first, first + 1, ... across the lanes
+    static TONEGEN_INLINE F ramp(size_t first) {
+        F lanes;
+        for (size_t j = 0; j < LANES; ++j) {
+            lanes[j] = static_cast<float>(first + j);
+        }
+        return lanes;
+    }
+    static TONEGEN_INLINE F select(I mask, F a, F b) { return (F)((mask & (I)a) | (~mask & (I)b)); }
+    static TONEGEN_INLINE F max(F a, float b) { return select(a > b, a, splat(b)); }
+    static TONEGEN_INLINE F min(F a, float b) { return select(a < b, a, splat(b)); }
+    static TONEGEN_INLINE F min(F a, F b) { return select(a < b, a, b); }
+    static TONEGEN_INLINE F abs(F a) { return (F)((I)a & 0x7fffffff); }
+    static TONEGEN_INLINE F gather(const float* table, U index) {
+        F values;
+        for (size_t j = 0; j < LANES; ++j) {
+            values[j] = table[index[j]];
+        }
+        return values;
+    }
+    static TONEGEN_INLINE float get(F v, size_t j) { return v[j]; }
+    static TONEGEN_INLINE void set(F& v, size_t j, float x) { v[j] = x; }
+    static TONEGEN_INLINE F shiftIn(F v, float first) { return shiftIn(v, first, std::make_index_sequence<LANES>()); }
+    // Index LANES - 1 picks from the splat, LANES + j - 1 is lane j - 1 of v
+    template <size_t... J>
+    static TONEGEN_INLINE F shiftIn(F v, float first, std::index_sequence<J...>) {
+#ifdef __clang__
+        return __builtin_shufflevector(splat(first), v, (LANES - 1 + J)...);
+#else
+        return __builtin_shuffle(splat(first), v, I{static_cast<int32_t>(LANES - 1 + J)...});
+#endif
+    }
+    static TONEGEN_INLINE F load(const float* in) {
+        F x;
+        std::memcpy(&x, in, sizeof(x));
+        return x;
+    }
+    static TONEGEN_INLINE U loadU(const uint32_t* in) {
+        U x;
+        std::memcpy(&x, in, sizeof(x));
+        return x;
+    }
+    static TONEGEN_INLINE void store(float* out, F y) { std::memcpy(out, &y, sizeof(y)); }
+    static TONEGEN_INLINE I truncate(F x) { return __builtin_convertvector(x, I); }
+    static TONEGEN_INLINE F toFloat(U bits) { return __builtin_convertvector((I)bits, F); }
+    template <typename T>
+    static TONEGEN_INLINE void storeAs(T* out, I v) {
+        typedef T N __attribute__((vector_size(LANES * sizeof(T))));
+        const N narrow = __builtin_convertvector(v, N);
+        std::memcpy(out, &narrow, sizeof(narrow));
+    }
+};
+
+#else
+
+template <int Bytes>
+struct VectorLanes : ScalarLanes {};
+
+#endif
+
+// Vectors of lanes after which the channel pattern of interleaved frames repeats, at most
+// channels
+inline size_t interleave_period(size_t lanes, size_t channels) {
+    size_t vectors = 1;
+    while ((vectors * lanes) % channels != 0) {
+        ++vectors;
+    }
+    return vectors;
+}
+
+// sine_from_phase for every lane
+template <typename L, int Accuracy>
+TONEGEN_INLINE typename L::F lanes_sine(typename L::U phase) {
+    typedef SinePoly<Accuracy> Poly;
+    const typename L::F r = L::signedTurns(phase);
+    typename L::F a = L::abs(r);
+    a = L::min(a, 0.5f - a);
+    const typename L::F x = L::select(r < 0.0f, -a, a);
+    const typename L::F x2 = x * x;
+    typename L::F p = L::splat(Poly::C[Poly::ORDER - 1]);
+    for (int k = Poly::ORDER - 2; k >= 0; --k) {
+        p = p * x2 + Poly::C[k];
+    }
+    return x * p;
+}
+
+} // namespace detail
+} // namespace tonegen
@@ -0,0 +1,144 @@
+#include "tonegen/loop_cache.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <numeric>
+
+#include "tonegen/tone_generator.h"
+
+namespace tonegen {
+
+namespace {
+
+// Rendered and dropped before the loop is taken, so band-limited edges have settled
+const size_t LOOP_WARMUP_FRAMES = 64;
+
+bool modulated(const ModulationParams& modulation) {
+    const Envelope& envelope = modulation.envelope;
+    return modulation.amplitude.depth != 0 || modulation.pitch.depth != 0 || envelope.attack > 0 ||
+           envelope.decay > 0 || envelope.sustain != 1;
+}
+
+// Whatever exact_loop_frames lets through is fully described by these; the rest only count
+// for the waves that use them. A modulated tone never matches, even with the same carrier.
+bool same_tone(const ToneParams& a, const ToneParams& b) {
+    const bool binaural = a.waveType == BINAURAL_BEATS;
+    const bool sine = a.waveType == SINE || binaural;
+    return !modulated(a.modulation) && !modulated(b.modulation) && a.waveType == b.waveType &&
+           a.frequency == b.frequency && a.channelPhase == b.channelPhase && a.amplitude == b.amplitude &&
+           (!binaural || a.beatFrequency == b.beatFrequency) &&
+           (a.waveType != PULSE || a.pulseWidth == b.pulseWidth) && (!sine || a.sineAccuracy == b.sineAccuracy);
+}
+
+} // namespace
+
+size_t exact_loop_frames(double frequency, int sampleRate, size_t maxFrames) {
+    const double millihertz = frequency * 1000;
+    if (sampleRate <= 0 || !(millihertz >= 1) || millihertz > 1e15) {
+        return 0;
+    }
+    const double whole = std::round(millihertz);
+    if (std::fabs(millihertz - whole) > 1e-6) {
+        return 0;
+    }
+    // frames * frequency / sampleRate whole cycles
+    const uint64_t rate = static_cast<uint64_t>(sampleRate) * 1000;
+    const uint64_t frames = rate / std::gcd(rate, static_cast<uint64_t>(whole));
+    return frames <= maxFrames ? static_cast<size_t>(frames) : 0;
+}
+
+size_t exact_loop_frames(const ToneParams& params, int sampleRate, size_t maxFrames) {
+    if (modulated(params.modulation)) {
+        return 0;
+    }
+    switch (params.waveType) {
+        case SINE:
+        case SQUARE:
+        case SAW:
+        case TRIANGLE:
+        case PULSE:
+            return exact_loop_frames(params.frequency, sampleRate, maxFrames);
+        case BINAURAL_BEATS: {
+            const size_t low = exact_loop_frames(params.frequency, sampleRate, maxFrames);
+            const size_t high = exact_loop_frames(params.frequency + params.beatFrequency, sampleRate, maxFrames);
+            if (low == 0 || high == 0) {
+                return 0;
+            }
+            const size_t both = low / std::gcd(low, high) * high;
+            return both <= maxFrames ? both : 0;
+        }
+        default:
+            return 0;
+    }
+}
+
+size_t ToneLoop::copy(void* out, size_t count, size_t position) const {
+    const size_t bytes = frameBytes();
+    unsigned char* dst = static_cast<unsigned char*>(out);
+    position %= frames;
+    while (count > 0) {
+        const size_t chunk = std::min(count, frames - position);
+        std::memcpy(dst, data.data() + position * bytes, chunk * bytes);
+        dst += chunk * bytes;
+        count -= chunk;
+        position = (position + chunk) % frames;
+    }
+    return position;
+}
+
+LoopCache::LoopCache(int sampleRate, size_t channels, SampleFormat format, size_t capacityBytes)
+    : m_sampleRate(sampleRate), m_channels(std::min(std::max<size_t>(channels, 1), MAX_CHANNELS)), m_format(format),
+      m_capacityBytes(capacityBytes), m_bytes(0), m_hits(0), m_misses(0) {}
+
+std::shared_ptr<const ToneLoop> LoopCache::find(const ToneParams& params) {
+    // Checked before the lookup, so a modulated or aperiodic tone can't hit the loop of its
+    // steady carrier
+    const size_t maxFrames = static_cast<size_t>(LOOP_MAX_SECONDS * m_sampleRate);
+    const size_t periodFrames = exact_loop_frames(params, m_sampleRate, maxFrames);
+    if (periodFrames == 0) {
+        return nullptr;
+    }
+    for (auto it = m_loops.begin(); it != m_loops.end(); ++it) {
+        if (same_tone((*it)->params, params)) {
+            m_loops.splice(m_loops.begin(), m_loops, it);
+            ++m_hits;
+            return m_loops.front();
+        }
+    }
+
+    const size_t frames = (LOOP_MIN_FRAMES + periodFrames - 1) / periodFrames * periodFrames;
+    const size_t bytes = frames * bytes_per_sample(m_format) * m_channels;
+    if (bytes > m_capacityBytes) {
+        return nullptr;
+    }
+
+    ++m_misses;
+    std::shared_ptr<ToneLoop> loop = std::make_shared<ToneLoop>();
+    loop->params = params;
+    loop->format = m_format;
+    loop->channels = m_channels;
+    loop->periodFrames = periodFrames;
+    loop->frames = frames;
+    loop->data.resize(bytes);
+    ToneGenerator generator(m_sampleRate, m_channels);
+    generator.setParams(params);
+    float warmup[LOOP_WARMUP_FRAMES * MAX_CHANNELS];
+    generator.process(warmup, LOOP_WARMUP_FRAMES);
+    generator.process(loop->data.data(), m_format, frames);
+
+    m_loops.push_front(loop);
+    m_bytes += bytes;
+    while (m_bytes > m_capacityBytes) {
+        m_bytes -= m_loops.back()->data.size();
+        m_loops.pop_back();
+    }
+    return loop;
+}
+
+void LoopCache::clear() {
+    m_loops.clear();
+    m_bytes = 0;
+}
+
+} // namespace tonegen
@@ -0,0 +1,201 @@
+#include "tonegen/modulation.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "fft.h"
+#include "kernels.h"
+
+namespace tonegen {
+
+namespace {
+
+// phase_increment already wraps any number of turns into one cycle
+uint64_t start_phase(float turns) {
+    return phase_increment(turns, 1.0);
+}
+
+// cos(2 pi turns) for turns in [0, 1) from the sine kernels' polynomial; std::cos costs more
+// than the rest of a control step
+float fast_cos(double turns) {
+    const int64_t phase = static_cast<int64_t>((turns + 0.25) * 4294967296.0);
+    return detail::sine_from_phase<SINE_BALANCED>(static_cast<uint32_t>(phase));
+}
+
+} // namespace
+
+float lfo_value(const Lfo& lfo, double turns) {
+    const double t = turns - std::floor(turns);
+    const double duty = std::min(std::max(static_cast<double>(lfo.duty), 0.0), 1.0);
+    switch (lfo.shape) {
+        case LFO_TRIANGLE:
+            return static_cast<float>(1 - 4 * std::min(t, 1 - t));
+        case LFO_SQUARE:
+            return t < duty ? 1.0f : -1.0f;
+        case LFO_SAW:
+            return static_cast<float>(1 - 2 * t);
+        case LFO_ISOCHRONIC: {
+            // Rising edge from 0, high until duty, falling edge from duty
+            const double edge = std::min({ISOCHRONIC_EDGE_SECONDS * std::fabs(lfo.rate), duty, 1 - duty});
+            if (t < edge) {
+                return -fast_cos(t / edge / 2);
+            }
+            if (t < duty) {
+                return 1.0f;
+            }
+            if (t < duty + edge) {
+                return fast_cos((t - duty) / edge / 2);
+            }
+            return -1.0f;
+        }
+        default:
+            return fast_cos(t);
+    }
+}
+
+Modulator::Modulator(int sampleRate)
+    : m_sampleRate(sampleRate), m_stage(ENVELOPE_SUSTAIN), m_level(1), m_releaseStep(0), m_offset(0), m_gain(1),
+      m_nextGain(1), m_pitch(1) {
+    setParams(m_params);
+    reset();
+}
+
+void Modulator::setParams(const ModulationParams& params) {
+    m_params = params;
+    m_amplitudePhase.setFrequency(params.amplitude.rate * CONTROL_FRAMES, m_sampleRate);
+    m_pitchPhase.setFrequency(params.pitch.rate * CONTROL_FRAMES, m_sampleRate);
+    settle();
+    // The state already stands at the end of the current segment
+    m_nextGain = currentGain();
+}
+
+void Modulator::reset() {
+    m_amplitudePhase.phase = start_phase(m_params.amplitude.phase);
+    m_pitchPhase.phase = start_phase(m_params.pitch.phase);
+    m_stage = ENVELOPE_ATTACK;
+    m_level = 0;
+    m_offset = 0;
+    settle();
+    m_gain = currentGain();
+    m_pitch = currentPitch();
+    stepState();
+    m_nextGain = currentGain();
+}
+
+void Modulator::noteOff() {
+    if (m_stage != ENVELOPE_DONE) {
+        m_stage = ENVELOPE_RELEASE;
+        m_releaseStep = m_level * envelopeStep(m_params.envelope.release);
+        settle();
+        m_nextGain = currentGain();
+    }
+}
+
+void Modulator::process(float* out, size_t frames, size_t channels) {
+    if (!modulatesAmplitude()) {
+        advance(frames);
+        return;
+    }
+    const detail::GainFn gain = detail::kernels().gain;
+    while (frames > 0) {
+        const size_t chunk = std::min(frames, MAX_BLOCK_FRAMES);
+        detail::GainArgs args;
+        args.points = m_points;
+        args.offset = m_offset;
+        args.channels = channels;
+        size_t count = 0;
+        m_points[count++] = m_gain;
+        advance(chunk, m_points, count);
+        m_points[count++] = m_nextGain;
+        gain(out, chunk, args);
+        out += chunk * channels;
+        frames -= chunk;
+    }
+}
+
+void Modulator::advance(size_t frames) {
+    size_t count = 0;
+    advance(frames, nullptr, count);
+}
+
+void Modulator::advance(size_t frames, float* points, size_t& count) {
+    m_offset += frames;
+    const bool steady = (m_stage == ENVELOPE_SUSTAIN || m_stage == ENVELOPE_DONE) && m_gain == m_nextGain;
+    if (!points && steady && m_params.amplitude.depth == 0 && !modulatesPitch()) {
+        // Nothing would change at the control points, so skip evaluating them
+        const size_t steps = m_offset / CONTROL_FRAMES;
+        m_offset %= CONTROL_FRAMES;
+        m_amplitudePhase.advance(steps);
+        m_pitchPhase.advance(steps);
+        return;
+    }
+    while (m_offset >= CONTROL_FRAMES) {
+        m_offset -= CONTROL_FRAMES;
+        m_gain = m_nextGain;
+        m_pitch = currentPitch();
+        stepState();
+        m_nextGain = currentGain();
+        if (points) {
+            points[count++] = m_gain;
+        }
+    }
+}
+
+float Modulator::currentGain() const {
+    const Lfo& lfo = m_params.amplitude;
+    const float swing = lfo.depth != 0 ? lfo.depth * (1 - lfo_value(lfo, m_amplitudePhase.turns())) / 2 : 0.0f;
+    return (1 - swing) * m_level;
+}
+
+double Modulator::currentPitch() const {
+    const Lfo& lfo = m_params.pitch;
+    return lfo.depth != 0 ? std::exp2(lfo.depth * lfo_value(lfo, m_pitchPhase.turns()) / 12.0) : 1.0;
+}
+
+void Modulator::stepState() {
+    m_amplitudePhase.advance(1);
+    m_pitchPhase.advance(1);
+    const Envelope& envelope = m_params.envelope;
+    switch (m_stage) {
+        case ENVELOPE_ATTACK:
+            m_level += envelopeStep(envelope.attack);
+            break;
+        case ENVELOPE_DECAY:
+            m_level -= (1 - envelope.sustain) * envelopeStep(envelope.decay);
+            break;
+        case ENVELOPE_RELEASE:
+            m_level -= m_releaseStep;
+            break;
+        default:
+            break;
+    }
+    settle();
+}
+
+void Modulator::settle() {
+    const Envelope& envelope = m_params.envelope;
+    const float sustain = std::min(std::max(envelope.sustain, 0.0f), 1.0f);
+    if (m_stage == ENVELOPE_ATTACK && (envelope.attack <= 0 || m_level >= 1)) {
+        m_level = 1;
+        m_stage = ENVELOPE_DECAY;
+    }
+    if (m_stage == ENVELOPE_DECAY && (envelope.decay <= 0 || m_level <= sustain)) {
+        m_stage = ENVELOPE_SUSTAIN;
+    }
+    if (m_stage == ENVELOPE_SUSTAIN) {
+        m_level = sustain;
+    }
+    if (m_stage == ENVELOPE_RELEASE && (envelope.release <= 0 || m_level <= 0)) {
+        m_stage = ENVELOPE_DONE;
+    }
+    if (m_stage == ENVELOPE_DONE) {
+        m_level = 0;
+    }
+}
+
+// Level change per control segment for a full-scale move lasting seconds
+float Modulator::envelopeStep(float seconds) const {
+    return seconds > 0 ? static_cast<float>(CONTROL_FRAMES) / (seconds * static_cast<float>(m_sampleRate)) : 1.0f;
+}
+
+} // namespace tonegen
@@ -0,0 +1,201 @@
+#include "tonegen/noise.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "fft.h"
+#include "kernels.h"
+
+namespace tonegen {
+
+namespace {
+
+// Stream 0 is the white noise itself; pink row k draws from stream k + 1
+detail::NoiseArgs noise_args(uint64_t seed, uint32_t stream, float amplitude) {
+    detail::NoiseArgs args;
+    args.key[0] = static_cast<uint32_t>(seed);
+    args.key[1] = static_cast<uint32_t>(seed >> 32);
+    args.stream = stream;
+    args.group = 0;
+    args.amplitude = amplitude;
+    return args;
+}
+
+void render_white(float* out, size_t frames, detail::NoiseArgs args, uint64_t position) {
+    const detail::NoiseFn noise = detail::kernels().noise;
+    float group[NOISE_GROUP_FRAMES];
+    while (frames > 0) {
+        const size_t offset = static_cast<size_t>(position % NOISE_GROUP_FRAMES);
+        args.group = position / NOISE_GROUP_FRAMES;
+        if (offset == 0 && frames >= NOISE_GROUP_FRAMES) {
+            const size_t groups = frames / NOISE_GROUP_FRAMES;
+            noise(out, groups, args);
+            out += groups * NOISE_GROUP_FRAMES;
+            position += groups * NOISE_GROUP_FRAMES;
+            frames -= groups * NOISE_GROUP_FRAMES;
+        } else {
+            const size_t chunk = std::min(frames, NOISE_GROUP_FRAMES - offset);
+            noise(group, 1, args);
+            std::memcpy(out, group + offset, chunk * sizeof(float));
+            out += chunk;
+            position += chunk;
+            frames -= chunk;
+        }
+    }
+}
+
+int trailing_zeros(uint64_t x) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_ctzll(x);
+#else
+    int n = 0;
+    for (; !(x & 1); x >>= 1) {
+        ++n;
+    }
+    return n;
+#endif
+}
+
+// Index of the value row k holds at sample n. Voss-McCartney updates row trailing_zeros(n)
+// at sample n, so row k changes at n = 2^k, 3 * 2^k, 5 * 2^k, ... and never at n = 0.
+uint64_t row_index(size_t row, uint64_t n) {
+    return (n + (uint64_t(1) << row)) >> (row + 1);
+}
+
+// RMS of the unscaled sums: each uniform term has variance 1/3
+const double PINK_RMS = std::sqrt((PINK_NOISE_ROWS + 1) / 3.0);
+const double BLUE_RMS = std::sqrt(4 / 3.0);   // One row and the white term change per sample
+const double VIOLET_RMS = std::sqrt(2 / 3.0);
+
+float clip(double x) {
+    return static_cast<float>(std::min(std::max(x, -1.0), 1.0));
+}
+
+} // namespace
+
+void white_noise_block(float* out, size_t frames, uint64_t seed, uint64_t position, float amplitude) {
+    render_white(out, frames, noise_args(seed, 0, amplitude), position);
+}
+
+NoiseGenerator::NoiseGenerator(int sampleRate, uint64_t seed)
+    : m_sampleRate(sampleRate), m_color(NOISE_WHITE), m_seed(seed), m_amplitude(DEFAULT_AMPLITUDE),
+      m_position(0), m_rowSum(0), m_previous(0), m_brown(0),
+      m_leak(std::exp(-2 * detail::PI * BROWN_NOISE_CORNER / sampleRate)) {
+    seek(0);
+}
+
+void NoiseGenerator::setColor(NoiseColor color) {
+    if (color != m_color) {
+        m_color = color;
+        seek(m_position);
+    }
+}
+
+void NoiseGenerator::setSeed(uint64_t seed) {
+    if (seed != m_seed) {
+        m_seed = seed;
+        seek(m_position);
+    }
+}
+
+void NoiseGenerator::setAmplitude(float amplitude) {
+    m_amplitude = amplitude;
+}
+
+double NoiseGenerator::rowValue(size_t row, uint64_t index) {
+    const uint64_t group = index / NOISE_GROUP_FRAMES;
+    if (m_rowGroups[row] != group) {
+        detail::NoiseArgs args = noise_args(m_seed, static_cast<uint32_t>(row + 1), 1.0f);
+        args.group = group;
+        detail::kernels().noise(m_rowCache[row], 1, args);
+        m_rowGroups[row] = group;
+    }
+    return m_rowCache[row][index % NOISE_GROUP_FRAMES];
+}
+
+double NoiseGenerator::whiteSample(uint64_t position) {
+    float sample;
+    render_white(&sample, 1, noise_args(m_seed, 0, 1.0f), position);
+    return sample;
+}
+
+void NoiseGenerator::seek(uint64_t position) {
+    m_position = position;
+
+    // Pink rows as of sample position - 1; before the start every row holds its first value.
+    // Values are multiples of 2^-23 below 2^4, so the double sums are exact and don't depend
+    // on the path that led here.
+    m_rowSum = 0;
+    for (size_t k = 0; k < PINK_NOISE_ROWS; ++k) {
+        m_rowGroups[k] = UINT64_MAX;
+        m_rows[k] = rowValue(k, position > 0 ? row_index(k, position - 1) : 0);
+        m_rowSum += m_rows[k];
+    }
+
+    const double white = position > 0 ? whiteSample(position - 1) : 0.0;
+    m_previous = m_color == NOISE_BLUE ? m_rowSum + white : white;
+
+    m_brown = 0;
+    if (m_color == NOISE_BROWN) {
+        // Run the integrator from zero until the leak has forgotten the start, 2^-40 at most;
+        // from sample 0 this is the same run a continuous render makes
+        const double settle = 40 * std::log(2.0) / (1 - m_leak);
+        uint64_t n = position > settle ? position - static_cast<uint64_t>(settle) : 0;
+        while (n < position) {
+            const size_t chunk = static_cast<size_t>(std::min<uint64_t>(position - n, MAX_BLOCK_FRAMES));
+            render_white(m_scratch, chunk, noise_args(m_seed, 0, 1.0f), n);
+            for (size_t i = 0; i < chunk; ++i) {
+                m_brown = m_brown * m_leak + m_scratch[i];
+            }
+            n += chunk;
+        }
+    }
+}
+
+void NoiseGenerator::process(float* out, size_t frames) {
+    render_white(out, frames, noise_args(m_seed, 0, m_color == NOISE_WHITE ? m_amplitude : 1.0f), m_position);
+
+    switch (m_color) {
+        case NOISE_PINK:
+        case NOISE_BLUE: {
+            const double gain = NOISE_COLOR_RMS / (m_color == NOISE_PINK ? PINK_RMS : BLUE_RMS);
+            for (size_t i = 0; i < frames; ++i) {
+                const uint64_t n = m_position + i;
+                const size_t k = n != 0 ? static_cast<size_t>(trailing_zeros(n)) : PINK_NOISE_ROWS;
+                if (k < PINK_NOISE_ROWS) {
+                    const double value = rowValue(k, row_index(k, n));
+                    m_rowSum += value - m_rows[k];
+                    m_rows[k] = value;
+                }
+                const double pink = m_rowSum + out[i];
+                const double y = m_color == NOISE_PINK ? pink : pink - m_previous;
+                m_previous = pink;
+                out[i] = m_amplitude * clip(y * gain);
+            }
+            break;
+        }
+        case NOISE_BROWN: {
+            const double gain = NOISE_COLOR_RMS * std::sqrt(3 * (1 - m_leak * m_leak));
+            for (size_t i = 0; i < frames; ++i) {
+                m_brown = m_brown * m_leak + out[i];
+                out[i] = m_amplitude * clip(m_brown * gain);
+            }
+            break;
+        }
+        case NOISE_VIOLET: {
+            const double gain = NOISE_COLOR_RMS / VIOLET_RMS;
+            for (size_t i = 0; i < frames; ++i) {
+                const double white = out[i];
+                out[i] = m_amplitude * clip((white - m_previous) * gain);
+                m_previous = white;
+            }
+            break;
+        }
+        default:
+            break;
+    }
+    m_position += frames;
+}
+
+} // namespace tonegen
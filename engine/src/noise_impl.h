@@ -0,0 +1,76 @@
+#pragma once
+
+// Philox4x32-10 (Salmon et al., "Parallel random numbers: as easy as 1, 2, 3") shared by
+// every ISA translation unit. Each lane runs its own counter, so the output only depends
+// on the seed and the sample index, never on the lane count.
+
+#include "lanes.h"
+
+namespace tonegen {
+namespace detail {
+
+const uint32_t PHILOX_M0 = 0xD2511F53;
+const uint32_t PHILOX_M1 = 0xCD9E8D57;
+const uint32_t PHILOX_W0 = 0x9E3779B9;
+const uint32_t PHILOX_W1 = 0xBB67AE85;
+const int PHILOX_ROUNDS = 10;
+
+// K independent blocks per call keep the multipliers busy; one block is latency bound
+template <typename L, size_t K>
+TONEGEN_INLINE void philox(typename L::U (&c)[K][4], uint32_t k0, uint32_t k1) {
+    typedef typename L::U U;
+    for (int r = 0; r < PHILOX_ROUNDS; ++r) {
+        for (size_t b = 0; b < K; ++b) {
+            U lo0;
+            U lo1;
+            const U hi0 = L::mulhilo(c[b][0], PHILOX_M0, lo0);
+            const U hi1 = L::mulhilo(c[b][2], PHILOX_M1, lo1);
+            c[b][0] = hi1 ^ c[b][1] ^ k0;
+            c[b][1] = lo1;
+            c[b][2] = hi0 ^ c[b][3] ^ k1;
+            c[b][3] = lo0;
+        }
+        k0 += PHILOX_W0;
+        k1 += PHILOX_W1;
+    }
+}
+
+// Counters for K vectors from counter, LANES apart, and their words stored as samples
+template <typename L, size_t K>
+TONEGEN_INLINE void noise_counters(float* out, uint64_t first, uint64_t counter, const NoiseArgs& args) {
+    typedef typename L::U U;
+    U c[K][4];
+    for (size_t b = 0; b < K; ++b) {
+        const uint64_t t = counter + b * L::LANES;
+        c[b][0] = L::phases(static_cast<uint32_t>(t), 1);
+        c[b][1] = L::phases(static_cast<uint32_t>(t >> 32), 0);
+        c[b][2] = L::phases(args.stream, 0);
+        c[b][3] = U{};
+    }
+    philox<L, K>(c, args.key[0], args.key[1]);
+    for (size_t b = 0; b < K; ++b) {
+        const uint64_t t = counter + b * L::LANES;
+        float* base = out + (t / 16 - first) * NOISE_GROUP_FRAMES + t % 16;
+        for (size_t w = 0; w < 4; ++w) {
+            L::store(base + 16 * w, args.amplitude * L::unit(c[b][w]));
+        }
+    }
+}
+
+// Group g covers samples 64 g .. 64 g + 63: counter 16 g + j yields samples 64 g + 16 w + j
+// for its four words w, so every lane count that divides 16 stores whole vectors
+template <typename L>
+TONEGEN_INLINE void noise_block(float* out, size_t groups, const NoiseArgs& args) {
+    const size_t INTERLEAVE = 4;
+    const uint64_t end = (args.group + groups) * 16;
+    uint64_t counter = args.group * 16;
+    for (; counter + INTERLEAVE * L::LANES <= end; counter += INTERLEAVE * L::LANES) {
+        noise_counters<L, INTERLEAVE>(out, args.group, counter, args);
+    }
+    for (; counter < end; counter += L::LANES) {
+        noise_counters<L, 1>(out, args.group, counter, args);
+    }
+}
+
+} // namespace detail
+} // namespace tonegen
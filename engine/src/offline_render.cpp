@@ -0,0 +1,68 @@
+#include "tonegen/offline_render.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "tonegen/tone_generator.h"
+
+namespace tonegen {
+
+namespace {
+
+double seconds_since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+} // namespace
+
+OfflineStats render_offline(const OfflineJob& job, size_t threads, size_t chunkFrames, ChunkWriter write, void* user) {
+    OfflineStats stats;
+    stats.frames = job.frames;
+    chunkFrames = std::max<size_t>(chunkFrames, 1);
+    stats.chunks = static_cast<size_t>((job.frames + chunkFrames - 1) / chunkFrames);
+    if (threads == 0) {
+        threads = std::max(std::thread::hardware_concurrency(), 1u);
+    }
+    stats.threads = std::max<size_t>(std::min(threads, stats.chunks), 1);
+
+    const auto start = std::chrono::steady_clock::now();
+    std::atomic<size_t> next(0);
+    std::mutex mutex;
+    auto work = [&] {
+        ToneGenerator generator(job.sampleRate, job.channels);
+        generator.setParams(job.params);
+        generator.setDither(job.dither);
+        std::vector<uint8_t> buffer(chunkFrames * generator.channels() * bytes_per_sample(job.format));
+        double busy = 0;
+        for (size_t chunk = next++; chunk < stats.chunks; chunk = next++) {
+            const uint64_t first = static_cast<uint64_t>(chunk) * chunkFrames;
+            const size_t frames = static_cast<size_t>(std::min<uint64_t>(chunkFrames, job.frames - first));
+            const auto rendering = std::chrono::steady_clock::now();
+            generator.seek(first);
+            generator.process(buffer.data(), job.format, frames);
+            busy += seconds_since(rendering);
+            if (write) {
+                write(user, first, buffer.data(), frames);
+            }
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        stats.busySeconds += busy;
+    };
+
+    std::vector<std::thread> workers;
+    for (size_t i = 1; i < stats.threads; ++i) {
+        workers.emplace_back(work);
+    }
+    work();
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+    stats.wallSeconds = seconds_since(start);
+    return stats;
+}
+
+} // namespace tonegen
@@ -0,0 +1,120 @@
+#include "tonegen/openal_loopback.h"
+
+#include <algorithm>
+#include <climits>
+
+namespace tonegen {
+
+namespace {
+
+// From alext.h, which older OpenAL headers lack
+const ALCenum FORMAT_CHANNELS_SOFT = 0x1990;
+const ALCenum FORMAT_TYPE_SOFT = 0x1991;
+const ALCenum UNSIGNED_BYTE_SOFT = 0x1401;
+const ALCenum SHORT_SOFT = 0x1402;
+const ALCenum INT_SOFT = 0x1404;
+const ALCenum FLOAT_SOFT = 0x1406;
+
+ALCenum loopback_type(SampleFormat format) {
+    switch (format) {
+        case SAMPLE_UINT8: return UNSIGNED_BYTE_SOFT;
+        case SAMPLE_INT16: return SHORT_SOFT;
+        case SAMPLE_INT32: return INT_SOFT;
+        case SAMPLE_FLOAT: return FLOAT_SOFT;
+        default: return 0;
+    }
+}
+
+// ALC_MONO_SOFT ... ALC_7POINT1_SOFT; 0 for counts with no layout
+ALCenum loopback_channels(size_t channels) {
+    switch (channels) {
+        case 1: return 0x1500;
+        case 2: return 0x1501;
+        case 4: return 0x1503;
+        case 6: return 0x1504;
+        case 7: return 0x1505;
+        case 8: return 0x1506;
+        default: return 0;
+    }
+}
+
+} // namespace
+
+OpenAlLoopback::OpenAlLoopback()
+    : m_device(nullptr), m_context(nullptr), m_renderSamples(nullptr), m_frameBytes(0), m_frames(0) {}
+
+OpenAlLoopback::~OpenAlLoopback() {
+    close();
+}
+
+bool OpenAlLoopback::open(int sampleRate, size_t channels, SampleFormat format) {
+    close();
+    m_error.clear();
+    if (!alcIsExtensionPresent(nullptr, "ALC_SOFT_loopback")) {
+        return fail("OpenAL has no ALC_SOFT_loopback (it takes OpenAL Soft)");
+    }
+    LoopbackOpenDevice openDevice = reinterpret_cast<LoopbackOpenDevice>(alcGetProcAddress(nullptr, "alcLoopbackOpenDeviceSOFT"));
+    IsRenderFormatSupported isSupported =
+        reinterpret_cast<IsRenderFormatSupported>(alcGetProcAddress(nullptr, "alcIsRenderFormatSupportedSOFT"));
+    m_renderSamples = reinterpret_cast<RenderSamples>(alcGetProcAddress(nullptr, "alcRenderSamplesSOFT"));
+    if (!openDevice || !isSupported || !m_renderSamples) {
+        return fail("OpenAL lists ALC_SOFT_loopback but not its functions");
+    }
+
+    const ALCenum layout = loopback_channels(channels);
+    const ALCenum type = loopback_type(format);
+    m_device = openDevice(nullptr);
+    if (!m_device) {
+        return fail("Failed to open an OpenAL loopback device");
+    }
+    if (layout == 0 || type == 0 || !isSupported(m_device, sampleRate, layout, type)) {
+        close();
+        return fail("The loopback device can't mix " + std::to_string(channels) + " channels of that format at " +
+                    std::to_string(sampleRate) + " Hz");
+    }
+    const ALCint attributes[] = {FORMAT_CHANNELS_SOFT, layout, FORMAT_TYPE_SOFT, type, ALC_FREQUENCY, sampleRate, 0};
+    m_context = alcCreateContext(m_device, attributes);
+    if (!m_context) {
+        close();
+        return fail("Failed to create an OpenAL context on the loopback device");
+    }
+    alcMakeContextCurrent(m_context);
+    m_frameBytes = bytes_per_sample(format) * channels;
+    m_frames = 0;
+    return true;
+}
+
+void OpenAlLoopback::close() {
+    if (m_context) {
+        if (alcGetCurrentContext() == m_context) {
+            alcMakeContextCurrent(nullptr);
+        }
+        alcDestroyContext(m_context);
+        m_context = nullptr;
+    }
+    if (m_device) {
+        alcCloseDevice(m_device);
+        m_device = nullptr;
+    }
+}
+
+void OpenAlLoopback::render(void* out, size_t frames) {
+    if (!m_context) {
+        return;
+    }
+    uint8_t* next = static_cast<uint8_t*>(out);
+    while (frames > 0) {
+        const size_t chunk = std::min<size_t>(frames, INT_MAX / m_frameBytes);
+        m_renderSamples(m_device, next, static_cast<ALCsizei>(chunk));
+        next += chunk * m_frameBytes;
+        frames -= chunk;
+        m_frames += chunk;
+    }
+}
+
+bool OpenAlLoopback::fail(const std::string& message) {
+    m_error = message;
+    return false;
+}
+
+} // namespace tonegen
@@ -0,0 +1,239 @@
+#include "tonegen/openal_stream.h"
+
+#include <algorithm>
+#include <chrono>
+
+namespace tonegen {
+
+namespace {
+
+// From alext.h, which older OpenAL headers lack
+const ALenum SEC_OFFSET_LATENCY_SOFT = 0x1201;
+typedef ALsizei(AL_APIENTRY* BufferCallback)(ALvoid* userptr, ALvoid* data, ALsizei bytes);
+typedef void(AL_APIENTRY* BufferCallbackSoft)(ALuint buffer, ALenum format, ALsizei rate, BufferCallback callback,
+                                              ALvoid* userptr);
+
+// Float output needs AL_EXT_FLOAT32, and more than two channels AL_EXT_MCFORMATS on top
+SampleFormat device_format() {
+    return alIsExtensionPresent("AL_EXT_FLOAT32") ? SAMPLE_FLOAT : SAMPLE_INT16;
+}
+
+ALenum al_format(size_t channels, SampleFormat format) {
+    if (channels > 2 && !alIsExtensionPresent("AL_EXT_MCFORMATS")) {
+        return AL_NONE;
+    }
+    const bool isFloat = format == SAMPLE_FLOAT;
+    switch (channels) {
+        case 1: return isFloat ? alGetEnumValue("AL_FORMAT_MONO_FLOAT32") : AL_FORMAT_MONO16;
+        case 2: return isFloat ? alGetEnumValue("AL_FORMAT_STEREO_FLOAT32") : AL_FORMAT_STEREO16;
+        case 4: return alGetEnumValue(isFloat ? "AL_FORMAT_QUAD32" : "AL_FORMAT_QUAD16");
+        case 6: return alGetEnumValue(isFloat ? "AL_FORMAT_51CHN32" : "AL_FORMAT_51CHN16");
+        case 7: return alGetEnumValue(isFloat ? "AL_FORMAT_61CHN32" : "AL_FORMAT_61CHN16");
+        case 8: return alGetEnumValue(isFloat ? "AL_FORMAT_71CHN32" : "AL_FORMAT_71CHN16");
+        default: return AL_NONE;
+    }
+}
+
+} // namespace
+
+std::vector<ALCint> openal_context_attributes(int sampleRate, size_t periodFrames) {
+    if (periodFrames >= OPENAL_DEFAULT_PERIOD_FRAMES) {
+        return {0};
+    }
+    const size_t refresh = static_cast<size_t>(sampleRate) / std::max<size_t>(periodFrames, 1);
+    return {ALC_FREQUENCY, sampleRate, ALC_REFRESH, static_cast<ALCint>(std::max<size_t>(refresh, 1)), 0};
+}
+
+OpenAlStream::OpenAlStream(ToneGenerator& generator, size_t bufferFrames, size_t bufferCount)
+    : m_generator(generator), m_bufferFrames(std::max<size_t>(bufferFrames, 1)),
+      m_sampleFormat(device_format()), m_frameBytes(bytes_per_sample(m_sampleFormat) * generator.channels()),
+      m_format(al_format(generator.channels(), m_sampleFormat)), m_source(0),
+      m_buffers(std::max<size_t>(bufferCount, 2)), m_arena(BufferArena::bytesFor<uint8_t>(m_bufferFrames * m_frameBytes)),
+      m_samples(m_arena.allocate<uint8_t>(m_bufferFrames * m_frameBytes)), m_playing(false), m_looping(false),
+      m_allowCallback(true), m_usingCallback(false), m_manualRefill(false), m_getSourcedv(nullptr), m_underruns(0),
+      m_allocations(0), m_queuedSeconds(0), m_deviceSeconds(0), m_stop(false) {
+    alGenSources(1, &m_source);
+    alGenBuffers(static_cast<ALsizei>(m_buffers.size()), m_buffers.data());
+    if (alIsExtensionPresent("AL_SOFT_source_latency")) {
+        m_getSourcedv = reinterpret_cast<GetSourcedv>(alGetProcAddress("alGetSourcedvSOFT"));
+    }
+}
+
+OpenAlStream::~OpenAlStream() {
+    stop();
+    alDeleteSources(1, &m_source);
+    alDeleteBuffers(static_cast<ALsizei>(m_buffers.size()), m_buffers.data());
+}
+
+bool OpenAlStream::start() {
+    if (m_playing) {
+        return true;
+    }
+    if (m_format == AL_NONE) {
+        return false;
+    }
+
+    BufferCallbackSoft bufferCallback = nullptr;
+    if (m_allowCallback && alIsExtensionPresent("AL_SOFT_callback_buffer")) {
+        bufferCallback = reinterpret_cast<BufferCallbackSoft>(alGetProcAddress("alBufferCallbackSOFT"));
+    }
+    m_usingCallback = bufferCallback != nullptr;
+    if (m_usingCallback) {
+        bufferCallback(m_buffers[0], m_format, m_generator.sampleRate(), &OpenAlStream::renderCallback, this);
+        alSourcei(m_source, AL_BUFFER, static_cast<ALint>(m_buffers[0]));
+        alSourcePlay(m_source);
+    } else {
+        for (ALuint buffer : m_buffers) {
+            fill(buffer);
+            alSourceQueueBuffers(m_source, 1, &buffer);
+        }
+        alSourcePlay(m_source);
+        if (!m_manualRefill) {
+            m_stop.store(false, std::memory_order_relaxed);
+            m_thread = std::thread(&OpenAlStream::run, this);
+        }
+    }
+    m_playing = true;
+    return true;
+}
+
+bool OpenAlStream::startLoop(const ToneLoop& loop) {
+    if (m_format == AL_NONE || loop.format != m_sampleFormat || loop.channels != m_generator.channels()) {
+        return false;
+    }
+    stop();
+    alBufferData(m_buffers[0], m_format, loop.data.data(), static_cast<ALsizei>(loop.data.size()),
+                 m_generator.sampleRate());
+    alSourcei(m_source, AL_BUFFER, static_cast<ALint>(m_buffers[0]));
+    alSourcei(m_source, AL_LOOPING, AL_TRUE);
+    alSourcePlay(m_source);
+    m_usingCallback = false;
+    m_looping = true;
+    m_playing = true;
+    return true;
+}
+
+void OpenAlStream::stop() {
+    if (!m_playing) {
+        return;
+    }
+    if (m_thread.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stop.store(true, std::memory_order_relaxed);
+        }
+        m_wake.notify_one();
+        m_thread.join();
+    }
+    // OpenAL Soft applies the stop between mixes, so the callback doesn't run past here
+    alSourceStop(m_source);
+    if (m_looping) {
+        alSourcei(m_source, AL_LOOPING, AL_FALSE);
+        m_looping = false;
+    }
+    alSourcei(m_source, AL_BUFFER, 0);
+    m_queuedSeconds.store(0, std::memory_order_relaxed);
+    m_deviceSeconds.store(0, std::memory_order_relaxed);
+    m_playing = false;
+}
+
+RealtimeStatus OpenAlStream::realtimeStatus() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_realtimeStatus;
+}
+
+void OpenAlStream::run() {
+    const RealtimeStatus realtime = enter_realtime(m_realtimeOptions);
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_realtimeStatus = realtime;
+    }
+
+    while (!m_stop.load(std::memory_order_relaxed)) {
+        // Sleeps until the head buffer is done; if the offset moves in coarse steps and this
+        // wakes a little early, the next pass just sleeps for the rest
+        const double wait = std::max(refill(), 0.0005);
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_wake.wait_for(lock, std::chrono::duration<double>(wait),
+                        [this] { return m_stop.load(std::memory_order_relaxed); });
+    }
+}
+
+double OpenAlStream::refill() {
+    ALint processed = 0;
+    alGetSourcei(m_source, AL_BUFFERS_PROCESSED, &processed);
+    for (; processed > 0; --processed) {
+        ALuint buffer;
+        alSourceUnqueueBuffers(m_source, 1, &buffer);
+        fill(buffer);
+        alSourceQueueBuffers(m_source, 1, &buffer);
+    }
+
+    ALint state;
+    alGetSourcei(m_source, AL_SOURCE_STATE, &state);
+    if (state != AL_PLAYING) {
+        // The whole queue played out before we got back to it
+        m_underruns.store(m_underruns.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        alSourcePlay(m_source);
+    }
+
+    // The queue is full again: everything in it after the offset plays before a new block
+    const double bufferSeconds = static_cast<double>(m_bufferFrames) / m_generator.sampleRate();
+    double deviceSeconds = 0;
+    const double offset = playbackOffset(&deviceSeconds);
+    m_queuedSeconds.store(bufferSeconds * m_buffers.size() - offset, std::memory_order_relaxed);
+    m_deviceSeconds.store(deviceSeconds, std::memory_order_relaxed);
+    return bufferSeconds - offset;
+}
+
+StreamLatency OpenAlStream::latency() const {
+    StreamLatency latency;
+    if (m_usingCallback) {
+        if (m_playing) {
+            playbackOffset(&latency.deviceSeconds);
+        }
+    } else {
+        latency.queuedSeconds = m_queuedSeconds.load(std::memory_order_relaxed);
+        latency.deviceSeconds = m_deviceSeconds.load(std::memory_order_relaxed);
+    }
+    return latency;
+}
+
+double OpenAlStream::playbackOffset(double* deviceLatency) const {
+    // Processed buffers are unqueued as soon as they are seen, so the offset is into the head one
+    if (m_getSourcedv) {
+        ALdouble values[2]; // Offset and output latency, in seconds
+        m_getSourcedv(m_source, SEC_OFFSET_LATENCY_SOFT, values);
+        *deviceLatency = values[1];
+        return values[0];
+    }
+    ALint sample = 0;
+    alGetSourcei(m_source, AL_SAMPLE_OFFSET, &sample);
+    *deviceLatency = 0;
+    return static_cast<double>(sample) / m_generator.sampleRate();
+}
+
+void OpenAlStream::fill(ALuint buffer) {
+    render(m_samples, m_bufferFrames);
+    const size_t bytes = m_bufferFrames * m_frameBytes;
+    alBufferData(buffer, m_format, m_samples, static_cast<ALsizei>(bytes), m_generator.sampleRate());
+}
+
+void OpenAlStream::render(void* out, size_t frames) {
+    // Only the generator is counted: what OpenAL allocates inside alBufferData is its own business
+    const uint64_t allocations = thread_allocations();
+    m_generator.process(out, m_sampleFormat, frames);
+    if (thread_allocations() != allocations) {
+        m_allocations.fetch_add(thread_allocations() - allocations, std::memory_order_relaxed);
+    }
+}
+
+ALsizei AL_APIENTRY OpenAlStream::renderCallback(ALvoid* stream, ALvoid* data, ALsizei bytes) {
+    // Runs on the OpenAL mixer thread, which process() is safe for: it neither locks nor allocates
+    OpenAlStream* self = static_cast<OpenAlStream*>(stream);
+    const size_t frames = static_cast<size_t>(bytes) / self->m_frameBytes;
+    self->render(data, frames);
+    return static_cast<ALsizei>(frames * self->m_frameBytes);
+}
+
+} // namespace tonegen
@@ -0,0 +1,233 @@
+#include "tonegen/oscillator.h"
+
+#include <algorithm>
+
+#include "tonegen/blep.h"
+#include "tonegen/sine.h"
+#include "kernels.h"
+
+namespace tonegen {
+
+Oscillator::Oscillator(int sampleRate)
+    : m_sampleRate(sampleRate), m_waveType(SINE), m_frequency(440), m_channels(1), m_amplitude(DEFAULT_AMPLITUDE),
+      m_sineAccuracy(SINE_BALANCED), m_pulseWidth(0.5f), m_noise(sampleRate) {
+    for (size_t c = 0; c < MAX_CHANNELS; ++c) {
+        m_detune[c] = 0;
+        m_phaseOffsets[c] = 0;
+    }
+    setFrequency(m_frequency);
+}
+
+void Oscillator::setWaveType(WaveType waveType) {
+    m_waveType = waveType;
+    switch (waveType) {
+        case PINK_NOISE: m_noise.setColor(NOISE_PINK); break;
+        case BROWN_NOISE: m_noise.setColor(NOISE_BROWN); break;
+        case BLUE_NOISE: m_noise.setColor(NOISE_BLUE); break;
+        case VIOLET_NOISE: m_noise.setColor(NOISE_VIOLET); break;
+        default: m_noise.setColor(NOISE_WHITE); break;
+    }
+}
+
+void Oscillator::setFrequency(double frequency) {
+    m_frequency = frequency;
+    for (size_t c = 0; c < MAX_CHANNELS; ++c) {
+        m_baseIncrements[c] = phase_increment(frequency + m_detune[c], m_sampleRate);
+    }
+    updateIncrements(1);
+}
+
+void Oscillator::setPitchRatio(double ratio) {
+    updateIncrements(ratio);
+}
+
+void Oscillator::updateIncrements(double ratio) {
+    for (size_t c = 0; c < m_channels; ++c) {
+        const double scaled = static_cast<double>(m_baseIncrements[c]) * ratio;
+        if (scaled >= 0 && scaled < 18446744073709551616.0) {
+            m_phases[c].increment = static_cast<uint64_t>(scaled);
+        } else {
+            m_phases[c].setFrequency((m_frequency + m_detune[c]) * ratio, m_sampleRate);
+        }
+    }
+}
+
+void Oscillator::setAmplitude(float amplitude) {
+    m_amplitude = amplitude;
+    m_noise.setAmplitude(amplitude);
+}
+
+void Oscillator::setSineAccuracy(SineAccuracy accuracy) {
+    m_sineAccuracy = accuracy;
+}
+
+void Oscillator::setPulseWidth(float width) {
+    m_pulseWidth = std::min(std::max(width, 0.0f), 1.0f);
+}
+
+void Oscillator::setWavetable(const Wavetable& table) {
+    m_wavetable = table;
+}
+
+void Oscillator::setNoiseSeed(uint64_t seed) {
+    m_noise.setSeed(seed);
+}
+
+void Oscillator::setChannels(size_t channels) {
+    channels = std::min(std::max<size_t>(channels, 1), MAX_CHANNELS);
+    // New channels pick up channel 0's timeline at their offset
+    for (size_t c = m_channels; c < channels; ++c) {
+        m_phases[c].phase = m_phases[0].phase - m_phaseOffsets[0] + m_phaseOffsets[c];
+    }
+    m_channels = channels;
+    updateIncrements(1);
+}
+
+void Oscillator::setChannelOffset(size_t channel, double frequency, double phase) {
+    if (channel >= MAX_CHANNELS) {
+        return;
+    }
+    const uint64_t offset = phase_increment(phase, 1.0); // Wraps turns into one cycle
+    m_phases[channel].phase += offset - m_phaseOffsets[channel];
+    m_phaseOffsets[channel] = offset;
+    m_detune[channel] = frequency;
+    m_baseIncrements[channel] = phase_increment(m_frequency + frequency, m_sampleRate);
+    updateIncrements(1);
+}
+
+void Oscillator::reset() {
+    for (size_t c = 0; c < MAX_CHANNELS; ++c) {
+        m_phases[c].phase = m_phaseOffsets[c];
+    }
+    m_noise.seek(0);
+}
+
+void Oscillator::skip(uint64_t frames) {
+    for (size_t c = 0; c < m_channels; ++c) {
+        m_phases[c].phase += m_phases[c].increment * frames;
+    }
+    switch (m_waveType) {
+        case WHITE_NOISE:
+        case PINK_NOISE:
+        case BROWN_NOISE:
+        case BLUE_NOISE:
+        case VIOLET_NOISE:
+            m_noise.seek(m_noise.position() + frames);
+            break;
+        default:
+            break;
+    }
+}
+
+void Oscillator::process(float* out, size_t frames) {
+    switch (m_waveType) {
+        case SINE:
+        case SQUARE:
+        case SAW:
+        case TRIANGLE:
+        case PULSE:
+        case WAVETABLE:
+            if (m_channels == 1) {
+                renderPeriodic(out, frames);
+            } else {
+                renderInterleaved(out, frames);
+            }
+            break;
+        case WHITE_NOISE:
+        case PINK_NOISE:
+        case BROWN_NOISE:
+        case BLUE_NOISE:
+        case VIOLET_NOISE:
+            if (m_channels == 1) {
+                m_noise.process(out, frames);
+                break;
+            }
+            for (size_t done = 0; done < frames;) {
+                const size_t chunk = std::min(frames - done, MAX_BLOCK_FRAMES);
+                m_noise.process(m_scratch, chunk);
+                for (size_t i = 0; i < chunk; ++i) {
+                    std::fill_n(out + (done + i) * m_channels, m_channels, m_scratch[i]);
+                }
+                done += chunk;
+            }
+            break;
+        default:
+            std::fill_n(out, frames * m_channels, 0.0f);
+            break;
+    }
+    for (size_t c = 0; c < m_channels; ++c) {
+        m_phases[c].advance(frames);
+    }
+}
+
+void Oscillator::renderPeriodic(float* out, size_t frames) {
+    // Resync the 32-bit kernel phase every MAX_BLOCK_FRAMES to keep its rounding negligible
+    PhaseAccumulator phase = m_phases[0];
+    while (frames > 0) {
+        const size_t chunk = std::min(frames, MAX_BLOCK_FRAMES);
+        const uint32_t phase32 = phase.phase32();
+        const uint32_t increment32 = phase.increment32();
+        switch (m_waveType) {
+            case SQUARE:
+                pulse_block(out, chunk, phase32, increment32, m_amplitude, 0.5f);
+                break;
+            case SAW:
+                saw_block(out, chunk, phase32, increment32, m_amplitude);
+                break;
+            case TRIANGLE:
+                triangle_block(out, chunk, phase32, increment32, m_amplitude);
+                break;
+            case PULSE:
+                pulse_block(out, chunk, phase32, increment32, m_amplitude, m_pulseWidth);
+                break;
+            case WAVETABLE:
+                wavetable_block(out, chunk, m_wavetable.level(Wavetable::levelFor(increment32)), phase32,
+                                increment32, m_amplitude * m_wavetable.gain());
+                break;
+            default:
+                sine_block(out, chunk, phase32, increment32, m_amplitude, m_sineAccuracy);
+                break;
+        }
+        phase.advance(chunk);
+        out += chunk;
+        frames -= chunk;
+    }
+}
+
+void Oscillator::renderInterleaved(float* out, size_t frames) {
+    detail::PeriodicShape shape;
+    switch (m_waveType) {
+        case SQUARE:
+        case PULSE: shape = detail::PERIODIC_PULSE; break;
+        case SAW: shape = detail::PERIODIC_SAW; break;
+        case TRIANGLE: shape = detail::PERIODIC_TRIANGLE; break;
+        case WAVETABLE: shape = detail::PERIODIC_WAVETABLE; break;
+        default: shape = static_cast<detail::PeriodicShape>(detail::PERIODIC_SINE_FAST + m_sineAccuracy); break;
+    }
+    const detail::InterleavedFn render = detail::kernels().interleaved[shape];
+    const float width = m_waveType == SQUARE ? 0.5f : m_pulseWidth;
+
+    detail::InterleavedArgs args;
+    args.channels = m_channels;
+    args.width = static_cast<uint32_t>(static_cast<double>(width) * 4294967295.0);
+    args.amplitude = m_waveType == WAVETABLE ? m_amplitude * m_wavetable.gain() : m_amplitude;
+    PhaseAccumulator phases[MAX_CHANNELS];
+    std::copy(m_phases, m_phases + m_channels, phases);
+    while (frames > 0) {
+        const size_t chunk = std::min(frames, MAX_BLOCK_FRAMES);
+        uint32_t highest = 0;
+        for (size_t c = 0; c < m_channels; ++c) {
+            args.phases[c] = phases[c].phase32();
+            args.increments[c] = phases[c].increment32();
+            highest = std::max(highest, args.increments[c]);
+            phases[c].advance(chunk);
+        }
+        // The mip level of the highest channel keeps every channel band-limited
+        args.table = m_waveType == WAVETABLE ? m_wavetable.level(Wavetable::levelFor(highest)) : nullptr;
+        render(out, chunk, args);
+        out += chunk * m_channels;
+        frames -= chunk;
+    }
+}
+
+} // namespace tonegen
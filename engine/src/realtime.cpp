@@ -0,0 +1,175 @@
+#include "tonegen/realtime.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <unistd.h>
+#define TONEGEN_POSIX_REALTIME 1
+#endif
+#if defined(__linux__)
+#include <sys/syscall.h>
+#endif
+
+namespace tonegen {
+
+namespace {
+
+const size_t STACK_CHUNK = 4096;
+// Nice level asked for when SCHED_FIFO is denied; unprivileged users may get it through RLIMIT_NICE
+const int FALLBACK_NICE = -10;
+
+// Touches bytes of stack below the caller one page at a time
+#if defined(__GNUC__) || defined(__clang__)
+__attribute__((noinline))
+#endif
+void prefault_stack(size_t bytes) {
+    volatile unsigned char chunk[STACK_CHUNK];
+    chunk[0] = 0;
+    chunk[STACK_CHUNK - 1] = 0;
+    if (bytes > STACK_CHUNK) {
+        prefault_stack(bytes - STACK_CHUNK);
+    }
+    chunk[0] = chunk[STACK_CHUNK - 1]; // Keeps the frame alive across the call
+}
+
+void append(std::string& message, const char* what, int error) {
+    if (!message.empty()) {
+        message += "; ";
+    }
+    message += what;
+    message += ": ";
+    message += std::strerror(error);
+}
+
+#ifdef TONEGEN_POSIX_REALTIME
+bool lock_memory(std::string& message) {
+    // MCL_FUTURE under a finite RLIMIT_MEMLOCK would make later allocations fail once
+    // they reach it, so it is only asked for when the limit can't be hit
+    struct rlimit limit;
+    const bool unlimited = geteuid() == 0 || (getrlimit(RLIMIT_MEMLOCK, &limit) == 0 && limit.rlim_cur == RLIM_INFINITY);
+    if (mlockall(unlimited ? MCL_CURRENT | MCL_FUTURE : MCL_CURRENT) != 0) {
+        append(message, "mlockall denied, raise RLIMIT_MEMLOCK (ulimit -l)", errno);
+        return false;
+    }
+    return true;
+}
+
+int fifo_priority(int requested) {
+    int priority = requested > 0 ? requested : DEFAULT_REALTIME_PRIORITY;
+    priority = std::min(std::max(priority, sched_get_priority_min(SCHED_FIFO)), sched_get_priority_max(SCHED_FIFO));
+    // Unprivileged threads may go as high as RLIMIT_RTPRIO allows, so ask for no more than that
+    struct rlimit limit;
+    if (geteuid() != 0 && getrlimit(RLIMIT_RTPRIO, &limit) == 0 && limit.rlim_cur != RLIM_INFINITY &&
+        limit.rlim_cur > 0 && static_cast<rlim_t>(priority) > limit.rlim_cur) {
+        priority = static_cast<int>(limit.rlim_cur);
+    }
+    return priority;
+}
+#endif
+
+} // namespace
+
+RealtimeStatus enter_realtime(const RealtimeOptions& options) {
+    RealtimeStatus status;
+    if (!options.enabled) {
+        return status;
+    }
+    status.requested = true;
+
+#ifdef TONEGEN_POSIX_REALTIME
+    if (options.lockMemory) {
+        status.memoryLocked = lock_memory(status.message);
+    }
+    // With memory locked these pages stay in; without, they are at least mapped before the first block
+    prefault_stack(options.stackBytes);
+
+    sched_param param;
+    std::memset(&param, 0, sizeof(param));
+    param.sched_priority = fifo_priority(options.priority);
+    const int error = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+    if (error == 0) {
+        status.scheduled = true;
+        status.priority = param.sched_priority;
+    } else {
+        append(status.message, "SCHED_FIFO denied, raise RLIMIT_RTPRIO (rtprio in limits.conf)", error);
+#if defined(__linux__)
+        // Linux nice levels are per thread when given a thread id
+        const id_t thread = static_cast<id_t>(syscall(SYS_gettid));
+        if (setpriority(PRIO_PROCESS, thread, FALLBACK_NICE) == 0) {
+            status.niced = true;
+            status.priority = FALLBACK_NICE;
+        }
+#endif
+    }
+
+    if (options.cpu >= 0) {
+#if defined(__linux__)
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        CPU_SET(options.cpu, &cpus);
+        const int pinError = pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+        if (pinError == 0) {
+            status.pinned = true;
+        } else {
+            append(status.message, "CPU affinity denied", pinError);
+        }
+#else
+        append(status.message, "CPU affinity", ENOTSUP);
+#endif
+    }
+#else
+    append(status.message, "real-time scheduling", ENOTSUP);
+#endif
+    return status;
+}
+
+bool parse_realtime_option(const char* arg, RealtimeOptions& options) {
+    if (std::strcmp(arg, "--realtime") == 0) {
+        options.enabled = true;
+        return true;
+    }
+    if (std::strncmp(arg, "--realtime=", 11) == 0) {
+        options.enabled = true;
+        options.cpu = std::atoi(arg + 11);
+        return true;
+    }
+    if (std::strncmp(arg, "--realtime-priority=", 20) == 0) {
+        options.enabled = true;
+        options.priority = std::atoi(arg + 20);
+        return true;
+    }
+    return false;
+}
+
+std::string describe_realtime(const RealtimeStatus& status) {
+    if (!status.requested) {
+        return std::string();
+    }
+    std::string text;
+    if (status.scheduled) {
+        text = "RT " + std::to_string(status.priority);
+    } else if (status.niced) {
+        text = "nice " + std::to_string(status.priority);
+    } else {
+        text = "normal priority";
+    }
+    if (status.memoryLocked) {
+        text += ", locked";
+    }
+    if (status.pinned) {
+        text += ", pinned";
+    }
+    if (!status.message.empty()) {
+        text += " (" + status.message + ")";
+    }
+    return text;
+}
+
+} // namespace tonegen
@@ -0,0 +1,155 @@
+#include "tonegen/render_thread.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <limits>
+
+namespace tonegen {
+
+namespace {
+
+// Twice the deepest render-ahead, saturating instead of wrapping for absurd depths
+size_t ring_bytes(size_t aheadFrames, size_t maxAheadFrames, size_t frameBytes) {
+    const size_t frames = std::max(maxAheadFrames, aheadFrames);
+    return std::min(frames, std::numeric_limits<size_t>::max() / 2 / frameBytes) * 2 * frameBytes;
+}
+
+} // namespace
+
+RenderThread::RenderThread(ToneGenerator& generator, SampleFormat format, size_t aheadFrames, size_t maxAheadFrames)
+    : m_generator(generator), m_format(format), m_frameBytes(bytes_per_sample(format) * generator.channels()),
+      m_ring(ring_bytes(aheadFrames, maxAheadFrames, m_frameBytes)),
+      m_arena(BufferArena::bytesFor<uint8_t>(MAX_BLOCK_FRAMES * MAX_CHANNELS * sizeof(float))),
+      m_converted(m_arena.allocate<uint8_t>(MAX_BLOCK_FRAMES * MAX_CHANNELS * sizeof(float))), m_aheadFrames(0),
+      m_stop(false), m_restart(false), m_discardUntil(0), m_lowestBytes(0), m_underruns(0), m_allocations(0) {
+    setRenderAhead(aheadFrames);
+    m_lowestBytes.store(m_ring.capacity(), std::memory_order_relaxed);
+}
+
+RenderThread::~RenderThread() {
+    stop();
+}
+
+void RenderThread::start() {
+    if (!running()) {
+        m_stop.store(false, std::memory_order_relaxed);
+        m_thread = std::thread(&RenderThread::run, this);
+    }
+}
+
+void RenderThread::stop() {
+    if (running()) {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stop.store(true, std::memory_order_relaxed);
+        }
+        m_wake.notify_one();
+        m_thread.join();
+    }
+}
+
+void RenderThread::setRenderAhead(size_t frames) {
+    m_aheadFrames.store(std::min(std::max<size_t>(frames, 1), m_ring.capacity() / m_frameBytes / 2),
+                        std::memory_order_relaxed);
+}
+
+void RenderThread::restart() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_restart.store(true, std::memory_order_relaxed);
+    }
+    m_wake.notify_one();
+}
+
+size_t RenderThread::read(void* out, size_t frames) {
+    const size_t discard = m_discardUntil.exchange(0, std::memory_order_acquire);
+    if (discard != 0) {
+        m_ring.discardUntil(discard - 1);
+    }
+
+    const size_t queued = m_ring.size();
+    if (queued < m_lowestBytes.load(std::memory_order_relaxed)) {
+        m_lowestBytes.store(queued, std::memory_order_relaxed);
+    }
+
+    const size_t bytes = frames * m_frameBytes;
+    const size_t copied = m_ring.read(static_cast<uint8_t*>(out), bytes);
+    if (copied < bytes) {
+        std::memset(static_cast<uint8_t*>(out) + copied, m_format == SAMPLE_UINT8 ? 0x80 : 0, bytes - copied);
+        m_underruns.store(m_underruns.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+    return copied / m_frameBytes;
+}
+
+RealtimeStatus RenderThread::realtimeStatus() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_realtimeStatus;
+}
+
+RenderStatus RenderThread::status() {
+    RenderStatus status;
+    status.bufferedFrames = m_ring.size() / m_frameBytes;
+    status.lowestFrames = std::min(m_lowestBytes.exchange(m_ring.capacity(), std::memory_order_relaxed),
+                                   m_ring.size()) / m_frameBytes;
+    status.aheadFrames = renderAhead();
+    status.maxAheadFrames = m_ring.capacity() / m_frameBytes / 2;
+    status.underruns = m_underruns.load(std::memory_order_relaxed);
+    status.allocations = m_allocations.load(std::memory_order_relaxed);
+    return status;
+}
+
+void RenderThread::run() {
+    // Before the first block, so neither the locking nor the page faults land mid-stream
+    const RealtimeStatus realtime = enter_realtime(m_realtimeOptions);
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_realtimeStatus = realtime;
+    }
+
+    while (!m_stop.load(std::memory_order_relaxed)) {
+        if (m_restart.exchange(false, std::memory_order_relaxed)) {
+            m_generator.reset();
+            // Everything written so far is stale; the reader jumps past it at its next read
+            m_discardUntil.store(m_ring.writePosition() + 1, std::memory_order_release);
+        }
+
+        // Top up to the render-ahead depth in whole blocks, never blocking on the reader.
+        // Until the reader has skipped stale audio, only what follows it counts.
+        const size_t ahead = renderAhead();
+        const uint64_t allocations = thread_allocations();
+        for (;;) {
+            size_t queued = m_ring.size();
+            const size_t discard = m_discardUntil.load(std::memory_order_acquire);
+            if (discard != 0) {
+                queued = std::min(queued, m_ring.writePosition() - (discard - 1));
+            }
+            queued /= m_frameBytes;
+            if (queued >= ahead) {
+                break;
+            }
+            // Whole frames that fit, so the ring only ever holds whole frames; when it is full
+            // of audio the reader hasn't taken yet (stale or not), wait instead of spinning
+            const size_t room = m_ring.writable() / m_frameBytes;
+            if (room == 0) {
+                break;
+            }
+            const size_t frames = std::min({ahead - queued, MAX_BLOCK_FRAMES, room});
+            m_generator.process(m_converted, m_format, frames);
+            m_ring.write(m_converted, frames * m_frameBytes);
+        }
+        if (thread_allocations() != allocations) {
+            m_allocations.fetch_add(thread_allocations() - allocations, std::memory_order_relaxed);
+        }
+
+        // Come back once about a quarter of the depth has played
+        const int sampleRate = m_generator.sampleRate();
+        const auto period = std::chrono::microseconds(static_cast<long long>(ahead) * 250000 / sampleRate);
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_wake.wait_for(lock, std::max(period, std::chrono::microseconds(500)), [this] {
+            return m_stop.load(std::memory_order_relaxed) || m_restart.load(std::memory_order_relaxed);
+        });
+    }
+}
+
+} // namespace tonegen
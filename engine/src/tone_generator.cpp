@@ -0,0 +1,344 @@
+#include "tonegen/tone_generator.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "fft.h"
+
+namespace tonegen {
+
+namespace {
+
+size_t smoothing_frames(double seconds, int sampleRate) {
+    return std::max<size_t>(static_cast<size_t>(seconds * sampleRate), 1);
+}
+
+// Changes the oscillators can't follow continuously, so the old sound crossfades instead
+bool switches_voice(const ToneParams& from, const ToneParams& to) {
+    if (from.waveType == ADDITIVE && to.waveType == ADDITIVE) {
+        return false;
+    }
+    return from.waveType != to.waveType || from.pulseWidth != to.pulseWidth || from.noiseSeed != to.noiseSeed ||
+           from.channelPhase != to.channelPhase;
+}
+
+} // namespace
+
+ToneGenerator::ToneGenerator(int sampleRate, size_t channels)
+    : m_sampleRate(sampleRate), m_channels(std::min(std::max<size_t>(channels, 1), MAX_CHANNELS)),
+      m_primary(sampleRate), m_additive(sampleRate), m_modulator(sampleRate), m_filter(sampleRate, m_channels),
+      m_paramsVersion(0), m_filterVersion(0), m_hasPending(false), m_fading(sampleRate), m_fadingAdditive(false),
+      m_fadingGlide(1), m_fadeFrames(0), m_fadeLeft(0), m_glideLog(0), m_glide(1), m_glideFrames(0),
+      m_glideLeft(0), m_bent(false), m_voiceAmplitude(0), m_level(1), m_levelStep(0), m_levelLeft(0),
+      m_arena(2 * BufferArena::bytesFor<float>(MAX_BLOCK_FRAMES * MAX_CHANNELS) +
+              BufferArena::bytesFor<float>(MAX_BLOCK_FRAMES * 2)),
+      m_scratch(m_arena.allocate<float>(MAX_BLOCK_FRAMES * MAX_CHANNELS)),
+      m_fade(m_arena.allocate<float>(MAX_BLOCK_FRAMES * MAX_CHANNELS)),
+      m_mix(m_arena.allocate<float>(MAX_BLOCK_FRAMES * 2)) {
+    setParams(m_params);
+}
+
+void ToneGenerator::setParams(const ToneParams& params) {
+    m_hasPending = false;
+    m_fadeLeft = 0;
+    m_glideLeft = 0;
+    m_glide = 1;
+    m_levelLeft = 0;
+    m_level = 1;
+    configure(params);
+    setVoiceAmplitude(params.amplitude);
+}
+
+void ToneGenerator::configure(const ToneParams& params) {
+    m_params = params;
+
+    // Binaural beats put each tone on its own channels; in mono the two channels are mixed
+    const bool binaural = params.waveType == BINAURAL_BEATS;
+    m_primary.setWaveType(binaural ? SINE : params.waveType);
+    m_primary.setChannels(binaural && m_channels == 1 ? 2 : m_channels);
+    m_primary.setFrequency(params.frequency);
+    const double channelPhase = m_channels > 1 ? params.channelPhase : 0.0;
+    for (size_t c = 0; c < m_primary.channels(); ++c) {
+        m_primary.setChannelOffset(c, binaural && c % 2 == 1 ? params.beatFrequency : 0.0,
+                                   channelPhase * static_cast<double>(c));
+    }
+    m_primary.setSineAccuracy(params.sineAccuracy);
+    m_primary.setPulseWidth(params.pulseWidth);
+    m_primary.setNoiseSeed(params.noiseSeed);
+    // Left alone otherwise, so it keeps its pitch while it fades out
+    if (params.waveType == ADDITIVE) {
+        m_additive.setFrequency(params.frequency);
+    }
+    m_modulator.setParams(params.modulation);
+}
+
+void ToneGenerator::setVoiceAmplitude(float amplitude) {
+    m_voiceAmplitude = amplitude;
+    m_primary.setAmplitude(amplitude);
+    m_fading.setAmplitude(amplitude);
+    m_additive.setAmplitude(amplitude);
+}
+
+void ToneGenerator::setWavetable(const Wavetable& table) {
+    m_primary.setWavetable(table);
+}
+
+void ToneGenerator::setPartials(const Partial* partials, size_t count) {
+    m_additive.setPartials(partials, count);
+}
+
+void ToneGenerator::setFilter(const FilterStage* stages, size_t count) {
+    m_filter.setStages(stages, count);
+}
+
+void ToneGenerator::setFilter(const BiquadCoefficients* sections, size_t count) {
+    m_filter.setSections(sections, count);
+}
+
+void ToneGenerator::publishParams(const ToneParams& params) {
+    m_publishedParams.store(params);
+}
+
+void ToneGenerator::publishFilter(const FilterStage* stages, size_t count) {
+    FilterSections filter = {};
+    filter.count = std::min(count, FILTER_MAX_STAGES);
+    for (size_t s = 0; s < filter.count; ++s) {
+        filter.sections[s] = biquad_coefficients(stages[s], m_sampleRate);
+    }
+    m_publishedFilter.store(filter);
+}
+
+void ToneGenerator::publishFilter(const BiquadCoefficients* sections, size_t count) {
+    FilterSections filter = {};
+    filter.count = std::min(count, FILTER_MAX_STAGES);
+    std::copy(sections, sections + filter.count, filter.sections);
+    m_publishedFilter.store(filter);
+}
+
+void ToneGenerator::poll() {
+    // A read that keeps colliding with the publisher is retried on the next block
+    if (m_publishedParams.version() != m_paramsVersion && m_publishedParams.load(m_pending, &m_paramsVersion)) {
+        m_hasPending = true;
+    }
+    if (m_publishedFilter.version() != m_filterVersion) {
+        FilterSections filter;
+        if (m_publishedFilter.load(filter, &m_filterVersion)) {
+            m_filter.setSections(filter.sections, filter.count);
+        }
+    }
+}
+
+void ToneGenerator::applyPending() {
+    m_hasPending = false;
+    const ToneParams previous = m_params;
+    const ToneParams& next = m_pending;
+
+    if (switches_voice(previous, next)) {
+        m_fadingAdditive = previous.waveType == ADDITIVE;
+        if (!m_fadingAdditive) {
+            m_fading = m_primary;
+            m_fadingGlide = m_glide;
+        }
+        m_fadeFrames = smoothing_frames(SMOOTHING_SECONDS, m_sampleRate);
+        m_fadeLeft = m_fadeFrames;
+        // The new voice starts straight at its own pitch
+        m_glideLeft = 0;
+        m_glide = 1;
+    } else if (next.frequency != previous.frequency && previous.frequency > 0 && next.frequency > 0) {
+        // From the pitch playing now, which may be partway along an earlier glide
+        m_glideLog = std::log(previous.frequency * m_glide / next.frequency);
+        m_glideFrames = smoothing_frames(GLIDE_SECONDS, m_sampleRate);
+        m_glideLeft = m_glideFrames;
+    }
+    configure(next);
+
+    if (next.amplitude != previous.amplitude) {
+        // The voices play at the larger of the two levels while the ramp scales them down
+        const float current = m_voiceAmplitude * m_level;
+        const float peak = std::max(std::fabs(current), std::fabs(next.amplitude));
+        if (peak > 0) {
+            setVoiceAmplitude(peak);
+            m_levelLeft = smoothing_frames(SMOOTHING_SECONDS, m_sampleRate);
+            m_level = current / peak;
+            m_levelStep = (next.amplitude / peak - m_level) / static_cast<float>(m_levelLeft);
+        }
+    }
+}
+
+void ToneGenerator::reset() {
+    poll();
+    setParams(m_hasPending ? m_pending : m_params);
+    m_primary.reset();
+    m_additive.reset();
+    m_modulator.reset();
+    m_filter.reset();
+    m_dither.position = 0;
+}
+
+void ToneGenerator::seek(uint64_t frame) {
+    reset();
+    m_dither.position = static_cast<uint32_t>(frame * m_channels);
+    while (frame > 0) {
+        size_t chunk = static_cast<size_t>(std::min<uint64_t>(frame, SIZE_MAX / 2));
+        // Follows the pitch as process() does, so the phases land in the same place
+        if (m_modulator.modulatesPitch()) {
+            chunk = std::min(chunk, m_modulator.segmentFrames());
+            m_primary.setPitchRatio(m_modulator.pitchRatio());
+        }
+        if (m_params.waveType == ADDITIVE) {
+            m_additive.skip(chunk);
+        } else {
+            m_primary.skip(chunk);
+        }
+        m_modulator.advance(chunk);
+        frame -= chunk;
+    }
+    m_primary.setPitchRatio(1);
+    m_bent = false;
+}
+
+void ToneGenerator::noteOff() {
+    m_modulator.noteOff();
+}
+
+void ToneGenerator::process(float* out, size_t frames) {
+    poll();
+    float* start = out;
+    for (size_t left = frames; left > 0;) {
+        if (m_hasPending && m_fadeLeft == 0) {
+            applyPending();
+        }
+
+        size_t chunk = left;
+        // The oscillators follow the pitch one control segment at a time
+        if (m_modulator.modulatesPitch() || m_glideLeft > 0 || m_bent) {
+            chunk = std::min(chunk, m_modulator.segmentFrames());
+            if (m_glideLeft > 0) {
+                m_glide = std::exp(m_glideLog * static_cast<double>(m_glideLeft) / static_cast<double>(m_glideFrames));
+            }
+            const double ratio = m_modulator.pitchRatio();
+            m_primary.setPitchRatio(ratio * m_glide);
+            if (m_fadeLeft > 0 && !m_fadingAdditive) {
+                m_fading.setPitchRatio(ratio * m_fadingGlide);
+            }
+            m_bent = ratio * m_glide != 1;
+        }
+        // Stop at the ends of the fade and the ramp, where pending values and the final level apply
+        if (m_fadeLeft > 0) {
+            chunk = std::min(chunk, std::min(m_fadeLeft, MAX_BLOCK_FRAMES));
+        }
+        if (m_levelLeft > 0) {
+            chunk = std::min(chunk, m_levelLeft);
+        }
+
+        render(out, chunk);
+        if (m_fadeLeft > 0) {
+            crossfade(out, chunk);
+        }
+        m_modulator.process(out, chunk, m_channels);
+        if (m_levelLeft > 0) {
+            ramp(out, chunk);
+        }
+        m_glideLeft -= std::min(m_glideLeft, chunk);
+        if (m_glideLeft == 0) {
+            m_glide = 1;
+        }
+        out += chunk * m_channels;
+        left -= chunk;
+    }
+    m_filter.process(start, frames);
+}
+
+void ToneGenerator::render(float* out, size_t frames) {
+    if (m_params.waveType == ADDITIVE) {
+        renderAdditive(out, frames);
+    } else {
+        renderOscillator(m_primary, out, frames);
+    }
+}
+
+void ToneGenerator::renderOscillator(Oscillator& osc, float* out, size_t frames) {
+    if (osc.channels() == m_channels) {
+        osc.process(out, frames);
+        return;
+    }
+
+    // Mono can only mix the two tones, which beats monaurally
+    while (frames > 0) {
+        const size_t chunk = std::min(frames, MAX_BLOCK_FRAMES);
+        osc.process(m_mix, chunk);
+        for (size_t i = 0; i < chunk; ++i) {
+            out[i] = (m_mix[2 * i] + m_mix[2 * i + 1]) / 2;
+        }
+        out += chunk;
+        frames -= chunk;
+    }
+}
+
+void ToneGenerator::renderAdditive(float* out, size_t frames) {
+    if (m_channels == 1) {
+        m_additive.process(out, frames);
+        return;
+    }
+    while (frames > 0) {
+        const size_t chunk = std::min(frames, MAX_BLOCK_FRAMES);
+        m_additive.process(m_mix, chunk);
+        for (size_t i = 0; i < chunk; ++i) {
+            std::fill_n(out + i * m_channels, m_channels, m_mix[i]);
+        }
+        out += chunk * m_channels;
+        frames -= chunk;
+    }
+}
+
+void ToneGenerator::crossfade(float* out, size_t frames) {
+    if (m_fadingAdditive) {
+        renderAdditive(m_fade, frames);
+    } else {
+        renderOscillator(m_fading, m_fade, frames);
+    }
+    // Raised cosine from the old voice to the new, reaching the new one on the last frame
+    const size_t done = m_fadeFrames - m_fadeLeft;
+    const double scale = detail::PI / static_cast<double>(m_fadeFrames);
+    for (size_t i = 0; i < frames; ++i) {
+        const float gain = static_cast<float>(0.5 - 0.5 * std::cos(scale * static_cast<double>(done + i + 1)));
+        for (size_t c = 0; c < m_channels; ++c) {
+            const size_t k = i * m_channels + c;
+            out[k] = m_fade[k] + gain * (out[k] - m_fade[k]);
+        }
+    }
+    m_fadeLeft -= frames;
+}
+
+void ToneGenerator::ramp(float* out, size_t frames) {
+    for (size_t i = 0; i < frames; ++i) {
+        m_level += m_levelStep;
+        for (size_t c = 0; c < m_channels; ++c) {
+            out[i * m_channels + c] *= m_level;
+        }
+    }
+    m_levelLeft -= frames;
+    if (m_levelLeft == 0) {
+        // Hand the final level back to the oscillators
+        setVoiceAmplitude(m_params.amplitude);
+        m_level = 1;
+    }
+}
+
+void ToneGenerator::process(int16_t* out, size_t frames) {
+    process(out, SAMPLE_INT16, frames);
+}
+
+void ToneGenerator::process(void* out, SampleFormat format, size_t frames) {
+    unsigned char* dst = static_cast<unsigned char*>(out);
+    const size_t frameBytes = bytes_per_sample(format) * m_channels;
+    while (frames > 0) {
+        const size_t chunk = std::min(frames, MAX_BLOCK_FRAMES);
+        process(m_scratch, chunk);
+        convert_samples(m_scratch, dst, format, chunk * m_channels, &m_dither);
+        dst += chunk * frameBytes;
+        frames -= chunk;
+    }
+}
+
+} // namespace tonegen
@@ -0,0 +1,173 @@
+#include "tonegen/wavetable.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <utility>
+
+#include "fft.h"
+
+namespace tonegen {
+
+namespace {
+
+using detail::Complex;
+using detail::PI;
+
+constexpr size_t level_harmonics(size_t level) {
+    // The Nyquist bin of the table itself can't hold a sine
+    return std::min((WAVETABLE_SIZE / 2) >> level, WAVETABLE_SIZE / 2 - 1);
+}
+
+// Fourier series of the shapes the BLEP oscillators draw: square high for the first half
+// turn, saw rising from -1 to 1
+constexpr double square_harmonic(size_t h) { return (h & 1) ? 4 / (PI * static_cast<double>(h)) : 0; }
+constexpr double saw_harmonic(size_t h) { return -2 / (PI * static_cast<double>(h)); }
+
+struct BuiltinLevel {
+    float square[WAVETABLE_SIZE + 1];
+    float saw[WAVETABLE_SIZE + 1];
+    float squarePeak;
+    float sawPeak;
+};
+
+constexpr float peak_of(const float* samples) {
+    float peak = 0;
+    for (size_t i = 0; i < WAVETABLE_SIZE; ++i) {
+        peak = std::max(peak, samples[i] < 0 ? -samples[i] : samples[i]);
+    }
+    return peak;
+}
+
+constexpr BuiltinLevel make_builtin_level(size_t level) {
+    // Both spectra are real signals, so one inverse FFT renders square into the real part
+    // and saw into the imaginary part
+    Complex spectrum[WAVETABLE_SIZE] = {};
+    for (size_t h = 1; h <= level_harmonics(level); ++h) {
+        const double a = square_harmonic(h);
+        const double b = saw_harmonic(h);
+        spectrum[h] = {b / 2, -a / 2};
+        spectrum[WAVETABLE_SIZE - h] = {-b / 2, a / 2};
+    }
+    detail::fft(spectrum, WAVETABLE_SIZE, true);
+
+    BuiltinLevel out{};
+    for (size_t i = 0; i < WAVETABLE_SIZE; ++i) {
+        out.square[i] = static_cast<float>(spectrum[i].re);
+        out.saw[i] = static_cast<float>(spectrum[i].im);
+    }
+    out.square[WAVETABLE_SIZE] = out.square[0];
+    out.saw[WAVETABLE_SIZE] = out.saw[0];
+    out.squarePeak = peak_of(out.square);
+    out.sawPeak = peak_of(out.saw);
+    return out;
+}
+
+struct BuiltinSine {
+    float samples[WAVETABLE_SIZE + 1];
+};
+
+constexpr BuiltinSine make_builtin_sine() {
+    BuiltinSine out{};
+    for (size_t i = 0; i < WAVETABLE_SIZE; ++i) {
+        out.samples[i] = static_cast<float>(detail::const_sin(2 * PI * static_cast<double>(i) / WAVETABLE_SIZE));
+    }
+    out.samples[WAVETABLE_SIZE] = out.samples[0];
+    return out;
+}
+
+// One constant per level keeps every evaluation to a single FFT, well inside the default
+// constexpr step limits of GCC and Clang
+template <size_t Level>
+constexpr BuiltinLevel BUILTIN_LEVEL = make_builtin_level(Level);
+
+constexpr BuiltinSine BUILTIN_SINE = make_builtin_sine();
+
+template <size_t... Levels>
+constexpr std::array<const BuiltinLevel*, WAVETABLE_LEVELS> builtin_levels(std::index_sequence<Levels...>) {
+    return {{&BUILTIN_LEVEL<Levels>...}};
+}
+
+constexpr std::array<const BuiltinLevel*, WAVETABLE_LEVELS> BUILTIN_LEVELS =
+    builtin_levels(std::make_index_sequence<WAVETABLE_LEVELS>());
+
+} // namespace
+
+Wavetable::Wavetable() : m_gain(1.0f) {
+    std::fill(m_levels, m_levels + WAVETABLE_LEVELS, BUILTIN_SINE.samples);
+}
+
+Wavetable Wavetable::builtin(WavetableShape shape) {
+    Wavetable table;
+    if (shape != WAVETABLE_SQUARE && shape != WAVETABLE_SAW) {
+        return table;
+    }
+    // Gibbs overshoot is ~9%; one gain for the whole chain keeps every level at or below
+    // full scale without loudness steps between octaves
+    float peak = 0;
+    for (size_t k = 0; k < WAVETABLE_LEVELS; ++k) {
+        const BuiltinLevel& level = *BUILTIN_LEVELS[k];
+        table.m_levels[k] = shape == WAVETABLE_SQUARE ? level.square : level.saw;
+        peak = std::max(peak, shape == WAVETABLE_SQUARE ? level.squarePeak : level.sawPeak);
+    }
+    table.m_gain = 1.0f / peak;
+    return table;
+}
+
+Wavetable Wavetable::fromSingleCycle(const float* samples, size_t count) {
+    Wavetable table;
+    if (samples == nullptr || count == 0) {
+        return table;
+    }
+
+    std::vector<Complex> spectrum(WAVETABLE_SIZE);
+    for (size_t i = 0; i < WAVETABLE_SIZE; ++i) {
+        const double position = static_cast<double>(i) * static_cast<double>(count) / WAVETABLE_SIZE;
+        const size_t index = static_cast<size_t>(position);
+        const double frac = position - static_cast<double>(index);
+        const double a = samples[index];
+        const double b = samples[(index + 1) % count];
+        spectrum[i] = {a + (b - a) * frac, 0};
+    }
+    detail::fft(spectrum.data(), WAVETABLE_SIZE, false);
+
+    auto storage = std::make_shared<std::vector<float>>(WAVETABLE_LEVELS * (WAVETABLE_SIZE + 1));
+    std::vector<Complex> level(WAVETABLE_SIZE);
+    float peak = 0;
+    for (size_t k = 0; k < WAVETABLE_LEVELS; ++k) {
+        std::fill(level.begin(), level.end(), Complex{0, 0});
+        for (size_t h = 1; h <= level_harmonics(k); ++h) {
+            level[h] = spectrum[h];
+            level[WAVETABLE_SIZE - h] = spectrum[WAVETABLE_SIZE - h];
+        }
+        detail::fft(level.data(), WAVETABLE_SIZE, true);
+
+        float* out = storage->data() + k * (WAVETABLE_SIZE + 1);
+        for (size_t i = 0; i < WAVETABLE_SIZE; ++i) {
+            out[i] = static_cast<float>(level[i].re / WAVETABLE_SIZE);
+            peak = std::max(peak, std::fabs(out[i]));
+        }
+        out[WAVETABLE_SIZE] = out[0];
+    }
+    if (peak > 0) {
+        table.m_gain = 1.0f / peak;
+    }
+
+    for (size_t k = 0; k < WAVETABLE_LEVELS; ++k) {
+        table.m_levels[k] = storage->data() + k * (WAVETABLE_SIZE + 1);
+    }
+    table.m_storage = std::move(storage);
+    return table;
+}
+
+size_t Wavetable::levelFor(uint32_t increment) {
+    // Level k tops out at 2^(WAVETABLE_BITS - 1 - k) harmonics, which stay below half a
+    // turn per sample while increment <= 2^(32 - WAVETABLE_BITS + k)
+    size_t k = 0;
+    while (k + 1 < WAVETABLE_LEVELS && increment > (uint64_t(1) << (32 - WAVETABLE_BITS + k))) {
+        ++k;
+    }
+    return k;
+}
+
+} // namespace tonegen
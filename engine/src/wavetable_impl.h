@@ -0,0 +1,38 @@
+#pragma once
+
+// Interpolated wavetable lookup shared by every ISA translation unit, written against the
+// lane types in lanes.h. Lanes gather their table entries one by one; the index and
+// interpolation maths around them is what vectorizes.
+
+#include "lanes.h"
+#include "tonegen/wavetable.h"
+
+namespace tonegen {
+namespace detail {
+
+template <typename L>
+TONEGEN_INLINE typename L::F wavetable_sample(typename L::U phase, const float* table) {
+    const typename L::U index = phase >> (32 - WAVETABLE_BITS);
+    const typename L::F frac = L::turns(phase << WAVETABLE_BITS);
+    const typename L::F a = L::gather(table, index);
+    const typename L::F b = L::gather(table + 1, index);
+    return a + (b - a) * frac;
+}
+
+template <typename L>
+TONEGEN_INLINE void wavetable_block(float* out, size_t frames, const WavetableArgs& args) {
+    typename L::U phase = L::phases(args.phase, args.increment);
+    const uint32_t stride = static_cast<uint32_t>(L::LANES) * args.increment;
+    size_t i = 0;
+    for (; i + L::LANES <= frames; i += L::LANES) {
+        L::store(out + i, args.amplitude * wavetable_sample<L>(phase, args.table));
+        phase += stride;
+    }
+    uint32_t tail = args.phase + static_cast<uint32_t>(i) * args.increment;
+    for (; i < frames; ++i, tail += args.increment) {
+        out[i] = args.amplitude * wavetable_sample<ScalarLanes>(tail, args.table);
+    }
+}
+
+} // namespace detail
+} // namespace tonegen
@@ -0,0 +1,61 @@
+# qmake include for the shared tone engine, the counterpart of engine/CMakeLists.txt
+
+INCLUDEPATH += $$PWD/include
+
+# DEFINES += TONEGEN_COUNT_ALLOCATIONS counts heap allocations on the render paths, as in CMake
+
+HEADERS += \
+    $$PWD/include/tonegen/additive.h \
+    $$PWD/include/tonegen/allocation.h \
+    $$PWD/include/tonegen/blep.h \
+    $$PWD/include/tonegen/convert.h \
+    $$PWD/include/tonegen/cpu.h \
+    $$PWD/include/tonegen/file_sink.h \
+    $$PWD/include/tonegen/filter.h \
+    $$PWD/include/tonegen/loop_cache.h \
+    $$PWD/include/tonegen/modulation.h \
+    $$PWD/include/tonegen/noise.h \
+    $$PWD/include/tonegen/offline_render.h \
+    $$PWD/include/tonegen/oscillator.h \
+    $$PWD/include/tonegen/phase.h \
+    $$PWD/include/tonegen/realtime.h \
+    $$PWD/include/tonegen/render_thread.h \
+    $$PWD/include/tonegen/ring_buffer.h \
+    $$PWD/include/tonegen/seqlock.h \
+    $$PWD/include/tonegen/sine.h \
+    $$PWD/include/tonegen/tone_generator.h \
+    $$PWD/include/tonegen/types.h \
+    $$PWD/include/tonegen/wavetable.h \
+    $$PWD/src/additive_impl.h \
+    $$PWD/src/biquad_impl.h \
+    $$PWD/src/blep_impl.h \
+    $$PWD/src/convert_impl.h \
+    $$PWD/src/fft.h \
+    $$PWD/src/gain_impl.h \
+    $$PWD/src/interleave_impl.h \
+    $$PWD/src/kernels.h \
+    $$PWD/src/lanes.h \
+    $$PWD/src/noise_impl.h \
+    $$PWD/src/wavetable_impl.h
+
+SOURCES += \
+    $$PWD/src/additive.cpp \
+    $$PWD/src/allocation.cpp \
+    $$PWD/src/convert.cpp \
+    $$PWD/src/cpu_dispatch.cpp \
+    $$PWD/src/file_sink.cpp \
+    $$PWD/src/filter.cpp \
+    $$PWD/src/kernels_avx2.cpp \
+    $$PWD/src/kernels_avx512.cpp \
+    $$PWD/src/kernels_neon.cpp \
+    $$PWD/src/kernels_scalar.cpp \
+    $$PWD/src/kernels_sse2.cpp \
+    $$PWD/src/loop_cache.cpp \
+    $$PWD/src/modulation.cpp \
+    $$PWD/src/noise.cpp \
+    $$PWD/src/offline_render.cpp \
+    $$PWD/src/oscillator.cpp \
+    $$PWD/src/realtime.cpp \
+    $$PWD/src/render_thread.cpp \
+    $$PWD/src/tone_generator.cpp \
+    $$PWD/src/wavetable.cpp
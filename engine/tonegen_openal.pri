@@ -0,0 +1,12 @@
+# qmake include for the OpenAL streaming and loopback helpers, the counterpart of
+# tonegen_openal in engine/CMakeLists.txt; include tonegen.pri as well
+
+HEADERS += \
+    $$PWD/include/tonegen/openal_loopback.h \
+    $$PWD/include/tonegen/openal_stream.h
+
+SOURCES += \
+    $$PWD/src/openal_loopback.cpp \
+    $$PWD/src/openal_stream.cpp
+
+LIBS += -lopenal
@@ -0,0 +1,216 @@
+#include <iostream>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "tonegen/file_sink.h"
+#include "tonegen/loop_cache.h"
+#include "tonegen/openal_loopback.h"
+#include "tonegen/openal_stream.h"
+
+// Plays a tone through OpenAlStream into an OpenAL Soft loopback device and pulls the mix
+// back as fast as the CPU allows, so the whole OpenAL path runs on machines with no sound card.
+//   tone_loopback key=value ...
+// Keys: path=queue|callback|loop (how OpenAlStream feeds the source), wave=sine|square|saw|
+// triangle|binaural|white|pink, freq, beat, seconds, rate, channels, format=u8|s16|s32|f32 (the
+// device mix), buffer (frames per OpenAlStream buffer), buffers, period (frames mixed per
+// render), out=FILE to keep the mix (.wav, .rf64, .w64 or .raw)
+// On the queue path the buffers are refilled between renders, as the streaming thread would
+// after each device period; underruns mean the queue is shorter than one period. Exits non-zero
+// on underruns or a silent mix, so a CI job can run it as a check.
+
+enum Path { PATH_QUEUE, PATH_CALLBACK, PATH_LOOP, PATH_COUNT };
+
+struct Settings {
+    Path path = PATH_QUEUE;
+    tonegen::ToneParams params;
+    double seconds = 60;
+    int rate = 48000;
+    size_t channels = 2;
+    tonegen::SampleFormat format = tonegen::SAMPLE_FLOAT;
+    size_t bufferFrames = 1024;
+    size_t buffers = 4;
+    size_t periodFrames = 512;
+    std::string out;
+};
+
+template <typename T, size_t N>
+bool parse_name(const std::string& value, const char* const (&names)[N], T& result) {
+    for (size_t i = 0; i < N; ++i) {
+        if (value == names[i]) {
+            result = static_cast<T>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool parse_setting(const std::string& setting, Settings& settings) {
+    static const char* const PATHS[PATH_COUNT] = {"queue", "callback", "loop"};
+    static const char* const FORMATS[tonegen::SAMPLE_FORMAT_COUNT] = {"u8", "s16", "s32", "f32"};
+    static const struct {
+        const char* name;
+        tonegen::WaveType wave;
+    } WAVES[] = {{"sine", tonegen::SINE},         {"square", tonegen::SQUARE}, {"saw", tonegen::SAW},
+                 {"triangle", tonegen::TRIANGLE}, {"binaural", tonegen::BINAURAL_BEATS},
+                 {"white", tonegen::WHITE_NOISE}, {"pink", tonegen::PINK_NOISE}};
+
+    const size_t equals = setting.find('=');
+    if (equals == std::string::npos) {
+        return false;
+    }
+    const std::string key = setting.substr(0, equals);
+    const std::string value = setting.substr(equals + 1);
+    const double number = std::atof(value.c_str());
+    if (key == "path") {
+        return parse_name(value, PATHS, settings.path);
+    } else if (key == "format") {
+        return parse_name(value, FORMATS, settings.format);
+    } else if (key == "wave") {
+        for (const auto& entry : WAVES) {
+            if (value == entry.name) {
+                settings.params.waveType = entry.wave;
+                return true;
+            }
+        }
+        return false;
+    } else if (key == "freq") {
+        settings.params.frequency = number;
+    } else if (key == "beat") {
+        settings.params.beatFrequency = number;
+    } else if (key == "seconds") {
+        settings.seconds = number;
+    } else if (key == "rate") {
+        settings.rate = std::atoi(value.c_str());
+    } else if (key == "channels") {
+        settings.channels = static_cast<size_t>(std::max(std::atoi(value.c_str()), 1));
+    } else if (key == "buffer") {
+        settings.bufferFrames = static_cast<size_t>(std::max(std::atoi(value.c_str()), 1));
+    } else if (key == "buffers") {
+        settings.buffers = static_cast<size_t>(std::max(std::atoi(value.c_str()), 2));
+    } else if (key == "period") {
+        settings.periodFrames = static_cast<size_t>(std::max(std::atoi(value.c_str()), 1));
+    } else if (key == "out") {
+        settings.out = value;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+// Loudest sample of the mix, in full scale
+double peak_level(const uint8_t* data, tonegen::SampleFormat format, size_t samples) {
+    double peak = 0;
+    for (size_t i = 0; i < samples; ++i) {
+        double value = 0;
+        switch (format) {
+            case tonegen::SAMPLE_UINT8:
+                value = (data[i] - 128.0) / 128.0;
+                break;
+            case tonegen::SAMPLE_INT16:
+                value = reinterpret_cast<const int16_t*>(data)[i] / 32768.0;
+                break;
+            case tonegen::SAMPLE_INT32:
+                value = reinterpret_cast<const int32_t*>(data)[i] / 2147483648.0;
+                break;
+            default:
+                value = reinterpret_cast<const float*>(data)[i];
+                break;
+        }
+        peak = std::max(peak, std::fabs(value));
+    }
+    return peak;
+}
+
+int main(int argc, char* argv[]) {
+    Settings settings;
+    settings.params.frequency = 440;
+    settings.params.amplitude = 0.5f;
+    for (int i = 1; i < argc; ++i) {
+        if (!parse_setting(argv[i], settings)) {
+            std::cerr << "Bad setting: " << argv[i] << std::endl;
+            return 1;
+        }
+    }
+
+    tonegen::OpenAlLoopback loopback;
+    if (!loopback.open(settings.rate, settings.channels, settings.format)) {
+        std::cerr << loopback.error() << std::endl;
+        return 1;
+    }
+
+    tonegen::ToneGenerator generator(settings.rate, settings.channels);
+    generator.setParams(settings.params);
+    generator.reset();
+    // Declared after the loopback device, so it is gone before the device's context goes
+    tonegen::OpenAlStream stream(generator, settings.bufferFrames, settings.buffers);
+    stream.setManualRefill(true);
+    stream.setUseCallback(settings.path == PATH_CALLBACK);
+
+    bool started = false;
+    if (settings.path == PATH_LOOP) {
+        tonegen::LoopCache loops(settings.rate, generator.channels(), stream.sampleFormat());
+        std::shared_ptr<const tonegen::ToneLoop> loop = loops.find(settings.params);
+        if (!loop) {
+            std::cerr << "That tone has no exact loop to play" << std::endl;
+            return 1;
+        }
+        started = stream.startLoop(*loop);
+    } else {
+        started = stream.start();
+    }
+    if (!started) {
+        std::cerr << "OpenAL has no buffer format for " << generator.channels() << " channels" << std::endl;
+        return 1;
+    }
+    if (settings.path == PATH_CALLBACK && !stream.usesCallback()) {
+        std::cerr << "No AL_SOFT_callback_buffer; playing from the buffer queue instead" << std::endl;
+    }
+
+    tonegen::FileSink sink;
+    if (!settings.out.empty() && !sink.open(settings.out, tonegen::file_type_for(settings.out), settings.rate,
+                                            settings.channels, settings.format)) {
+        std::cerr << sink.error() << std::endl;
+        return 1;
+    }
+
+    const uint64_t total = static_cast<uint64_t>(std::llround(settings.seconds * settings.rate));
+    const Path used = stream.usesCallback() ? PATH_CALLBACK : stream.looping() ? PATH_LOOP : PATH_QUEUE;
+    std::vector<uint8_t> mix(settings.periodFrames * loopback.frameBytes());
+    double peak = 0;
+    const auto start = std::chrono::steady_clock::now();
+    for (uint64_t done = 0; done < total;) {
+        const size_t frames = static_cast<size_t>(std::min<uint64_t>(settings.periodFrames, total - done));
+        if (used == PATH_QUEUE) {
+            stream.refill();
+        }
+        loopback.render(mix.data(), frames);
+        peak = std::max(peak, peak_level(mix.data(), settings.format, frames * settings.channels));
+        if (sink.isOpen()) {
+            sink.write(mix.data(), frames);
+        }
+        done += frames;
+    }
+    const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    stream.stop();
+    if (sink.isOpen() && !sink.close()) {
+        std::cerr << sink.error() << std::endl;
+        return 1;
+    }
+
+    const char* PATH_NAMES[PATH_COUNT] = {"buffer queue", "mixer callback", "looping buffer"};
+    std::printf("%s: %.1f s mixed in %.3f s (%.0fx real time, %.0f ns per frame), %llu renders of %zu frames, "
+                "%llu underruns, peak %.3f\n",
+                PATH_NAMES[used],
+                static_cast<double>(loopback.frames()) / settings.rate, elapsed,
+                elapsed > 0 ? static_cast<double>(loopback.frames()) / settings.rate / elapsed : 0.0,
+                1e9 * elapsed / static_cast<double>(std::max<uint64_t>(loopback.frames(), 1)),
+                static_cast<unsigned long long>((total + settings.periodFrames - 1) / settings.periodFrames),
+                settings.periodFrames, static_cast<unsigned long long>(stream.underruns()), peak);
+    return stream.underruns() == 0 && peak > 0 ? 0 : 1;
+}
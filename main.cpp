@@ -1,39 +1,88 @@
 #include <iostream>
 #include <cmath>
+#include <cstdlib>
+#include <string>
+#include <vector>
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_mixer.h>
 
+#include "tonegen/render_thread.h"
+
 const int SAMPLE_RATE = 44100;
 const int FREQUENCY = 440;
-const int AMPLITUDE = 32760;
-const int BUFFER_SIZE = 4096; // Larger buffer size for smoother playback
-
-enum WaveType { SINE, SQUARE };
+const int BUFFER_SIZE = 4096; // Larger buffer size for smoother playback; the second argument overrides it
+const int RENDER_AHEAD_MS = 200; // How far the producer thread renders ahead; the first argument overrides it
+const int MAX_RENDER_AHEAD_MS = 2000;
+const int MAX_BUFFER_FRAMES = 65535; // SDL_AudioSpec::samples is a Uint16
 
-int phase = 0;
-WaveType currentWave = SINE;
+// Touched by the main thread only; the audio thread sees nothing but the ring
 bool playing = false;
+bool realtimeReported = false;
+tonegen::ToneParams params;
 
-void generate_wave(int16_t* buffer, int length, int frequency, WaveType waveType, int& phase) {
-    for (int i = 0; i < length; ++i) {
-        float time = static_cast<float>(phase + i) / SAMPLE_RATE;
-        if (waveType == SINE) {
-            buffer[i] = static_cast<int16_t>(AMPLITUDE * std::sin(2.0f * M_PI * frequency * time));
-        } else if (waveType == SQUARE) {
-            float period = static_cast<float>(SAMPLE_RATE) / frequency;
-            buffer[i] = ((phase + i) % static_cast<int>(period) < (period / 2)) ? AMPLITUDE : -AMPLITUDE;
-        }
+void audio_callback(void* userdata, Uint8* stream, int len) {
+    // Synthesis runs on the producer thread, so this only copies out what it rendered
+    tonegen::RenderThread* render = static_cast<tonegen::RenderThread*>(userdata);
+    render->read(stream, len / render->frameBytes());
+}
+
+// A whole number in [low, high] and nothing else
+bool parse_count(const char* text, long low, long high, int& value) {
+    char* end = nullptr;
+    const long parsed = std::strtol(text, &end, 10);
+    if (end == text || *end != '\0' || parsed < low || parsed > high) {
+        return false;
     }
-    phase += length;
+    value = static_cast<int>(parsed);
+    return true;
 }
 
-void audio_callback(void* userdata, Uint8* stream, int len) {
-    int16_t* buffer = reinterpret_cast<int16_t*>(stream);
-    int length = len / 2; // len is in bytes, we need the number of samples
-    generate_wave(buffer, length, FREQUENCY, currentWave, phase);
+void set_wave(tonegen::ToneGenerator& generator, tonegen::WaveType waveType) {
+    params.waveType = waveType;
+    params.frequency = FREQUENCY;
+    generator.publishParams(params);
+}
+
+void show_status(SDL_Window* window, tonegen::RenderThread& render, int deviceFrames) {
+    // A change published now is heard once the ring and the device buffer have played out
+    const tonegen::RenderStatus status = render.status();
+    const std::string title = "Tone Generator - latency " +
+                              std::to_string((status.bufferedFrames + deviceFrames) * 1000 / SAMPLE_RATE) +
+                              " ms, buffered " + std::to_string(status.bufferedFrames * 1000 / SAMPLE_RATE) +
+                              " ms (low " + std::to_string(status.lowestFrames * 1000 / SAMPLE_RATE) + " ms), " +
+                              std::to_string(status.underruns) + " underruns";
+    const tonegen::RealtimeStatus realtime = render.realtimeStatus();
+    const std::string realtimeText = tonegen::describe_realtime(realtime);
+    SDL_SetWindowTitle(window, (realtimeText.empty() ? title : title + " - " + realtimeText).c_str());
+
+    // Say once on the console if the real-time request was cut short
+    if (realtime.requested && !realtimeReported) {
+        if (!realtime.message.empty()) {
+            std::cerr << "Real-time setup incomplete: " << realtime.message << std::endl;
+        }
+        realtimeReported = true;
+    }
 }
 
 int main(int argc, char* argv[]) {
+    // Arguments are the render-ahead in ms and the device buffer in frames, plus --realtime[=CPU]
+    // for a SCHED_FIFO producer. Low latency is a few ms over 64-256 frames, e.g. "5 128 --realtime".
+    tonegen::RealtimeOptions realtime;
+    std::vector<const char*> args;
+    for (int i = 1; i < argc; ++i) {
+        if (!tonegen::parse_realtime_option(argv[i], realtime)) {
+            args.push_back(argv[i]);
+        }
+    }
+    int aheadMs = RENDER_AHEAD_MS;
+    int bufferFrames = BUFFER_SIZE;
+    if (args.size() > 2 || (args.size() > 0 && !parse_count(args[0], 1, MAX_RENDER_AHEAD_MS, aheadMs)) ||
+        (args.size() > 1 && !parse_count(args[1], 1, MAX_BUFFER_FRAMES, bufferFrames))) {
+        std::cerr << "Usage: " << argv[0] << " [AHEAD_MS 1-" << MAX_RENDER_AHEAD_MS << "] [BUFFER_FRAMES 1-"
+                  << MAX_BUFFER_FRAMES << "] [--realtime[=CPU]]" << std::endl;
+        return 1;
+    }
+
     // Initialize SDL
     if (SDL_Init(SDL_INIT_AUDIO | SDL_INIT_VIDEO) < 0) {
         std::cerr << "Failed to initialize SDL: " << SDL_GetError() << std::endl;
@@ -49,7 +98,7 @@ int main(int argc, char* argv[]) {
     }
 
     // Initialize SDL_mixer
-    if (Mix_OpenAudio(SAMPLE_RATE, AUDIO_S16SYS, 1, BUFFER_SIZE) < 0) {
+    if (Mix_OpenAudio(SAMPLE_RATE, AUDIO_S16SYS, 1, bufferFrames) < 0) {
         std::cerr << "Failed to open audio: " << Mix_GetError() << std::endl;
         SDL_DestroyWindow(window);
         SDL_Quit();
@@ -59,14 +108,23 @@ int main(int argc, char* argv[]) {
     Mix_AllocateChannels(1);
     Mix_ChannelFinished(nullptr);
 
-    // Register the audio callback
+    // The producer thread owns the generator from here on; the callback reads its ring
+    tonegen::ToneGenerator generator(SAMPLE_RATE);
+    params.frequency = FREQUENCY;
+    generator.setParams(params);
+    tonegen::RenderThread render(generator, tonegen::SAMPLE_INT16, aheadMs * SAMPLE_RATE / 1000,
+                                 MAX_RENDER_AHEAD_MS * SAMPLE_RATE / 1000);
+    render.setRealtime(realtime);
+    render.start();
+
     SDL_AudioSpec desiredSpec;
     SDL_zero(desiredSpec);
     desiredSpec.freq = SAMPLE_RATE;
     desiredSpec.format = AUDIO_S16SYS;
     desiredSpec.channels = 1;
-    desiredSpec.samples = BUFFER_SIZE;
+    desiredSpec.samples = static_cast<Uint16>(bufferFrames);
     desiredSpec.callback = audio_callback;
+    desiredSpec.userdata = &render;
 
     if (SDL_OpenAudio(&desiredSpec, nullptr) < 0) {
         std::cerr << "Failed to open audio: " << SDL_GetError() << std::endl;
@@ -80,6 +138,7 @@ int main(int argc, char* argv[]) {
 SDL_PauseAudio(1);
     bool quit = false;
     SDL_Event e;
+    Uint32 lastStatus = 0;
 
     while (!quit) {
         while (SDL_PollEvent(&e) != 0) {
@@ -88,14 +147,14 @@ SDL_PauseAudio(1);
             } else if (e.type == SDL_KEYDOWN) {
                 switch (e.key.keysym.sym) {
                     case SDLK_s:
-                        currentWave = SINE;
+                        set_wave(generator, tonegen::SINE);
                         if (!playing) {
                             SDL_PauseAudio(0);
                             playing = true;
                         }
                         break;
                     case SDLK_q:
-                        currentWave = SQUARE;
+                        set_wave(generator, tonegen::SQUARE);
                         if (!playing) {
                             SDL_PauseAudio(0);
                             playing = true;
@@ -106,7 +165,7 @@ SDL_PauseAudio(1);
                             SDL_PauseAudio(1);
                             playing = false;
                         } else {
-                            phase = 0; // Reset phase when starting playback
+                            render.restart(); // Reset phase when starting playback
                             SDL_PauseAudio(0);
                             playing = true;
                         }
@@ -115,11 +174,17 @@ SDL_PauseAudio(1);
             }
         }
 
+        if (SDL_GetTicks() - lastStatus >= 500) {
+            show_status(window, render, desiredSpec.samples); // SDL_OpenAudio filled in the size it got
+            lastStatus = SDL_GetTicks();
+        }
+
         SDL_Delay(1); // Prevent high CPU usage
     }
 
     // Cleanup
     SDL_PauseAudio(1);
+    render.stop();
     Mix_CloseAudio();
     SDL_DestroyWindow(window);
     SDL_Quit();
@@ -1,72 +1,49 @@
 #include <iostream>
 #include <cmath>
+#include <memory>
+#include <string>
 #include <vector>
-#include <thread>
-#include <atomic>
 #include <AL/al.h>
 #include <AL/alc.h>
 #include <SDL2/SDL.h>
 
+#include "tonegen/openal_stream.h"
+
 const int SAMPLE_RATE = 44100;
 const int FREQUENCY = 9800;
-const int AMPLITUDE = 32760;
 const int BUFFER_SIZE = SAMPLE_RATE / 2; // Larger buffer size for smoother playback
 const int NUM_BUFFERS = 8; // Increase the number of buffers for more continuous playback
 
-enum WaveType { SINE, SQUARE };
-
-void generate_wave(int16_t* buffer, WaveType waveType, int length, int frequency, int& phase) {
-    for (int i = 0; i < length; ++i) {
-        float time = static_cast<float>(phase + i) / SAMPLE_RATE;
-        if (waveType == SINE) {
-            buffer[i] = static_cast<int16_t>(AMPLITUDE * std::sin(2.0f * M_PI * frequency * time));
-        } else if (waveType == SQUARE) {
-            float period = static_cast<float>(SAMPLE_RATE) / frequency;
-            buffer[i] = ((phase + i) % static_cast<int>(period) < (period / 2)) ? AMPLITUDE : -AMPLITUDE;
-        }
-    }
-    phase += length;
+tonegen::ToneParams tone_params(tonegen::WaveType waveType) {
+    tonegen::ToneParams params;
+    params.waveType = waveType;
+    params.frequency = FREQUENCY;
+    return params;
 }
 
-void play_wave(ALuint* buffers, ALuint source, WaveType waveType, int frequency, std::atomic<bool>& playing) {
-    int16_t samples[BUFFER_SIZE];
-    int phase = 0;
-    generate_wave(samples, waveType, BUFFER_SIZE, frequency, phase);
-
-    // Fill buffers with generated samples
-    for (int i = 0; i < NUM_BUFFERS; ++i) {
-        alBufferData(buffers[i], AL_FORMAT_MONO16, samples, sizeof(samples), SAMPLE_RATE);
-        alSourceQueueBuffers(source, 1, &buffers[i]);
+// A steady tone plays from a cached loop the source repeats, so nothing renders while it
+// sounds; anything else streams from the generator
+bool play(tonegen::OpenAlStream& stream, tonegen::ToneGenerator& generator, tonegen::LoopCache& loops,
+          tonegen::WaveType waveType) {
+    const tonegen::ToneParams params = tone_params(waveType);
+    if (std::shared_ptr<const tonegen::ToneLoop> loop = loops.find(params)) {
+        return stream.startLoop(*loop);
     }
+    stream.stop();
+    generator.setParams(params);
+    generator.reset();
+    return stream.start();
+}
 
-    alSourcePlay(source);
-
-    while (playing) {
-        ALint processed = 0;
-        alGetSourcei(source, AL_BUFFERS_PROCESSED, &processed);
-
-        while (processed > 0) {
-            ALuint buffer;
-            alSourceUnqueueBuffers(source, 1, &buffer);
-
-            generate_wave(samples, waveType, BUFFER_SIZE, frequency, phase);
-            alBufferData(buffer, AL_FORMAT_MONO16, samples, sizeof(samples), SAMPLE_RATE);
-
-            alSourceQueueBuffers(source, 1, &buffer);
-            processed--;
-        }
-
-        ALint state;
-        alGetSourcei(source, AL_SOURCE_STATE, &state);
-        if (state != AL_PLAYING) {
-            alSourcePlay(source);
+int main(int argc, char* argv[]) {
+    // --realtime[=CPU] runs the streaming thread SCHED_FIFO with locked memory
+    tonegen::RealtimeOptions realtime;
+    for (int i = 1; i < argc; ++i) {
+        if (!tonegen::parse_realtime_option(argv[i], realtime)) {
+            std::cerr << "Unknown argument: " << argv[i] << std::endl;
         }
-
-        std::this_thread::sleep_for(std::chrono::milliseconds(10));
     }
-}
 
-int main(int argc, char* argv[]) {
     // Initialize OpenAL
     ALCdevice* device = alcOpenDevice(nullptr);
     if (!device) {
@@ -74,7 +51,8 @@ int main(int argc, char* argv[]) {
         return 1;
     }
 
-    ALCcontext* context = alcCreateContext(device, nullptr);
+    const std::vector<ALCint> attributes = tonegen::openal_context_attributes(SAMPLE_RATE, BUFFER_SIZE);
+    ALCcontext* context = alcCreateContext(device, attributes.data());
     if (!context) {
         std::cerr << "Failed to create OpenAL context." << std::endl;
         alcCloseDevice(device);
@@ -82,9 +60,12 @@ int main(int argc, char* argv[]) {
     }
     alcMakeContextCurrent(context);
 
-    ALuint buffers[NUM_BUFFERS], source;
-    alGenBuffers(NUM_BUFFERS, buffers);
-    alGenSources(1, &source);
+    // Streams from its own thread, or from the OpenAL mixer, and sleeps until a buffer is due
+    tonegen::ToneGenerator generator(SAMPLE_RATE);
+    std::unique_ptr<tonegen::OpenAlStream> stream(new tonegen::OpenAlStream(generator, BUFFER_SIZE, NUM_BUFFERS));
+    stream->setRealtime(realtime);
+    tonegen::LoopCache loops(SAMPLE_RATE, generator.channels(), stream->sampleFormat());
+    tonegen::WaveType waveType = tonegen::SINE;
 
     // Initialize SDL for keyboard input
     if (SDL_Init(SDL_INIT_VIDEO) < 0) {
@@ -101,9 +82,9 @@ int main(int argc, char* argv[]) {
 
     bool quit = false;
     SDL_Event e;
-    WaveType currentWave = SINE;
-    std::atomic<bool> playing(false);
-    std::thread playbackThread;
+    bool playing = false;
+    bool realtimeReported = !realtime.enabled;
+    Uint32 lastStatus = 0;
 
     while (!quit) {
         while (SDL_PollEvent(&e) != 0) {
@@ -112,44 +93,56 @@ int main(int argc, char* argv[]) {
             } else if (e.type == SDL_KEYDOWN) {
                 switch (e.key.keysym.sym) {
                     case SDLK_s:
-                        currentWave = SINE;
-                        if (!playing) {
-                            playing = true;
-                            playbackThread = std::thread(play_wave, buffers, source, currentWave, FREQUENCY, std::ref(playing));
-                        }
+                        waveType = tonegen::SINE;
+                        playing = play(*stream, generator, loops, waveType);
                         break;
                     case SDLK_q:
-                        currentWave = SQUARE;
-                        if (!playing) {
-                            playing = true;
-                            playbackThread = std::thread(play_wave, buffers, source, currentWave, FREQUENCY, std::ref(playing));
-                        }
+                        waveType = tonegen::SQUARE;
+                        playing = play(*stream, generator, loops, waveType);
                         break;
                     case SDLK_SPACE:
                         if (playing) {
+                            stream->stop();
                             playing = false;
-                            playbackThread.join();
-                            alSourceStop(source);
                         } else {
-                            playing = true;
-                            playbackThread = std::thread(play_wave, buffers, source, currentWave, FREQUENCY, std::ref(playing));
+                            playing = play(*stream, generator, loops, waveType);
                         }
                         break;
                 }
             }
         }
 
+        if (SDL_GetTicks() - lastStatus >= 500) {
+            const tonegen::RealtimeStatus status = stream->realtimeStatus();
+            std::string title = "Tone Generator - ";
+            if (stream->looping()) {
+                title += "looping a cached period";
+            } else {
+                title += "latency " + std::to_string(static_cast<int>(stream->latency().totalSeconds() * 1000)) +
+                         " ms, " + std::to_string(stream->underruns()) + " underruns";
+            }
+            if (status.requested) {
+                title += " - " + tonegen::describe_realtime(status);
+            }
+            SDL_SetWindowTitle(window, title.c_str());
+
+            // Say once on the console if the real-time request was cut short or had no thread to apply to
+            if (playing && !stream->looping() && !realtimeReported) {
+                if (stream->usesCallback()) {
+                    std::cerr << "Rendering on the OpenAL mixer thread; its priority is OpenAL Soft's (rt-prio)" << std::endl;
+                } else if (!status.message.empty()) {
+                    std::cerr << "Real-time setup incomplete: " << status.message << std::endl;
+                }
+                realtimeReported = status.requested || stream->usesCallback();
+            }
+            lastStatus = SDL_GetTicks();
+        }
+
         SDL_Delay(1); // Prevent high CPU usage
     }
 
     // Cleanup
-    if (playing) {
-        playing = false;
-        playbackThread.join();
-    }
-    alSourceStop(source);
-    alDeleteSources(1, &source);
-    alDeleteBuffers(NUM_BUFFERS, buffers);
+    stream.reset(); // Stops playback and frees the source and buffers while the context is current
 
     alcMakeContextCurrent(nullptr);
     alcDestroyContext(context);
@@ -11,79 +11,19 @@
 #include <QLabel>
 #include <QTimer>
 #include <QKeyEvent>
+#include <memory>
+
+#include "tonegen/openal_stream.h"
 
 const int SAMPLE_RATE = 44100;
-const int AMPLITUDE = 32760;
 const int BUFFER_SIZE = 512; // Smaller buffer size for smoother playback
 const int NUM_BUFFERS = 4; // Number of buffers to queue
 
-enum WaveType { SINE, SQUARE };
-
-void generate_wave(int16_t* buffer, WaveType waveType, int length, int frequency, int& phase) {
-    for (int i = 0; i < length; ++i) {
-        float time = static_cast<float>(phase + i) / SAMPLE_RATE;
-        if (waveType == SINE) {
-            buffer[i] = static_cast<int16_t>(AMPLITUDE * std::sin(2.0f * M_PI * frequency * time));
-        } else if (waveType == SQUARE) {
-            float period = static_cast<float>(SAMPLE_RATE) / frequency;
-            buffer[i] = ((phase + i) % static_cast<int>(period) < (period / 2)) ? AMPLITUDE : -AMPLITUDE;
-        }
-    }
-    phase += length;
-}
-
-void play_wave(ALuint* buffers, ALuint source, WaveType waveType, int frequency, int& phase) {
-    int16_t samples[BUFFER_SIZE];
-    generate_wave(samples, waveType, BUFFER_SIZE, frequency, phase);
-
-    // Fill buffers with generated samples
-    for (int i = 0; i < NUM_BUFFERS; ++i) {
-        alBufferData(buffers[i], AL_FORMAT_MONO16, samples, sizeof(samples), SAMPLE_RATE);
-        alSourceQueueBuffers(source, 1, &buffers[i]);
-    }
-
-    alSourcePlay(source);
-}
-
-void update_buffers(ALuint* buffers, ALuint source, WaveType waveType, int frequency, int& phase) {
-    ALint processed = 0;
-    alGetSourcei(source, AL_BUFFERS_PROCESSED, &processed);
-
-    while (processed > 0) {
-        ALuint buffer;
-        alSourceUnqueueBuffers(source, 1, &buffer);
-
-        int16_t samples[BUFFER_SIZE];
-        generate_wave(samples, waveType, BUFFER_SIZE, frequency, phase);
-        alBufferData(buffer, AL_FORMAT_MONO16, samples, sizeof(samples), SAMPLE_RATE);
-
-        alSourceQueueBuffers(source, 1, &buffer);
-        processed--;
-    }
-
-    ALint state;
-    alGetSourcei(source, AL_SOURCE_STATE, &state);
-    if (state != AL_PLAYING) {
-        alSourcePlay(source);
-    }
-}
-
-void stop_wave(ALuint* buffers, ALuint source) {
-    alSourceStop(source);
-    ALint queued;
-    alGetSourcei(source, AL_BUFFERS_QUEUED, &queued);
-
-    while (queued--) {
-        ALuint buffer;
-        alSourceUnqueueBuffers(source, 1, &buffer);
-    }
-}
-
 class ToneGeneratorWidget : public QWidget {
     Q_OBJECT
 
 public:
-    ToneGeneratorWidget(QWidget *parent = nullptr) : QWidget(parent), phase(0), currentWave(SINE), playing(false), frequency(440) {
+    ToneGeneratorWidget(QWidget *parent = nullptr) : QWidget(parent), generator(SAMPLE_RATE), currentWave(tonegen::SINE), playing(false), frequency(440) {
         QVBoxLayout *layout = new QVBoxLayout();
         QLabel *label = new QLabel("Frequency (Hz):");
         frequencyInput = new QLineEdit();
@@ -91,46 +31,52 @@ public:
         QPushButton *sineButton = new QPushButton("Play Sine Wave");
         QPushButton *squareButton = new QPushButton("Play Square Wave");
         QPushButton *stopButton = new QPushButton("Stop");
+        latencyLabel = new QLabel();
 
         layout->addWidget(label);
         layout->addWidget(frequencyInput);
         layout->addWidget(sineButton);
         layout->addWidget(squareButton);
         layout->addWidget(stopButton);
+        layout->addWidget(latencyLabel);
         setLayout(layout);
 
         // Initialize OpenAL
+        // Without a device or context the buttons stay unconnected and the label says why
         device = alcOpenDevice(nullptr);
         if (!device) {
             std::cerr << "Failed to open audio device." << std::endl;
+            latencyLabel->setText("No audio device: OpenAL could not open one");
             return;
         }
 
-        context = alcCreateContext(device, nullptr);
+        // Have the device mix in periods as short as the buffers, or it adds its own 1024 frames
+        const std::vector<ALCint> attributes = tonegen::openal_context_attributes(SAMPLE_RATE, BUFFER_SIZE);
+        context = alcCreateContext(device, attributes.data());
         if (!context) {
             std::cerr << "Failed to create OpenAL context." << std::endl;
+            latencyLabel->setText("No audio: OpenAL could not create a context on the device");
             alcCloseDevice(device);
             return;
         }
         alcMakeContextCurrent(context);
 
-        alGenBuffers(NUM_BUFFERS, buffers);
-        alGenSources(1, &source);
+        stream.reset(new tonegen::OpenAlStream(generator, BUFFER_SIZE, NUM_BUFFERS));
 
         connect(sineButton, &QPushButton::clicked, this, &ToneGeneratorWidget::onSineButtonClicked);
         connect(squareButton, &QPushButton::clicked, this, &ToneGeneratorWidget::onSquareButtonClicked);
         connect(stopButton, &QPushButton::clicked, this, &ToneGeneratorWidget::onStopButtonClicked);
 
-        // Start a timer to update the buffers
-        timer = new QTimer(this);
-        connect(timer, &QTimer::timeout, this, &ToneGeneratorWidget::onTimerTimeout);
-        timer->start(10); // Update every 10 ms
+        QTimer *latencyTimer = new QTimer(this);
+        connect(latencyTimer, &QTimer::timeout, this, &ToneGeneratorWidget::showLatency);
+        latencyTimer->start(250);
     }
 
     ~ToneGeneratorWidget() {
-        stop_wave(buffers, source);
-        alDeleteSources(1, &source);
-        alDeleteBuffers(NUM_BUFFERS, buffers);
+        if (!stream) {
+            return; // OpenAL never came up
+        }
+        stream.reset();
 
         alcMakeContextCurrent(nullptr);
         alcDestroyContext(context);
@@ -141,10 +87,11 @@ protected:
     void keyPressEvent(QKeyEvent *event) override {
         if (event->key() == Qt::Key_Y) {
             frequency = 10000;
-            currentWave = SQUARE;
-            if (!playing) {
-                phase = 0; // Reset phase when starting playback
-                play_wave(buffers, source, currentWave, frequency, phase);
+            currentWave = tonegen::SQUARE;
+            apply_params();
+            if (!playing && stream) {
+                generator.reset(); // Reset phase when starting playback
+                stream->start();
                 playing = true;
             }
         }
@@ -153,54 +100,65 @@ protected:
 
 private slots:
     void onFrequencyChanged(const QString &text) {
-        frequency = text.toInt();
+        frequency = text.toDouble();
     }
 
     void onSineButtonClicked() {
-        frequency = frequencyInput->text().toInt(); // Update frequency when button is clicked
-        currentWave = SINE;
+        frequency = frequencyInput->text().toDouble(); // Update frequency when button is clicked
+        currentWave = tonegen::SINE;
+        apply_params();
         if (!playing) {
-            phase = 0; // Reset phase when starting playback
-            play_wave(buffers, source, currentWave, frequency, phase);
+            generator.reset(); // Reset phase when starting playback
+            stream->start();
             playing = true;
         }
     }
 
     void onSquareButtonClicked() {
-        frequency = frequencyInput->text().toInt(); // Update frequency when button is clicked
-        currentWave = SQUARE;
+        frequency = frequencyInput->text().toDouble(); // Update frequency when button is clicked
+        currentWave = tonegen::SQUARE;
+        apply_params();
         if (!playing) {
-            phase = 0; // Reset phase when starting playback
-            play_wave(buffers, source, currentWave, frequency, phase);
+            generator.reset(); // Reset phase when starting playback
+            stream->start();
             playing = true;
         }
     }
 
     void onStopButtonClicked() {
         if (playing) {
-            stop_wave(buffers, source);
+            stream->stop();
             playing = false;
-            phase = 0; // Reset phase when stopping playback
+            generator.reset(); // Reset phase when stopping playback
         }
     }
 
-    void onTimerTimeout() {
-        if (playing) {
-            update_buffers(buffers, source, currentWave, frequency, phase);
-        }
+    void showLatency() {
+        const tonegen::StreamLatency latency = stream->latency();
+        latencyLabel->setText(QString("Latency %1 ms, %2 underruns")
+                                  .arg(latency.totalSeconds() * 1000, 0, 'f', 1)
+                                  .arg(stream->underruns()));
     }
 
 private:
+    void apply_params() {
+        tonegen::ToneParams params;
+        params.waveType = currentWave;
+        params.frequency = frequency;
+        generator.publishParams(params); // Picked up by the streaming side as it renders
+    }
+
     QLineEdit *frequencyInput;
-    QTimer *timer;
-    int phase;
-    WaveType currentWave;
+    QLabel *latencyLabel;
+    tonegen::ToneGenerator generator;
+    tonegen::WaveType currentWave;
     bool playing;
-    int frequency;
+    double frequency;
 
     ALCdevice *device;
     ALCcontext *context;
-    ALuint buffers[NUM_BUFFERS], source;
+    // Refills OpenAL from its own thread, or from the OpenAL mixer, so GUI stalls can't starve it
+    std::unique_ptr<tonegen::OpenAlStream> stream;
 };
 
 int main(int argc, char* argv[]) {
@@ -8,86 +8,92 @@
 #include <QLineEdit>
 #include <QLabel>
 #include <QTimer>
-#include <QByteArray>
 #include <QIODevice>
 #include <QtMath>
 
+#include "tonegen/convert.h"
+#include "tonegen/tone_generator.h"
+
+// Synthesizes exactly what the sink reads from the generator's running state, so there is no
+// loop seam and memory stays at one block whatever the rate and channel count
 class Generator : public QIODevice {
     Q_OBJECT
 
 public:
-    Generator(const QAudioFormat &format, int sampleRate, bool isSquareWave)
-        : m_format(format), m_sampleRate(sampleRate), m_isSquareWave(isSquareWave) {
-        generateData();
+    Generator(const QAudioFormat &format, double frequency, bool isSquareWave)
+        : m_format(format), m_generator(format.sampleRate(), engineChannelCount(format)) {
+        m_generator.setParams(toneParams(frequency, isSquareWave));
+        m_generator.setDither(true); // Only applies to 8- and 16-bit formats
+    }
+
+    // Safe while the sink reads: the frequency glides and a new waveform crossfades in
+    void setTone(double frequency, bool isSquareWave) {
+        m_generator.publishParams(toneParams(frequency, isSquareWave));
     }
 
     void start() { open(QIODevice::ReadOnly); }
-    void stop() { m_pos = 0; close(); }
+    void stop() { close(); }
+
+    bool isSequential() const override { return true; }
 
 protected:
     qint64 readData(char *data, qint64 len) override {
-        qint64 total = 0;
-        if (!m_buffer.isEmpty()) {
-            while (len - total > 0) {
-                const qint64 chunk = qMin((m_buffer.size() - m_pos), len - total);
-                memcpy(data + total, m_buffer.constData() + m_pos, chunk);
-                m_pos = (m_pos + chunk) % m_buffer.size();
-                total += chunk;
-            }
+        const int channels = m_format.channelCount();
+        const qint64 frameBytes = m_format.bytesPerFrame();
+        const tonegen::SampleFormat format = engineFormat();
+        qint64 frames = len / frameBytes;
+        const qint64 total = frames * frameBytes;
+        if (channels == int(m_generator.channels())) {
+            m_generator.process(data, format, size_t(frames));
+            return total;
+        }
+        // More channels than the engine renders: a mono render copied out to all of them
+        while (frames > 0) {
+            const qint64 chunk = qMin<qint64>(frames, tonegen::MAX_BLOCK_FRAMES);
+            m_generator.process(m_block, size_t(chunk));
+            tonegen::convert_mono_to_interleaved(m_block, data, format, size_t(chunk), channels);
+            data += chunk * frameBytes;
+            frames -= chunk;
         }
         return total;
     }
 
     qint64 writeData(const char *, qint64) override { return 0; }
-    qint64 bytesAvailable() const override { return m_buffer.size() + QIODevice::bytesAvailable(); }
+    // There is always more; a block's worth keeps readers that ask first reading
+    qint64 bytesAvailable() const override {
+        return m_format.bytesForFrames(tonegen::MAX_BLOCK_FRAMES) + QIODevice::bytesAvailable();
+    }
 
 private:
-    void generateData() {
-        const int channelBytes = m_format.bytesPerSample();
-        const int sampleBytes = m_format.channelCount() * channelBytes;
-        const int durationUs = 1000000;  // 1 second
-        qint64 length = m_format.bytesForDuration(durationUs);
-        m_buffer.resize(length);
-        unsigned char *ptr = reinterpret_cast<unsigned char *>(m_buffer.data());
-
-        int sampleIndex = 0;
-        while (length) {
-            qreal x;
-            if (m_isSquareWave) {
-                x = (sampleIndex % (m_format.sampleRate() / m_sampleRate) < (m_format.sampleRate() / m_sampleRate) / 2) ? 1.0 : -1.0;
-            } else {
-                x = qSin(2 * M_PI * m_sampleRate * qreal(sampleIndex++ % m_format.sampleRate()) / m_format.sampleRate());
-            }
-
-            for (int i = 0; i < m_format.channelCount(); ++i) {
-                switch (m_format.sampleFormat()) {
-                case QAudioFormat::UInt8:
-                    *reinterpret_cast<quint8 *>(ptr) = static_cast<quint8>((1.0 + x) / 2 * 255);
-                    break;
-                case QAudioFormat::Int16:
-                    *reinterpret_cast<qint16 *>(ptr) = static_cast<qint16>(x * 32767);
-                    break;
-                case QAudioFormat::Int32:
-                    *reinterpret_cast<qint32 *>(ptr) = static_cast<qint32>(x * std::numeric_limits<qint32>::max());
-                    break;
-                case QAudioFormat::Float:
-                    *reinterpret_cast<float *>(ptr) = x;
-                    break;
-                default:
-                    break;
-                }
-                ptr += channelBytes;
-                length -= channelBytes;
-            }
-            sampleIndex++;
+    static tonegen::ToneParams toneParams(double frequency, bool isSquareWave) {
+        tonegen::ToneParams params;
+        params.waveType = isSquareWave ? tonegen::SQUARE : tonegen::SINE;
+        params.frequency = frequency;
+        params.amplitude = 1.0f;
+        return params;
+    }
+
+    // One engine channel per device channel, or a mono render copied out beyond MAX_CHANNELS
+    static int engineChannelCount(const QAudioFormat &format) {
+        return format.channelCount() <= int(tonegen::MAX_CHANNELS) ? format.channelCount() : 1;
+    }
+
+    tonegen::SampleFormat engineFormat() const {
+        switch (m_format.sampleFormat()) {
+        case QAudioFormat::UInt8:
+            return tonegen::SAMPLE_UINT8;
+        case QAudioFormat::Int32:
+            return tonegen::SAMPLE_INT32;
+        case QAudioFormat::Float:
+            return tonegen::SAMPLE_FLOAT;
+        default:
+            return tonegen::SAMPLE_INT16;
         }
     }
 
-    QByteArray m_buffer;
-    qint64 m_pos = 0;
     QAudioFormat m_format;
-    int m_sampleRate;
-    bool m_isSquareWave;
+    tonegen::ToneGenerator m_generator; // Kept, so a new tone costs no allocations
+    float m_block[tonegen::MAX_BLOCK_FRAMES];
 };
 
 class AudioTest : public QMainWindow {
@@ -113,11 +119,11 @@ private slots:
     }
 
     void waveformChanged(int index) {
-        m_generator.reset(new Generator(m_audioOutput->format(), m_frequencyLineEdit->text().toInt(), index == 1));
+        m_generator->setTone(m_frequencyLineEdit->text().toDouble(), index == 1);
     }
 
     void frequencyChanged() {
-        m_generator.reset(new Generator(m_audioOutput->format(), m_frequencyLineEdit->text().toInt(), m_waveformBox->currentIndex() == 1));
+        m_generator->setTone(m_frequencyLineEdit->text().toDouble(), m_waveformBox->currentIndex() == 1);
     }
 
 private:
@@ -153,7 +159,7 @@ private:
         format.setSampleFormat(QAudioFormat::Int16);
 
         m_audioOutput = std::make_unique<QAudioSink>(format, this);
-        m_generator = std::make_unique<Generator>(format, m_frequencyLineEdit->text().toInt(), m_waveformBox->currentIndex() == 1);
+        m_generator = std::make_unique<Generator>(format, m_frequencyLineEdit->text().toDouble(), m_waveformBox->currentIndex() == 1);
     }
 
     std::unique_ptr<Generator> m_generator;
@@ -9,6 +9,8 @@ SOURCES += main.cpp
 
 HEADERS +=
 
+include(../engine/tonegen.pri)
+
 INCLUDEPATH += /usr/include/AL /Users/macbook2015/Downloads/SDL-release-2.30.6/include
 
 LIBS += -L/Users/macbook2015/Downloads/SDL-release-2.30.6/build
@@ -1,39 +1,36 @@
 #include <QApplication>
+#include <QLabel>
 #include <QPushButton>
+#include <QSpinBox>
+#include <QTimer>
 #include <QVBoxLayout>
 #include <QWidget>
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_mixer.h>
 #include <iostream>
 
+#include "tonegen/render_thread.h"
+
 const int SAMPLE_RATE = 44100;
 const int FREQUENCY = 440;
-const int AMPLITUDE = 32760;
 const int BUFFER_SIZE = 4096; // Larger buffer size for smoother playback
+const int RENDER_AHEAD_MS = 200; // How far the producer thread renders ahead of the device
+const int MAX_RENDER_AHEAD_MS = 2000;
 
-enum WaveType { SINE, SQUARE };
-
-int phase = 0;
-WaveType currentWave = SINE;
+// Touched by the GUI thread only; the audio thread sees nothing but the ring
 bool playing = false;
+tonegen::ToneParams params;
 
-void generate_wave(int16_t* buffer, int length, int frequency, WaveType waveType, int& phase) {
-    for (int i = 0; i < length; ++i) {
-        float time = static_cast<float>(phase + i) / SAMPLE_RATE;
-        if (waveType == SINE) {
-            buffer[i] = static_cast<int16_t>(AMPLITUDE * std::sin(2.0f * M_PI * frequency * time));
-        } else if (waveType == SQUARE) {
-            float period = static_cast<float>(SAMPLE_RATE) / frequency;
-            buffer[i] = ((phase + i) % static_cast<int>(period) < (period / 2)) ? AMPLITUDE : -AMPLITUDE;
-        }
-    }
-    phase += length;
+void audio_callback(void* userdata, Uint8* stream, int len) {
+    // Synthesis runs on the producer thread, so this only copies out what it rendered
+    tonegen::RenderThread* render = static_cast<tonegen::RenderThread*>(userdata);
+    render->read(stream, len / render->frameBytes());
 }
 
-void audio_callback(void* userdata, Uint8* stream, int len) {
-    int16_t* buffer = reinterpret_cast<int16_t*>(stream);
-    int length = len / 2; // len is in bytes, we need the number of samples
-    generate_wave(buffer, length, FREQUENCY, currentWave, phase);
+void set_wave(tonegen::ToneGenerator& generator, tonegen::WaveType waveType) {
+    params.waveType = waveType;
+    params.frequency = FREQUENCY;
+    generator.publishParams(params);
 }
 
 void start_audio() {
@@ -53,6 +50,14 @@ void stop_audio() {
 int main(int argc, char *argv[]) {
     QApplication app(argc, argv);
 
+    // --realtime[=CPU] runs the producer thread SCHED_FIFO with locked memory
+    tonegen::RealtimeOptions realtime;
+    for (int i = 1; i < argc; ++i) {
+        if (!tonegen::parse_realtime_option(argv[i], realtime)) {
+            std::cerr << "Unknown argument: " << argv[i] << std::endl;
+        }
+    }
+
     // Initialize SDL
     if (SDL_Init(SDL_INIT_AUDIO) < 0) {
         std::cerr << "Failed to initialize SDL: " << SDL_GetError() << std::endl;
@@ -69,7 +74,15 @@ int main(int argc, char *argv[]) {
     Mix_AllocateChannels(1);
     Mix_ChannelFinished(nullptr);
 
-    // Register the audio callback
+    // The producer thread owns the generator from here on; the callback reads its ring
+    tonegen::ToneGenerator generator(SAMPLE_RATE);
+    params.frequency = FREQUENCY;
+    generator.setParams(params);
+    tonegen::RenderThread render(generator, tonegen::SAMPLE_INT16, RENDER_AHEAD_MS * SAMPLE_RATE / 1000,
+                                 MAX_RENDER_AHEAD_MS * SAMPLE_RATE / 1000);
+    render.setRealtime(realtime);
+    render.start();
+
     SDL_AudioSpec desiredSpec;
     SDL_zero(desiredSpec);
     desiredSpec.freq = SAMPLE_RATE;
@@ -77,6 +90,7 @@ int main(int argc, char *argv[]) {
     desiredSpec.channels = 1;
     desiredSpec.samples = BUFFER_SIZE;
     desiredSpec.callback = audio_callback;
+    desiredSpec.userdata = &render;
 
     if (SDL_OpenAudio(&desiredSpec, nullptr) < 0) {
         std::cerr << "Failed to open audio: " << SDL_GetError() << std::endl;
@@ -95,17 +109,26 @@ int main(int argc, char *argv[]) {
     QPushButton *squareButton = new QPushButton("Play Square Wave");
     QPushButton *stopButton = new QPushButton("Stop");
 
+    QSpinBox *aheadBox = new QSpinBox();
+    aheadBox->setRange(1, MAX_RENDER_AHEAD_MS);
+    aheadBox->setSuffix(" ms");
+    aheadBox->setValue(RENDER_AHEAD_MS);
+    QLabel *statusLabel = new QLabel();
+
     layout->addWidget(sineButton);
     layout->addWidget(squareButton);
     layout->addWidget(stopButton);
+    layout->addWidget(new QLabel("Render ahead:"));
+    layout->addWidget(aheadBox);
+    layout->addWidget(statusLabel);
 
-    QObject::connect(sineButton, &QPushButton::clicked, []() {
-        currentWave = SINE;
+    QObject::connect(sineButton, &QPushButton::clicked, [&generator]() {
+        set_wave(generator, tonegen::SINE);
         start_audio();
     });
 
-    QObject::connect(squareButton, &QPushButton::clicked, []() {
-        currentWave = SQUARE;
+    QObject::connect(squareButton, &QPushButton::clicked, [&generator]() {
+        set_wave(generator, tonegen::SQUARE);
         start_audio();
     });
 
@@ -113,6 +136,28 @@ int main(int argc, char *argv[]) {
         stop_audio();
     });
 
+    QObject::connect(aheadBox, QOverload<int>::of(&QSpinBox::valueChanged), [&render](int ms) {
+        render.setRenderAhead(ms * SAMPLE_RATE / 1000);
+    });
+
+    // Ring occupancy as the audio callback sees it, and the latency of a change: the ring
+    // and then the device buffer play out before it is heard
+    QTimer statusTimer;
+    const int deviceFrames = desiredSpec.samples; // SDL_OpenAudio filled in the size it got
+    QObject::connect(&statusTimer, &QTimer::timeout, [&render, statusLabel, deviceFrames]() {
+        const tonegen::RenderStatus status = render.status();
+        // The real-time line includes what was denied, if the request was cut short
+        const std::string realtime = tonegen::describe_realtime(render.realtimeStatus());
+        statusLabel->setText(QString("Latency %1 ms; buffered %2 ms (low %3 ms) of %4 ms, %5 underruns%6")
+                                 .arg((status.bufferedFrames + deviceFrames) * 1000 / SAMPLE_RATE)
+                                 .arg(status.bufferedFrames * 1000 / SAMPLE_RATE)
+                                 .arg(status.lowestFrames * 1000 / SAMPLE_RATE)
+                                 .arg(status.aheadFrames * 1000 / SAMPLE_RATE)
+                                 .arg(status.underruns)
+                                 .arg(realtime.empty() ? QString() : "\n" + QString::fromStdString(realtime)));
+    });
+    statusTimer.start(250);
+
     window.setLayout(layout);
     window.show();
 
@@ -120,6 +165,7 @@ int main(int argc, char *argv[]) {
 
     // Cleanup
     stop_audio();
+    render.stop();
     Mix_CloseAudio();
     SDL_Quit();
 
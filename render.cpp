@@ -0,0 +1,255 @@
+#include <iostream>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "tonegen/file_sink.h"
+#include "tonegen/offline_render.h"
+
+// Renders presets straight to disk, with no window or audio device, as fast as the cores allow.
+//   tone_render [options] key=value ...    one preset
+//   tone_render [options] --list FILE      one preset per line, # for comments
+// Keys: out=FILE (.wav, which turns RF64 past 4 GB, .rf64, .w64, or .raw for headerless PCM),
+// wave=sine|square|saw|triangle|pulse|binaural|white|pink|brown|blue|violet, freq, beat, amp,
+// width, phase, seed, seconds, rate, channels, format=u8|s16|s32|f32, dither=0|1
+// Options: --threads N (default one per core), --chunk-seconds S, --scaling to time the first
+// preset again on 1, 2, 4 ... threads
+
+struct Preset {
+    tonegen::OfflineJob job;
+    std::string out;
+    double seconds = 10;
+};
+
+bool parse_wave(const std::string& name, tonegen::WaveType& wave) {
+    static const struct {
+        const char* name;
+        tonegen::WaveType wave;
+    } WAVES[] = {{"sine", tonegen::SINE},         {"square", tonegen::SQUARE},   {"saw", tonegen::SAW},
+                 {"triangle", tonegen::TRIANGLE}, {"pulse", tonegen::PULSE},     {"binaural", tonegen::BINAURAL_BEATS},
+                 {"white", tonegen::WHITE_NOISE}, {"pink", tonegen::PINK_NOISE}, {"brown", tonegen::BROWN_NOISE},
+                 {"blue", tonegen::BLUE_NOISE},   {"violet", tonegen::VIOLET_NOISE}};
+    for (const auto& entry : WAVES) {
+        if (name == entry.name) {
+            wave = entry.wave;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool parse_format(const std::string& name, tonegen::SampleFormat& format) {
+    const char* NAMES[tonegen::SAMPLE_FORMAT_COUNT] = {"u8", "s16", "s32", "f32"};
+    for (int f = 0; f < tonegen::SAMPLE_FORMAT_COUNT; ++f) {
+        if (name == NAMES[f]) {
+            format = static_cast<tonegen::SampleFormat>(f);
+            return true;
+        }
+    }
+    return false;
+}
+
+// Fills preset from one key=value; error says what was wrong
+bool parse_setting(const std::string& setting, Preset& preset, std::string& error) {
+    const size_t equals = setting.find('=');
+    if (equals == std::string::npos) {
+        error = "expected key=value, got \"" + setting + "\"";
+        return false;
+    }
+    const std::string key = setting.substr(0, equals);
+    const std::string value = setting.substr(equals + 1);
+    tonegen::OfflineJob& job = preset.job;
+    const double number = std::atof(value.c_str());
+    if (key == "out") {
+        preset.out = value;
+    } else if (key == "wave") {
+        if (!parse_wave(value, job.params.waveType)) {
+            error = "unknown wave \"" + value + "\"";
+            return false;
+        }
+    } else if (key == "format") {
+        if (!parse_format(value, job.format)) {
+            error = "unknown format \"" + value + "\"";
+            return false;
+        }
+    } else if (key == "freq") {
+        job.params.frequency = number;
+    } else if (key == "beat") {
+        job.params.beatFrequency = number;
+    } else if (key == "amp") {
+        job.params.amplitude = static_cast<float>(number);
+    } else if (key == "width") {
+        job.params.pulseWidth = static_cast<float>(number);
+    } else if (key == "phase") {
+        job.params.channelPhase = number;
+    } else if (key == "seed") {
+        job.params.noiseSeed = std::strtoull(value.c_str(), nullptr, 10);
+    } else if (key == "seconds") {
+        preset.seconds = number;
+    } else if (key == "rate") {
+        job.sampleRate = std::atoi(value.c_str());
+    } else if (key == "channels") {
+        job.channels = static_cast<size_t>(std::atoi(value.c_str()));
+    } else if (key == "dither") {
+        job.dither = number != 0;
+    } else {
+        error = "unknown key \"" + key + "\"";
+        return false;
+    }
+    return true;
+}
+
+bool finish_preset(Preset& preset, std::string& error) {
+    tonegen::OfflineJob& job = preset.job;
+    if (preset.out.empty()) {
+        error = "no out=FILE";
+    } else if (job.sampleRate <= 0) {
+        error = "bad rate";
+    } else if (job.channels < 1 || job.channels > tonegen::MAX_CHANNELS) {
+        error = "channels must be 1 to " + std::to_string(tonegen::MAX_CHANNELS);
+    } else if (!(preset.seconds > 0)) {
+        error = "seconds must be positive";
+    } else {
+        job.frames = static_cast<uint64_t>(std::llround(preset.seconds * job.sampleRate));
+        return true;
+    }
+    return false;
+}
+
+void write_chunk(void* user, uint64_t frame, const void* data, size_t frames) {
+    static_cast<tonegen::FileSink*>(user)->writeAt(frame, data, frames);
+}
+
+bool render(const Preset& preset, size_t threads, size_t chunkFrames, tonegen::OfflineStats& stats,
+            tonegen::FileSinkStats& written) {
+    const tonegen::OfflineJob& job = preset.job;
+    tonegen::FileSink sink;
+    if (!sink.open(preset.out, tonegen::file_type_for(preset.out), job.sampleRate, job.channels, job.format)) {
+        std::cerr << sink.error() << std::endl;
+        return false;
+    }
+    stats = tonegen::render_offline(job, threads, chunkFrames, write_chunk, &sink);
+    if (!sink.close()) {
+        std::cerr << sink.error() << std::endl;
+        return false;
+    }
+    written = sink.stats();
+    return true;
+}
+
+void report(const Preset& preset, const tonegen::OfflineStats& stats, const tonegen::FileSinkStats& written) {
+    const double rtf = stats.realTimeFactor(preset.job.sampleRate);
+    const double megabytes = static_cast<double>(written.bytes) / 1e6;
+    std::printf("%s: %.1f s of audio in %.2f s, %.0fx real time on %zu threads (%.0fx per thread), "
+                "%zu chunks, workers %.0f%% busy rendering; %.0f MB written at %.0f MB/s, "
+                "workers waited %.2f s for the disk\n",
+                preset.out.c_str(), preset.seconds, stats.wallSeconds, rtf, stats.threads,
+                rtf / static_cast<double>(stats.threads), stats.chunks,
+                100 * stats.busySeconds / (stats.wallSeconds * static_cast<double>(stats.threads)), megabytes,
+                written.writeSeconds > 0 ? megabytes / written.writeSeconds : 0.0, written.waitSeconds);
+}
+
+int main(int argc, char* argv[]) {
+    size_t threads = std::max(std::thread::hardware_concurrency(), 1u);
+    double chunkSeconds = tonegen::OFFLINE_CHUNK_SECONDS;
+    bool scaling = false;
+    std::vector<Preset> presets;
+    Preset single;
+    bool hasSingle = false;
+    std::string error;
+
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--threads" && i + 1 < argc) {
+            threads = static_cast<size_t>(std::max(std::atoi(argv[++i]), 1));
+        } else if (arg == "--chunk-seconds" && i + 1 < argc) {
+            chunkSeconds = std::atof(argv[++i]);
+        } else if (arg == "--scaling") {
+            scaling = true;
+        } else if (arg == "--list" && i + 1 < argc) {
+            std::ifstream list(argv[++i]);
+            if (!list) {
+                std::cerr << "Can't read " << argv[i] << std::endl;
+                return 1;
+            }
+            std::string line;
+            for (int number = 1; std::getline(list, line); ++number) {
+                const size_t hash = line.find('#');
+                std::istringstream settings(line.substr(0, hash));
+                Preset preset;
+                // Blank and comment-only lines have no settings; any other line is one preset
+                std::string lineError;
+                bool any = false;
+                bool parsed = true;
+                for (std::string setting; parsed && settings >> setting;) {
+                    any = true;
+                    parsed = parse_setting(setting, preset, lineError);
+                }
+                if (!parsed || (any && !finish_preset(preset, lineError))) {
+                    std::cerr << argv[i] << ":" << number << ": " << lineError << std::endl;
+                    return 1;
+                }
+                if (any) {
+                    presets.push_back(preset);
+                }
+            }
+        } else if (parse_setting(arg, single, error)) {
+            hasSingle = true;
+        } else {
+            std::cerr << error << std::endl;
+            return 1;
+        }
+    }
+    if (hasSingle) {
+        if (!finish_preset(single, error)) {
+            std::cerr << error << std::endl;
+            return 1;
+        }
+        presets.insert(presets.begin(), single);
+    }
+    if (presets.empty()) {
+        std::cerr << "Usage: " << argv[0] << " [--threads N] [--chunk-seconds S] [--scaling] "
+                  << "(key=value ... | --list FILE)" << std::endl;
+        return 1;
+    }
+
+    bool ok = true;
+    for (const Preset& preset : presets) {
+        const size_t chunkFrames = static_cast<size_t>(std::max(chunkSeconds * preset.job.sampleRate, 1.0));
+        tonegen::OfflineStats stats;
+        tonegen::FileSinkStats written;
+        if (render(preset, threads, chunkFrames, stats, written)) {
+            report(preset, stats, written);
+        } else {
+            ok = false;
+        }
+    }
+
+    if (scaling) {
+        // Same preset on more and more threads: speedup against one thread, and efficiency per core
+        const Preset& preset = presets.front();
+        const size_t chunkFrames = static_cast<size_t>(std::max(chunkSeconds * preset.job.sampleRate, 1.0));
+        double baseline = 0;
+        for (size_t count = 1;; count = std::min(count * 2, threads)) {
+            tonegen::OfflineStats stats;
+            tonegen::FileSinkStats written;
+            if (!render(preset, count, chunkFrames, stats, written)) {
+                return 1;
+            }
+            const double rtf = stats.realTimeFactor(preset.job.sampleRate);
+            baseline = count == 1 ? rtf : baseline;
+            std::printf("scaling: %2zu threads %8.0fx real time, speedup %5.2f, efficiency %3.0f%%\n", count, rtf,
+                        rtf / baseline, 100 * rtf / baseline / static_cast<double>(count));
+            if (count == threads) {
+                break;
+            }
+        }
+    }
+    return ok ? 0 : 1;
+}